@@ -121,6 +121,9 @@ void setupWorld(int argc, const char** args) {
 	Log::info("Initializing world");
 
 	world.addExternalForce(new DirectionalGravity(Vec3(0, -10.0, 0.0)));
+	world.sleepSettings.ticksUntilSleep = 50;
+	world.boundsMarginSettings.margin = 0.05;
+	world.structureImprovementBudget = 128;
 
 	PartProperties basicProperties{1.0, 0.7, 0.3};
 
@@ -160,7 +163,7 @@ void setupWorld(int argc, const char** args) {
 
 		world.addPart(sateliteBody);
 
-		sateliteBody->parent->mainPhysical->motionOfCenterOfMass.rotation.rotation[0] = Vec3(0, 2, 0);
+		sateliteBody->parent->mainPhysical->setAngularVelocityOfCenterOfMass(Vec3(0, 2, 0));
 	}
 
 
@@ -376,7 +379,7 @@ void setupWorld(int argc, const char** args) {
 
 		world.addPart(mainBlock);
 
-		mainBlock->parent->mainPhysical->motionOfCenterOfMass.rotation.rotation[0] = Vec3(0, 2, 0);
+		mainBlock->parent->mainPhysical->setAngularVelocityOfCenterOfMass(Vec3(0, 2, 0));
 	}
 
 	{
@@ -409,6 +412,8 @@ void setupWorld(int argc, const char** args) {
 	Vec2f arrowPoints[]{{0.3f,0.1f},{0.3f,0.04f},{1.0f,0.04f}};
 	Shape arrorShape = polyhedronShape(Library::createRevolvedShape(0.0f, arrowPoints, 3, 1.0f, 40));
 	world.addPart(new ExtendedPart(arrorShape, Position(-7.0, 3.0, 0.0), basicProperties));
+
+	world.optimizeObjectTrees();
 }
 
 void setupPhysics() {
@@ -537,7 +542,7 @@ void toggleFlying() {
 			screen.camera.flying = false;
 			screen.camera.attachment->setCFrame(GlobalCFrame(screen.camera.cframe.getPosition()));
 			screen.world->addPart(screen.camera.attachment);
-			screen.camera.attachment->parent->mainPhysical->momentResponse = SymmetricMat3::ZEROS();
+			screen.camera.attachment->parent->mainPhysical->setMomentResponse(SymmetricMat3::ZEROS());
 		} else {
 			screen.world->removePart(screen.camera.attachment);
 			screen.camera.flying = true;
@@ -75,6 +75,9 @@ void DebugOverlay::onRender() {
 	//addDebugField(screen->dimension, GUI::font, "Intersections", getTheoreticalNumberOfIntersections(objectCount), "");
 	addDebugField(screen->dimension, GUI::font, "AVG Collide GJK Iterations", gjkCollideIterStats.avg(), "");
 	addDebugField(screen->dimension, GUI::font, "AVG No Collide GJK Iterations", gjkNoCollideIterStats.avg(), "");
+	ParallelArray<long long, 2> sleepTransitions = sleepStatistics.history.avg();
+	addDebugField(screen->dimension, GUI::font, "Fell asleep", sleepTransitions[static_cast<size_t>(SleepTransition::FELL_ASLEEP)], " per tick");
+	addDebugField(screen->dimension, GUI::font, "Woke up", sleepTransitions[static_cast<size_t>(SleepTransition::WOKE_UP)], " per tick");
 	addDebugField(screen->dimension, GUI::font, "TPS", physicsMeasure.getAvgTPS(), "");
 	addDebugField(screen->dimension, GUI::font, "FPS", Graphics::graphicsMeasure.getAvgTPS(), "");
 	/*addDebugField(screen->dimension, GUI::font, "World Kinetic Energy", screen->world->getTotalKineticEnergy(), "");
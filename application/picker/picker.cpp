@@ -23,7 +23,6 @@
 #include "../physics/physical.h"
 #include "../physics/sharedLockGuard.h"
 #include "../physics/geometry/shape.h"
-#include "../physics/misc/filters/rayIntersectsBoundsFilter.h"
 
 namespace P3D::Application {
 
@@ -74,11 +73,11 @@ void intersectPhysicals(Screen& screen, const Ray& ray) {
 	//TODO graphicsMeasure.mark(GraphicsProcess::WAIT_FOR_LOCK);
 	screen.world->syncReadOnlyOperation([&screen, &closestIntersectDistance, &closestIntersectedPart, &closestIntersectedPoint, &ray] () {
 		//TODO graphicsMeasure.mark(GraphicsProcess::PICKER);
-		for (ExtendedPart& part : screen.world->iterPartsFiltered(RayIntersectBoundsFilter(ray), FREE_PARTS)) {
-			if (&part == screen.camera.attachment) continue;
+		screen.world->forEachPartOnRay(ray, [&](ExtendedPart& part) {
+			if (&part == screen.camera.attachment) return;
 			Vec3 relPos = part.getPosition() - ray.start;
 			if (pointToLineDistanceSquared(ray.direction, relPos) > part.maxRadius* part.maxRadius)
-				continue;
+				return;
 
 			double distance = intersect(ray, part.hitbox, part.getCFrame());
 
@@ -86,7 +85,7 @@ void intersectPhysicals(Screen& screen, const Ray& ray) {
 				closestIntersectDistance = distance;
 				closestIntersectedPart = &part;
 			}
-		}
+		}, FREE_PARTS);
 		});
 
 	if (closestIntersectDistance == INFINITY) {
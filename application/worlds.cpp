@@ -40,7 +40,7 @@ void PlayerWorld::applyExternalForces() {
 		Vec3 force = selectedPhysical->totalMass * (delta * PICKER_STRENGTH - relativeSelectedPointSpeed * PICKER_SPEED_STRENGTH);
 		
 		selectedPhysical->applyForceToPhysical(absoluteSelectedPoint - centerOfmass, force);
-		selectedPhysical->motionOfCenterOfMass.rotation.rotation[0] *= 0.8;
+		selectedPhysical->setAngularVelocityOfCenterOfMass(selectedPhysical->getAngularVelocityOfCenterOfMass() * 0.8);
 	}
 
 	// Player movement
@@ -7,10 +7,14 @@
 #include "../physics/math/linalg/trigonometry.h"
 
 class ManyCubesBenchmark : public WorldBenchmark {
+	ContactSolverType contactSolverType;
+	double deltaT;
 public:
-	ManyCubesBenchmark() : WorldBenchmark("manyCubes", 10000) {}
+	ManyCubesBenchmark(const char* name, int tickCount, ContactSolverType contactSolverType, double deltaT) : WorldBenchmark(name, tickCount), contactSolverType(contactSolverType), deltaT(deltaT) {}
 
 	void init() {
+		world.contactSolverSettings.type = contactSolverType;
+		world.deltaT = deltaT;
 		createFloor(50, 50, 10);
 
 		int minX = -5;
@@ -34,4 +38,8 @@ public:
 			}
 		}
 	}
-} manyCubesBench;
+};
+
+ManyCubesBenchmark manyCubesBench("manyCubes", 10000, ContactSolverType::PENALTY, 0.005);
+// the same 50 simulated seconds, at the larger deltaT the sequential impulse solver allows
+ManyCubesBenchmark manyCubesSequentialImpulseBench("manyCubesSequentialImpulse", 2500, ContactSolverType::SEQUENTIAL_IMPULSE, 0.02);
@@ -0,0 +1,45 @@
+#include "benchmark.h"
+
+#include "../physics/geometry/builtinShapeClasses.h"
+#include "../physics/misc/shapeLibrary.h"
+#include "../util/log.h"
+
+#include <climits>
+#include <cmath>
+
+/*
+	Compares the SIMD scan over all vertices of a polyhedron against hill climbing over its vertex adjacency
+	The direction turns a little with every query and every query starts from the vertex found by the previous one, like GJK tests of a pair from one tick to the next
+*/
+class SupportMappingBenchmark : public Benchmark {
+	int sphereSteps;
+	bool useHillClimbing;
+	PolyhedronShapeClass* shapeClass = nullptr;
+	Vec3f checksum = Vec3f(0.0f, 0.0f, 0.0f);
+
+public:
+	SupportMappingBenchmark(const char* name, int sphereSteps, bool useHillClimbing) : Benchmark(name), sphereSteps(sphereSteps), useHillClimbing(useHillClimbing) {}
+	~SupportMappingBenchmark() { delete shapeClass; }
+
+	void init() override {
+		shapeClass = new PolyhedronShapeClass(Library::createSphere(1.0f, sphereSteps), useHillClimbing ? 0 : INT_MAX);
+	}
+	void run() override {
+		int vertexHint = -1;
+		for(int i = 0; i < 5000000; i++) {
+			float t = i * 0.001f;
+			Vec3f direction(std::cos(t) * std::cos(0.3f * t), std::sin(t) * std::cos(0.3f * t), std::sin(0.3f * t));
+			checksum += shapeClass->furthestInDirectionFrom(direction, vertexHint);
+		}
+	}
+	void printResults(double timeTaken) override {
+		Log::print("%d vertices, %.2fns per query, checksum %f\n", shapeClass->asPolyhedron().vertexCount, timeTaken * 1000000.0 / 5000000, double(checksum.x + checksum.y + checksum.z));
+	}
+};
+
+SupportMappingBenchmark supportScanSmall("supportScanSmall", 1, false);
+SupportMappingBenchmark supportHillClimbSmall("supportHillClimbSmall", 1, true);
+SupportMappingBenchmark supportScanMedium("supportScanMedium", 2, false);
+SupportMappingBenchmark supportHillClimbMedium("supportHillClimbMedium", 2, true);
+SupportMappingBenchmark supportScanLarge("supportScanLarge", 4, false);
+SupportMappingBenchmark supportHillClimbLarge("supportHillClimbLarge", 4, true);
@@ -0,0 +1,98 @@
+#include "benchmark.h"
+
+#include "../physics/datastructures/boundsTree.h"
+#include "../util/log.h"
+
+#include <vector>
+#include <random>
+
+/*
+	Compares trees built by adding objects one by one and improving the structure, like optimizeTerrain used to do,
+	against trees built top down with buildTreeTopDown, and against the compiled form of the latter.
+	Initialization time is the build time, runtime is the time spent on box queries
+*/
+class TreeQueryBenchmark : public Benchmark {
+	struct BenchmarkObject {
+		Bounds bounds;
+	};
+
+	bool buildTopDown;
+	bool useCompiled;
+	std::vector<BenchmarkObject> objects;
+	std::vector<Bounds> queries;
+	BoundsTree<BenchmarkObject> tree;
+	size_t nodesVisited = 0;
+	size_t objectsFound = 0;
+
+	void query(const TreeNode& node, const Bounds& box) {
+		nodesVisited++;
+		if(!intersects(node.bounds, box)) return;
+		if(node.isLeafNode()) {
+			objectsFound++;
+		} else {
+			for(const TreeNode& subNode : node) {
+				query(subNode, box);
+			}
+		}
+	}
+
+public:
+	TreeQueryBenchmark(const char* name, bool buildTopDown, bool useCompiled) : Benchmark(name), buildTopDown(buildTopDown), useCompiled(useCompiled) {}
+
+	void init() override {
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<double> position(-200.0, 200.0);
+		std::uniform_real_distribution<double> size(0.2, 3.0);
+		auto randomBounds = [&]() {
+			Position p(position(random), position(random) * 0.1, position(random));
+			return Bounds(p, p + Vec3(size(random), size(random), size(random)));
+		};
+
+		objects.resize(20000);
+		for(BenchmarkObject& obj : objects) {
+			obj.bounds = randomBounds();
+		}
+		queries.resize(100000);
+		for(Bounds& q : queries) {
+			q = randomBounds();
+		}
+
+		for(BenchmarkObject& obj : objects) {
+			tree.add(&obj, obj.bounds);
+		}
+		if(buildTopDown) {
+			tree.rebuild();
+		} else {
+			for(int i = 0; i < 5; i++) {
+				tree.improveStructure();
+			}
+		}
+		if(useCompiled) {
+			tree.compile();
+		}
+	}
+	void run() override {
+		if(useCompiled) {
+			for(const Bounds& q : queries) {
+				tree.compiled.forEachInBounds(q, [this](void* obj) {objectsFound++; });
+			}
+		} else {
+			for(const Bounds& q : queries) {
+				query(tree.rootNode, q);
+			}
+		}
+	}
+	void printResults(double timeTaken) override {
+		TreeNodePoolStatistics poolStatistics = tree.getNodePoolStatistics();
+		Log::print("%d node blocks allocated from %d slabs, %d in use\n", int(poolStatistics.blocksAllocated), int(poolStatistics.slabsAllocated), int(poolStatistics.getBlocksInUse()));
+		if(useCompiled) {
+			Log::print("%d objects found\n", int(objectsFound));
+			return;
+		}
+		Log::print("%.2f nodes visited per query, %d objects found, tree height %d\n", double(nodesVisited) / queries.size(), int(objectsFound), int(tree.rootNode.getLengthOfLongestBranch()));
+	}
+};
+
+TreeQueryBenchmark incrementalTreeQueries("incrementalTreeQueries", false, false);
+TreeQueryBenchmark topDownTreeQueries("topDownTreeQueries", true, false);
+TreeQueryBenchmark compiledTreeQueries("compiledTreeQueries", true, true);
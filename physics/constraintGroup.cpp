@@ -6,6 +6,10 @@
 
 #include "math/mathUtil.h"
 #include <fstream>
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+#include <optional>
 
 
 void ConstraintGroup::add(Physical* first, Physical* second, BallConstraint* constraint) {
@@ -13,18 +17,114 @@ void ConstraintGroup::add(Physical* first, Physical* second, BallConstraint* con
 }
 void BallConstraint::doNothing() {}
 
-LargeMatrix<double> computeInteractionMatrix(const ConstraintGroup& group) {
-	const std::vector<PhysicalConstraint>& constraints = group.constraints;
+/*
+	Union-find over indices, every set is represented by its lowest index
+*/
+struct DisjointSets {
+	std::vector<size_t> parents;
 
-	size_t dimension = constraints.size() * 3;
-	LargeMatrix<double> systemToSolve(dimension, dimension);
-	for (size_t i = 0; i < dimension; i++) {
-		for (size_t j = 0; j < dimension; j++) {
-			systemToSolve.get(i, j) = 0.0;
+	DisjointSets(size_t size) : parents(size) {
+		for(size_t i = 0; i < size; i++) {
+			parents[i] = i;
+		}
+	}
+
+	size_t find(size_t index) {
+		while(parents[index] != index) {
+			parents[index] = parents[parents[index]];
+			index = parents[index];
+		}
+		return index;
+	}
+
+	void unite(size_t a, size_t b) {
+		a = find(a);
+		b = find(b);
+		if(a < b) {
+			parents[b] = a;
+		} else if(b < a) {
+			parents[a] = b;
+		}
+	}
+};
+
+/*
+	Unites the given set with the first set that touched physical before
+*/
+static void uniteOnPhysical(DisjointSets& sets, std::unordered_map<const MotorizedPhysical*, size_t>& firstSetOf, const MotorizedPhysical* physical, size_t set) {
+	auto found = firstSetOf.emplace(physical, set);
+	if(!found.second) {
+		sets.unite(found.first->second, set);
+	}
+}
+
+/*
+	Sorts the given items into the sets they belong to, sets are ordered by their lowest index
+*/
+template<typename T, typename Item>
+static std::vector<T> collectSets(DisjointSets& sets, size_t itemCount, const Item& addItem) {
+	std::vector<T> result;
+	std::vector<size_t> resultIndexOfSet(itemCount, std::numeric_limits<size_t>::max());
+	for(size_t i = 0; i < itemCount; i++) {
+		size_t set = sets.find(i);
+		if(resultIndexOfSet[set] == std::numeric_limits<size_t>::max()) {
+			resultIndexOfSet[set] = result.size();
+			result.emplace_back();
+		}
+		addItem(result[resultIndexOfSet[set]], i);
+	}
+	return result;
+}
+
+std::vector<ConstraintGroup> ConstraintGroup::splitIntoIslands() const {
+	if(constraints.size() <= 1) {
+		return std::vector<ConstraintGroup>{*this};
+	}
+
+	DisjointSets sets(constraints.size());
+	std::unordered_map<const MotorizedPhysical*, size_t> firstConstraintOf;
+	for(size_t i = 0; i < constraints.size(); i++) {
+		uniteOnPhysical(sets, firstConstraintOf, constraints[i].physA->mainPhysical, i);
+		uniteOnPhysical(sets, firstConstraintOf, constraints[i].physB->mainPhysical, i);
+	}
+
+	return collectSets<ConstraintGroup>(sets, constraints.size(), [this](ConstraintGroup& island, size_t i) {
+		island.constraints.push_back(constraints[i]);
+	});
+}
+
+std::vector<std::vector<ConstraintGroup>> findIndependentConstraintBatches(const std::vector<ConstraintGroup>& groups) {
+	std::vector<ConstraintGroup> islands;
+	for(const ConstraintGroup& group : groups) {
+		std::vector<ConstraintGroup> groupIslands = group.splitIntoIslands();
+		for(ConstraintGroup& island : groupIslands) {
+			islands.push_back(std::move(island));
+		}
+	}
+
+	DisjointSets sets(islands.size());
+	std::unordered_map<const MotorizedPhysical*, size_t> firstIslandOf;
+	for(size_t i = 0; i < islands.size(); i++) {
+		for(const PhysicalConstraint& pc : islands[i].constraints) {
+			uniteOnPhysical(sets, firstIslandOf, pc.physA->mainPhysical, i);
+			uniteOnPhysical(sets, firstIslandOf, pc.physB->mainPhysical, i);
 		}
 	}
 
-	size_t matrixIndex = 0;
+	return collectSets<std::vector<ConstraintGroup>>(sets, islands.size(), [&islands](std::vector<ConstraintGroup>& batch, size_t i) {
+		batch.push_back(std::move(islands[i]));
+	});
+}
+
+/*
+	The system has a 3x3 block for every pair of constraints, which is only nonzero if the two constraints share a Physical
+*/
+SparseBlockMatrix<double, 3> computeInteractionMatrix(const ConstraintGroup& group) {
+	const std::vector<PhysicalConstraint>& constraints = group.constraints;
+
+	SparseBlockMatrix<double, 3> systemToSolve(constraints.size());
+
+	size_t blockIndex = 0;
 	for (const PhysicalConstraint& pc : constraints) {
 		const BallConstraint& bc = *pc.constraint;
 		/*Local to A*/ SymmetricMat3 responseA = pc.physA->mainPhysical->getResponseMatrix(pc.physA->localToMain(bc.attachA));
@@ -33,9 +133,9 @@ LargeMatrix<double> computeInteractionMatrix(const ConstraintGroup& group) {
 		GlobalCFrame cfB = pc.physB->mainPhysical->getCFrame();
 		/*Global?*/ SymmetricMat3 selfResponse = cfA.rotation.localToGlobal(responseA) + cfB.rotation.localToGlobal(responseB);
 
-		systemToSolve.setSubMatrix(matrixIndex, matrixIndex, Mat3(selfResponse));
+		systemToSolve.setBlock(blockIndex, blockIndex, Mat3(selfResponse));
 
-		matrixIndex += 3;
+		blockIndex++;
 	}
 
 	for (size_t i = 0; i < constraints.size(); i++) {
@@ -58,7 +158,7 @@ LargeMatrix<double> computeInteractionMatrix(const ConstraintGroup& group) {
 					 isPositive = false; sharedBody = x.physA; actorOffset = x.constraint->attachA; responseOffset = y.constraint->attachB; }
 			else if (x.physB == y.physA) { 
 					 isPositive = false; sharedBody = x.physB; actorOffset = x.constraint->attachB; responseOffset = y.constraint->attachA; }
-			else if (x.physA == y.physB) { 
+			else if (x.physB == y.physB) { 
 					 isPositive = true;  sharedBody = x.physB; actorOffset = x.constraint->attachB; responseOffset = y.constraint->attachB; }
 			else {continue;}
 			
@@ -68,7 +168,7 @@ LargeMatrix<double> computeInteractionMatrix(const ConstraintGroup& group) {
 
 			Mat3 globalResponse = rot * response * rot.transpose();
 
-			systemToSolve.setSubMatrix(i * 3, j * 3, isPositive ? globalResponse : -globalResponse);
+			systemToSolve.setBlock(i, j, isPositive ? globalResponse : -globalResponse);
 		}
 	}
 
@@ -76,20 +176,51 @@ LargeMatrix<double> computeInteractionMatrix(const ConstraintGroup& group) {
 }
 
 
+/*
+	Factorization of a constraint system
+	Islands in which most constraints influence each other are factored densely, with pivoting. Sparser ones keep their sparsity, which avoids the cubic cost of the dense factorization
+*/
+class ConstraintSystemSolver {
+	std::optional<LargeLUDecomposition<double>> dense;
+	std::optional<SparseBlockLUDecomposition<double, 3>> sparse;
+public:
+	ConstraintSystemSolver(SparseBlockMatrix<double, 3> system) {
+		if(system.storedBlockCount() * 2 > system.blockCount() * system.blockCount()) {
+			dense.emplace(system.toDense());
+		} else {
+			sparse.emplace(std::move(system));
+		}
+	}
+
+	void solve(LargeVector<double>& v) const {
+		if(dense) {
+			dense->solve(v);
+		} else {
+			sparse->solve(v);
+		}
+	}
+};
+
 void ConstraintGroup::apply() const {
+	for(const ConstraintGroup& island : splitIntoIslands()) {
+		island.applyAsSingleSystem();
+	}
+}
+
+void ConstraintGroup::applyAsSingleSystem() const {
+	// a fully sleeping island was solved before it fell asleep, and nothing has moved since
+	bool allSleeping = std::all_of(constraints.begin(), constraints.end(), [](const PhysicalConstraint& bc) {
+		return bc.physA->mainPhysical->isSleeping && bc.physB->mainPhysical->isSleeping;
+	});
+	if(allSleeping) return;
+
 	size_t dimension = constraints.size() * 3;
-	LargeMatrix<double> systemToSolve = computeInteractionMatrix(*this);
+	// factored once, and reused for the position, velocity and acceleration
+	ConstraintSystemSolver system(computeInteractionMatrix(*this));
 	LargeVector<double> dragVector(dimension);
 	LargeVector<double> velocityVector(dimension);
 	LargeVector<double> accelerationVector(dimension);
 
-	
-
-
-
-	LargeMatrix<double> systemCopy(systemToSolve);
-	LargeMatrix<double> systemCopyCopy(systemToSolve);
-
 	size_t matrixIndex;
 
 	// solve for position
@@ -101,7 +232,7 @@ void ConstraintGroup::apply() const {
 
 		matrixIndex += 3;
 	}
-	destructiveSolve(systemCopyCopy, dragVector);
+	system.solve(dragVector);
 
 	matrixIndex = 0;
 	for (const PhysicalConstraint& bc : constraints) {
@@ -123,7 +254,7 @@ void ConstraintGroup::apply() const {
 
 		matrixIndex += 3;
 	}
-	destructiveSolve(systemToSolve, velocityVector);
+	system.solve(velocityVector);
 	
 	matrixIndex = 0;
 	for (const PhysicalConstraint& bc : constraints) {
@@ -146,7 +277,7 @@ void ConstraintGroup::apply() const {
 		matrixIndex += 3;
 	}
 
-	destructiveSolve(systemCopy, accelerationVector);
+	system.solve(accelerationVector);
 	
 	matrixIndex = 0;
 	for (const PhysicalConstraint& bc : constraints) {
@@ -30,5 +30,26 @@ struct ConstraintGroup {
 
 	void add(Physical* first, Physical* second, BallConstraint* constraint);
 
+	/*
+		Splits this group into islands, sets of constraints that do not share any MotorizedPhysical
+		The order of the constraints is kept, islands are ordered by their first constraint
+	*/
+	std::vector<ConstraintGroup> splitIntoIslands() const;
+
+	/*
+		Solves all constraints of this group as one system
+	*/
+	void applyAsSingleSystem() const;
+
+	/*
+		Solves every island of this group on its own, which is cheaper than solving the whole group at once
+	*/
 	void apply() const;
 };
+
+/*
+	Collects the islands of all given groups into batches, no MotorizedPhysical is touched by constraints of two different batches, so batches can be applied in parallel
+	Islands that share a physical, also those of different groups, end up in the same batch in the order the groups would apply them.
+	Islands of one group that share no physical may end up in different batches
+*/
+std::vector<std::vector<ConstraintGroup>> findIndependentConstraintBatches(const std::vector<ConstraintGroup>& groups);
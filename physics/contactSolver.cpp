@@ -0,0 +1,345 @@
+#include "contactSolver.h"
+
+#include "world.h"
+#include "part.h"
+#include "physical.h"
+#include "debug.h"
+
+#include <cmath>
+#include <algorithm>
+
+// any two unit vectors perpendicular to normal and to each other
+static void findTangents(const Vec3& normal, Vec3& tangent1, Vec3& tangent2) {
+	Vec3 axis = (std::abs(normal.x) < 0.57735) ? Vec3(1.0, 0.0, 0.0) : Vec3(0.0, 1.0, 0.0);
+	tangent1 = normalize(normal % axis);
+	tangent2 = normal % tangent1;
+}
+
+// how much the velocity of the point at offset along first changes for a unit impulse along second
+static double getResponseAlong(const SymmetricMat3& forceResponse, const SymmetricMat3& momentResponse, const Vec3& offset, const Vec3& first, const Vec3& second) {
+	return first * (forceResponse * second) + (offset % first) * (momentResponse * (offset % second));
+}
+
+static void addImpulseToBody(Vec3& velocity, Vec3& angularVelocity, const SymmetricMat3& forceResponse, const SymmetricMat3& momentResponse, const Vec3& offset, const Vec3& impulse) {
+	velocity += forceResponse * impulse;
+	angularVelocity += momentResponse * (offset % impulse);
+}
+
+size_t ContactSolver::getBody(MotorizedPhysical* physical, double deltaT) {
+	auto found = bodyIndices.find(physical);
+	if(found != bodyIndices.end()) return found->second;
+
+	SolverBody body;
+	body.physical = physical;
+	body.centerOfMass = physical->getCenterOfMass();
+	body.forceResponse = physical->getForceResponse();
+	body.momentResponse = physical->getCFrame().getRotation().localToGlobal(physical->getMomentResponse());
+	body.forceVelocity = body.forceResponse * physical->getTotalForce() * deltaT;
+	body.forceAngularVelocity = body.momentResponse * physical->getTotalMoment() * deltaT;
+	body.velocityChange = Vec3(0.0, 0.0, 0.0);
+	body.angularVelocityChange = Vec3(0.0, 0.0, 0.0);
+	body.pseudoVelocity = Vec3(0.0, 0.0, 0.0);
+	body.pseudoAngularVelocity = Vec3(0.0, 0.0, 0.0);
+
+	size_t index = bodies.size();
+	bodies.push_back(body);
+	bodyIndices.emplace(physical, index);
+	return index;
+}
+
+// twice the area of the quadrilateral with these corners, squared, whichever order they are in
+static double getQuadAreaSq(const Vec3& a, const Vec3& b, const Vec3& c, const Vec3& d) {
+	double area1 = lengthSquared((a - b) % (c - d));
+	double area2 = lengthSquared((a - c) % (b - d));
+	double area3 = lengthSquared((a - d) % (b - c));
+	return std::max(area1, std::max(area2, area3));
+}
+
+/*
+	Forgets the points of the manifold that separated or slid apart, and adds the newly found point
+	A point close to an old one replaces it but keeps its impulse, if the manifold is full the new point replaces the one that leaves the largest area
+*/
+static void refreshManifold(ContactManifold& manifold, const GlobalCFrame& cframe1, const GlobalCFrame& cframe2, const Vec3& normal, const ContactPoint& newPoint, double breakingDistance) {
+	for(size_t i = 0; i < manifold.pointCount;) {
+		const ContactPoint& point = manifold.points[i];
+		Vec3 separation = cframe1.localToGlobal(point.localPoint1) - cframe2.localToGlobal(point.localPoint2);
+		double depth = separation * normal;
+		Vec3 drift = separation - normal * depth;
+		if(depth < -breakingDistance || lengthSquared(drift) > breakingDistance * breakingDistance) {
+			manifold.points[i] = manifold.points[--manifold.pointCount];
+		} else {
+			i++;
+		}
+	}
+
+	for(size_t i = 0; i < manifold.pointCount; i++) {
+		ContactPoint& point = manifold.points[i];
+		if(lengthSquared(point.localPoint1 - newPoint.localPoint1) <= breakingDistance * breakingDistance) {
+			point.localPoint1 = newPoint.localPoint1;
+			point.localPoint2 = newPoint.localPoint2;
+			return;
+		}
+	}
+	if(manifold.pointCount < MAX_CONTACT_POINTS) {
+		manifold.points[manifold.pointCount++] = newPoint;
+		return;
+	}
+
+	size_t bestReplacement = 0;
+	double bestAreaSq = -1.0;
+	for(size_t replaced = 0; replaced < MAX_CONTACT_POINTS; replaced++) {
+		Vec3 corners[MAX_CONTACT_POINTS];
+		for(size_t i = 0; i < MAX_CONTACT_POINTS; i++) {
+			corners[i] = (i == replaced) ? newPoint.localPoint1 : manifold.points[i].localPoint1;
+		}
+		double areaSq = getQuadAreaSq(corners[0], corners[1], corners[2], corners[3]);
+		if(areaSq > bestAreaSq) {
+			bestAreaSq = areaSq;
+			bestReplacement = replaced;
+		}
+	}
+	manifold.points[bestReplacement] = newPoint;
+}
+
+void ContactSolver::addContact(const Colission& colission, bool isTerrain, ContactPoint& point, Position position, double depth, double deltaT, const ContactSolverSettings& settings) {
+	Part& part1 = *colission.p1;
+	Part& part2 = *colission.p2;
+
+	Contact contact;
+	contact.body1 = getBody(part1.parent->mainPhysical, deltaT);
+	contact.body2 = isTerrain ? NO_BODY : getBody(part2.parent->mainPhysical, deltaT);
+	contact.point = &point;
+	contact.depth = depth;
+	contact.normal = normalize(colission.exitVector);
+	findTangents(contact.normal, contact.tangent1, contact.tangent2);
+	contact.friction = part1.properties.friction * part2.properties.friction;
+
+	const SolverBody& body1 = bodies[contact.body1];
+	contact.offset1 = position - body1.centerOfMass;
+	Vec3 velocity1 = part1.getMotion().getVelocityOfPoint(position - part1.getPosition()) - part1.properties.conveyorEffect;
+	velocity1 += body1.forceVelocity + body1.forceAngularVelocity % contact.offset1;
+	double normalResponse = getResponseAlong(body1.forceResponse, body1.momentResponse, contact.offset1, contact.normal, contact.normal);
+	double tangentResponse11 = getResponseAlong(body1.forceResponse, body1.momentResponse, contact.offset1, contact.tangent1, contact.tangent1);
+	double tangentResponse12 = getResponseAlong(body1.forceResponse, body1.momentResponse, contact.offset1, contact.tangent1, contact.tangent2);
+	double tangentResponse22 = getResponseAlong(body1.forceResponse, body1.momentResponse, contact.offset1, contact.tangent2, contact.tangent2);
+
+	Vec3 velocity2;
+	if(isTerrain) {
+		contact.offset2 = Vec3(0.0, 0.0, 0.0);
+		velocity2 = -part2.getCFrame().localToRelative(part2.properties.conveyorEffect);
+	} else {
+		const SolverBody& body2 = bodies[contact.body2];
+		contact.offset2 = position - body2.centerOfMass;
+		velocity2 = part2.getMotion().getVelocityOfPoint(position - part2.getPosition()) - part2.properties.conveyorEffect;
+		velocity2 += body2.forceVelocity + body2.forceAngularVelocity % contact.offset2;
+		normalResponse += getResponseAlong(body2.forceResponse, body2.momentResponse, contact.offset2, contact.normal, contact.normal);
+		tangentResponse11 += getResponseAlong(body2.forceResponse, body2.momentResponse, contact.offset2, contact.tangent1, contact.tangent1);
+		tangentResponse12 += getResponseAlong(body2.forceResponse, body2.momentResponse, contact.offset2, contact.tangent1, contact.tangent2);
+		tangentResponse22 += getResponseAlong(body2.forceResponse, body2.momentResponse, contact.offset2, contact.tangent2, contact.tangent2);
+	}
+
+	Vec3 relativeVelocity = velocity2 - velocity1;
+	contact.initialRelativeVelocity = Vec3(relativeVelocity * contact.normal, relativeVelocity * contact.tangent1, relativeVelocity * contact.tangent2);
+
+	contact.normalMass = 1.0 / normalResponse;
+	double determinant = tangentResponse11 * tangentResponse22 - tangentResponse12 * tangentResponse12;
+	contact.tangentMass[0] = tangentResponse22 / determinant;
+	contact.tangentMass[1] = -tangentResponse12 / determinant;
+	contact.tangentMass[2] = tangentResponse11 / determinant;
+
+	double approachSpeed = -contact.initialRelativeVelocity.x;
+	double bounceVelocity = (approachSpeed > settings.restitutionThreshold) ? approachSpeed * part1.properties.bouncyness * part2.properties.bouncyness : 0.0;
+	if(depth < 0.0) {
+		// a remembered point that has come apart a little, the parts may still approach until they touch there
+		contact.correctionVelocity = depth / deltaT;
+	} else {
+		contact.correctionVelocity = correctionRate * std::max(depth - settings.allowedPenetration, 0.0);
+	}
+	contact.targetNormalVelocity = (settings.positionCorrection == PositionCorrection::BAUMGARTE || depth < 0.0) ? std::max(bounceVelocity, contact.correctionVelocity) : bounceVelocity;
+
+	contact.normalImpulse = 0.0;
+	contact.tangentImpulse1 = 0.0;
+	contact.tangentImpulse2 = 0.0;
+	contact.pseudoImpulse = 0.0;
+
+	contacts.push_back(contact);
+}
+
+static bool isTooSmall(const Colission& colission) {
+	double sizeOrder = std::min(colission.p1->maxRadius, colission.p2->maxRadius);
+	return lengthSquared(colission.exitVector) <= 1E-8 * sizeOrder * sizeOrder;
+}
+
+/*
+	exitVector of the colission is the distance p2 must travel so that the shapes are no longer colliding
+*/
+static void updateManifold(const Colission& colission, const ContactSolverSettings& settings) {
+	if(isTooSmall(colission)) return; // don't do anything for very small colissions
+
+	// the intersection lies halfway between the deepest points of both parts
+	GlobalCFrame cframe1 = colission.p1->getCFrame();
+	GlobalCFrame cframe2 = colission.p2->getCFrame();
+	ContactPoint newPoint;
+	newPoint.localPoint1 = cframe1.globalToLocal(colission.intersection + colission.exitVector * 0.5);
+	newPoint.localPoint2 = cframe2.globalToLocal(colission.intersection - colission.exitVector * 0.5);
+	newPoint.lastForce = Vec3(0.0, 0.0, 0.0);
+
+	ContactManifold& manifold = colission.pairData->contactManifold;
+	if(colission.pairData->ticksInContact <= 1) {
+		// whatever is left is from an earlier contact
+		manifold.pointCount = 0;
+	}
+	refreshManifold(manifold, cframe1, cframe2, normalize(colission.exitVector), newPoint, settings.contactBreakingDistance);
+}
+
+void ContactSolver::addContacts(const Colission& colission, bool isTerrain, double deltaT, const ContactSolverSettings& settings) {
+	if(isTooSmall(colission)) return;
+	Debug::logPoint(colission.intersection, Debug::INTERSECTION);
+
+	// the parts may have moved since the manifold was updated, so the depth of every point is measured again
+	GlobalCFrame cframe1 = colission.p1->getCFrame();
+	GlobalCFrame cframe2 = colission.p2->getCFrame();
+	Vec3 normal = normalize(colission.exitVector);
+	ContactManifold& manifold = colission.pairData->contactManifold;
+	for(size_t i = 0; i < manifold.pointCount; i++) {
+		ContactPoint& point = manifold.points[i];
+		Position deepestOf1 = cframe1.localToGlobal(point.localPoint1);
+		Position deepestOf2 = cframe2.localToGlobal(point.localPoint2);
+		Vec3 separation = deepestOf1 - deepestOf2;
+		addContact(colission, isTerrain, point, deepestOf2 + separation * 0.5, separation * normal, deltaT, settings);
+	}
+}
+
+void ContactSolver::updateManifolds(const std::vector<Colission>& objectColissions, const std::vector<Colission>& terrainColissions, const ContactSolverSettings& settings) {
+	for(const Colission& colission : objectColissions) {
+		updateManifold(colission, settings);
+	}
+	for(const Colission& colission : terrainColissions) {
+		updateManifold(colission, settings);
+	}
+}
+
+Vec3 ContactSolver::getRelativeVelocityChange(const Contact& contact, bool isPseudo) const {
+	const SolverBody& body1 = bodies[contact.body1];
+	Vec3 change1 = isPseudo ? body1.pseudoVelocity + body1.pseudoAngularVelocity % contact.offset1 : body1.velocityChange + body1.angularVelocityChange % contact.offset1;
+	if(contact.body2 == NO_BODY) return -change1;
+	const SolverBody& body2 = bodies[contact.body2];
+	Vec3 change2 = isPseudo ? body2.pseudoVelocity + body2.pseudoAngularVelocity % contact.offset2 : body2.velocityChange + body2.angularVelocityChange % contact.offset2;
+	return change2 - change1;
+}
+
+void ContactSolver::applyToBodies(const Contact& contact, const Vec3& impulse, bool isPseudo) {
+	SolverBody& body1 = bodies[contact.body1];
+	addImpulseToBody(isPseudo ? body1.pseudoVelocity : body1.velocityChange, isPseudo ? body1.pseudoAngularVelocity : body1.angularVelocityChange, body1.forceResponse, body1.momentResponse, contact.offset1, -impulse);
+	if(contact.body2 == NO_BODY) return;
+	SolverBody& body2 = bodies[contact.body2];
+	addImpulseToBody(isPseudo ? body2.pseudoVelocity : body2.velocityChange, isPseudo ? body2.pseudoAngularVelocity : body2.angularVelocityChange, body2.forceResponse, body2.momentResponse, contact.offset2, impulse);
+}
+
+void ContactSolver::warmStart(Contact& contact, double deltaT) {
+	Vec3 lastImpulse = contact.point->lastForce * deltaT;
+	contact.normalImpulse = std::max(lastImpulse * contact.normal, 0.0);
+	contact.tangentImpulse1 = lastImpulse * contact.tangent1;
+	contact.tangentImpulse2 = lastImpulse * contact.tangent2;
+
+	// the contact may have turned since the last step, which can take the friction out of its cone
+	double maxTangentImpulse = contact.friction * contact.normalImpulse;
+	double tangentImpulseSq = contact.tangentImpulse1 * contact.tangentImpulse1 + contact.tangentImpulse2 * contact.tangentImpulse2;
+	if(tangentImpulseSq > maxTangentImpulse * maxTangentImpulse) {
+		double factor = maxTangentImpulse / std::sqrt(tangentImpulseSq);
+		contact.tangentImpulse1 *= factor;
+		contact.tangentImpulse2 *= factor;
+	}
+
+	applyToBodies(contact, getTotalImpulse(contact), false);
+}
+
+void ContactSolver::solveVelocity(Contact& contact) {
+	// friction first, the normal impulse is the one that matters most so it gets the last word
+	Vec3 velocityChange = getRelativeVelocityChange(contact, false);
+	double tangentVelocity1 = contact.initialRelativeVelocity.y + velocityChange * contact.tangent1;
+	double tangentVelocity2 = contact.initialRelativeVelocity.z + velocityChange * contact.tangent2;
+
+	double oldTangentImpulse1 = contact.tangentImpulse1;
+	double oldTangentImpulse2 = contact.tangentImpulse2;
+	contact.tangentImpulse1 -= contact.tangentMass[0] * tangentVelocity1 + contact.tangentMass[1] * tangentVelocity2;
+	contact.tangentImpulse2 -= contact.tangentMass[1] * tangentVelocity1 + contact.tangentMass[2] * tangentVelocity2;
+	double maxTangentImpulse = contact.friction * contact.normalImpulse;
+	double tangentImpulseSq = contact.tangentImpulse1 * contact.tangentImpulse1 + contact.tangentImpulse2 * contact.tangentImpulse2;
+	if(tangentImpulseSq > maxTangentImpulse * maxTangentImpulse) {
+		double factor = maxTangentImpulse / std::sqrt(tangentImpulseSq);
+		contact.tangentImpulse1 *= factor;
+		contact.tangentImpulse2 *= factor;
+	}
+	applyToBodies(contact, contact.tangent1 * (contact.tangentImpulse1 - oldTangentImpulse1) + contact.tangent2 * (contact.tangentImpulse2 - oldTangentImpulse2), false);
+
+	double normalVelocity = contact.initialRelativeVelocity.x + getRelativeVelocityChange(contact, false) * contact.normal;
+	double oldNormalImpulse = contact.normalImpulse;
+	contact.normalImpulse = std::max(oldNormalImpulse + contact.normalMass * (contact.targetNormalVelocity - normalVelocity), 0.0);
+	applyToBodies(contact, contact.normal * (contact.normalImpulse - oldNormalImpulse), false);
+}
+
+void ContactSolver::solvePosition(Contact& contact) {
+	double normalVelocity = getRelativeVelocityChange(contact, true) * contact.normal;
+	double oldPseudoImpulse = contact.pseudoImpulse;
+	contact.pseudoImpulse = std::max(oldPseudoImpulse + contact.normalMass * (contact.correctionVelocity - normalVelocity), 0.0);
+	applyToBodies(contact, contact.normal * (contact.pseudoImpulse - oldPseudoImpulse), true);
+}
+
+void ContactSolver::applyImpulses(const ContactSolverSettings& settings, double deltaT) {
+	for(const Contact& contact : contacts) {
+		Vec3 impulse = getTotalImpulse(contact);
+		contact.point->lastForce = impulse / deltaT;
+
+		MotorizedPhysical* physical1 = bodies[contact.body1].physical;
+		physical1->applyImpulse(contact.offset1, -impulse);
+		if(contact.body2 != NO_BODY) {
+			bodies[contact.body2].physical->applyImpulse(contact.offset2, impulse);
+		}
+	}
+	if(settings.positionCorrection != PositionCorrection::SPLIT_IMPULSE) return;
+
+	// the pseudo velocities only move the bodies, a drag moves them by forceResponse * drag
+	for(const Contact& contact : contacts) {
+		if(contact.pseudoImpulse == 0.0) continue;
+		Vec3 drag = contact.normal * (contact.pseudoImpulse * deltaT);
+		bodies[contact.body1].physical->applyDrag(contact.offset1, -drag);
+		if(contact.body2 != NO_BODY) {
+			bodies[contact.body2].physical->applyDrag(contact.offset2, drag);
+		}
+	}
+}
+
+void ContactSolver::solve(const std::vector<Colission>& objectColissions, const std::vector<Colission>& terrainColissions, double deltaT, double tickDeltaT, const ContactSolverSettings& settings) {
+	correctionRate = settings.correctionFactor / tickDeltaT;
+	bodies.clear();
+	bodyIndices.clear();
+	contacts.clear();
+
+	for(const Colission& colission : objectColissions) {
+		addContacts(colission, false, deltaT, settings);
+	}
+	for(const Colission& colission : terrainColissions) {
+		addContacts(colission, true, deltaT, settings);
+	}
+
+	if(settings.warmStarting) {
+		for(Contact& contact : contacts) {
+			warmStart(contact, deltaT);
+		}
+	}
+	for(size_t iteration = 0; iteration < settings.velocityIterations; iteration++) {
+		for(Contact& contact : contacts) {
+			solveVelocity(contact);
+		}
+	}
+	if(settings.positionCorrection == PositionCorrection::SPLIT_IMPULSE) {
+		for(size_t iteration = 0; iteration < settings.positionIterations; iteration++) {
+			for(Contact& contact : contacts) {
+				solvePosition(contact);
+			}
+		}
+	}
+
+	applyImpulses(settings, deltaT);
+}
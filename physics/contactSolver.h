@@ -0,0 +1,154 @@
+#pragma once
+
+#include "math/linalg/vec.h"
+#include "math/linalg/mat.h"
+#include "math/position.h"
+
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+
+struct Colission;
+class MotorizedPhysical;
+
+#define MAX_CONTACT_POINTS 4
+
+/*
+	A point where two parts touch, remembered from one tick to the next
+	The narrow phase finds only one point per pair of parts, a part resting on another needs several of them to not tip over
+*/
+struct ContactPoint {
+	// the deepest point of p1 in p2, local to p1, and the deepest point of p2 in p1, local to p2
+	Vec3 localPoint1;
+	Vec3 localPoint2;
+	// impulse p2 got at this point in the last step divided by the length of the step, p1 got the opposite
+	// stored per unit of time so warm starting still fits when the steps change length
+	Vec3 lastForce;
+};
+
+struct ContactManifold {
+	ContactPoint points[MAX_CONTACT_POINTS];
+	size_t pointCount = 0;
+};
+
+enum class ContactSolverType {
+	// a stiff spring force against the penetration, plus an impulse and friction per contact, see handleCollision
+	PENALTY,
+	// projected Gauss-Seidel over all contacts at once, see ContactSolver
+	SEQUENTIAL_IMPULSE
+};
+
+enum class PositionCorrection {
+	// the penetration is pushed out by an extra separating velocity, which the bodies keep
+	BAUMGARTE,
+	// the penetration is pushed out by moving the bodies directly, without changing their velocity
+	SPLIT_IMPULSE
+};
+
+/*
+	Settings of the contact response, only type is used by the penalty method
+	correctionFactor is the fraction of the penetration beyond allowedPenetration that is removed per tick,
+	contacts that approach faster than restitutionThreshold bounce back with the combined bouncyness of their parts,
+	remembered contact points are forgotten once they separate or slide apart by more than contactBreakingDistance
+*/
+struct ContactSolverSettings {
+	ContactSolverType type = ContactSolverType::PENALTY;
+	size_t velocityIterations = 10;
+	// only used for SPLIT_IMPULSE
+	size_t positionIterations = 4;
+	PositionCorrection positionCorrection = PositionCorrection::BAUMGARTE;
+	double correctionFactor = 0.2;
+	double allowedPenetration = 0.005;
+	double restitutionThreshold = 1.0;
+	double contactBreakingDistance = 0.02;
+	bool warmStarting = true;
+};
+
+/*
+	Sequential impulse contact solver, every point of the ContactManifold of a colission becomes a contact
+	that may only push its parts apart, with friction limited by the normal impulse.
+	The contacts are solved one by one for a number of iterations, each time against the velocities the previous ones left behind.
+	Velocities include the forces the physicals got this tick, so the contacts also hold up against gravity and the like.
+	The manifolds are kept in the ColissionPairData of the pairs. With warm starting, points that existed in the last step start out from the impulse they ended with.
+	The buffers are kept around between ticks to avoid reallocating
+*/
+class ContactSolver {
+	struct SolverBody {
+		MotorizedPhysical* physical;
+		Position centerOfMass;
+		SymmetricMat3 forceResponse;
+		// momentResponse in global space
+		SymmetricMat3 momentResponse;
+		// how much the forces of this tick will change the velocity, contacts must hold up against this too
+		Vec3 forceVelocity;
+		Vec3 forceAngularVelocity;
+		Vec3 velocityChange;
+		Vec3 angularVelocityChange;
+		// split impulse only, never added to the velocity of the physical
+		Vec3 pseudoVelocity;
+		Vec3 pseudoAngularVelocity;
+	};
+	struct Contact {
+		size_t body1;
+		// NO_BODY for terrain
+		size_t body2;
+		ContactPoint* point;
+		// relative to the centers of mass
+		Vec3 offset1;
+		Vec3 offset2;
+		// from p1 towards p2
+		Vec3 normal;
+		Vec3 tangent1;
+		Vec3 tangent2;
+		double depth;
+		double friction;
+		// relative velocity of p2 to p1 along normal, tangent1 and tangent2 before any impulses
+		Vec3 initialRelativeVelocity;
+		double targetNormalVelocity;
+		// separating velocity that removes correctionFactor of the penetration this tick
+		double correctionVelocity;
+		double normalMass;
+		// inverse of the response matrix in the tangent plane, (00, 01, 11)
+		double tangentMass[3];
+		double normalImpulse;
+		double tangentImpulse1;
+		double tangentImpulse2;
+		double pseudoImpulse;
+	};
+	static constexpr size_t NO_BODY = ~size_t(0);
+
+	std::vector<SolverBody> bodies;
+	std::unordered_map<const MotorizedPhysical*, size_t> bodyIndices;
+	std::vector<Contact> contacts;
+	// separating velocity per unit of penetration, correctionFactor per tick rather than per substep
+	double correctionRate = 0.0;
+
+	size_t getBody(MotorizedPhysical* physical, double deltaT);
+	void addContact(const Colission& colission, bool isTerrain, ContactPoint& point, Position position, double depth, double deltaT, const ContactSolverSettings& settings);
+	void addContacts(const Colission& colission, bool isTerrain, double deltaT, const ContactSolverSettings& settings);
+	Vec3 getRelativeVelocityChange(const Contact& contact, bool isPseudo) const;
+	// impulse is what p2 receives, p1 gets the opposite
+	void applyToBodies(const Contact& contact, const Vec3& impulse, bool isPseudo);
+	static inline Vec3 getTotalImpulse(const Contact& contact) {
+		return contact.normal * contact.normalImpulse + contact.tangent1 * contact.tangentImpulse1 + contact.tangent2 * contact.tangentImpulse2;
+	}
+	void warmStart(Contact& contact, double deltaT);
+	void solveVelocity(Contact& contact);
+	void solvePosition(Contact& contact);
+	void applyImpulses(const ContactSolverSettings& settings, double deltaT);
+
+public:
+	/*
+		Brings the contact manifolds up to date with newly found colissions, must be called once after every colission detection before solve
+	*/
+	void updateManifolds(const std::vector<Colission>& objectColissions, const std::vector<Colission>& terrainColissions, const ContactSolverSettings& settings);
+
+	/*
+		Works out and applies the impulses of all colissions for a step of deltaT, before the physicals are moved by it
+		Can be called for several substeps of a tick per colission detection, the depth of the contacts is measured anew every time.
+		Penetration is corrected at the same rate for any number of substeps, tickDeltaT is the length of the whole tick
+	*/
+	void solve(const std::vector<Colission>& objectColissions, const std::vector<Colission>& terrainColissions, double deltaT, double tickDeltaT, const ContactSolverSettings& settings);
+
+	inline size_t getContactCount() const { return contacts.size(); }
+};
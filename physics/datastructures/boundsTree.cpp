@@ -48,12 +48,13 @@ TreeNode::TreeNode(TreeNode* subTrees, int nodeCount) :
 TreeNode::TreeNode(const TreeNode& original) :
 	nodeCount(original.nodeCount),
 	isGroupHead(original.isGroupHead),
+	hasOutdatedBounds(original.hasOutdatedBounds),
 	bounds(original.bounds) {
 
 	if(original.isLeafNode()) {
 		this->object = original.object;
 	} else {
-		this->subTrees = new TreeNode[MAX_BRANCHES];
+		this->subTrees = allocateSubTrees();
 		for(size_t i = 0; i < original.nodeCount; i++) {
 			new(this->subTrees + i) TreeNode(original.subTrees[i]);
 		}
@@ -64,12 +65,13 @@ TreeNode& TreeNode::operator=(const TreeNode& original) {
 
 	this->nodeCount = original.nodeCount;
 	this->isGroupHead = original.isGroupHead;
+	this->hasOutdatedBounds = original.hasOutdatedBounds;
 	this->bounds = original.bounds;
 
 	if(original.isLeafNode()) {
 		this->object = original.object;
 	} else {
-		this->subTrees = new TreeNode[MAX_BRANCHES];
+		this->subTrees = allocateSubTrees();
 		for(size_t i = 0; i < original.nodeCount; i++) {
 			new(this->subTrees + i) TreeNode(original.subTrees[i]);
 		}
@@ -79,7 +81,7 @@ TreeNode& TreeNode::operator=(const TreeNode& original) {
 
 TreeNode::~TreeNode() {
 	if (!isLeafNode()) {
-		delete[] subTrees;
+		freeSubTrees(subTrees);
 	}
 }
 
@@ -106,7 +108,7 @@ void TreeNode::addOutside(TreeNode&& newNode) {
 		this->addInside(std::move(newNode));
 	} else {
 		// push the whole group down, make a new node containing it and the new node
-		TreeNode* newNodes = new TreeNode[MAX_BRANCHES];
+		TreeNode* newNodes = allocateSubTrees();
 		new(newNodes) TreeNode(std::move(*this));
 		new(newNodes + 1) TreeNode(std::move(newNode));
 		new(this) TreeNode(newNodes, 2);
@@ -117,7 +119,7 @@ void TreeNode::addOutside(TreeNode&& newNode) {
 // if top node is undivisible, then the new node will be inside of the group
 void TreeNode::addInside(TreeNode&& newNode) {
 	if (isLeafNode()) {
-		TreeNode* newNodes = new TreeNode[MAX_BRANCHES];
+		TreeNode* newNodes = allocateSubTrees();
 
 		new(newNodes) TreeNode(std::move(*this));
 		new(newNodes + 1) TreeNode(std::move(newNode));
@@ -151,7 +153,7 @@ TreeNode TreeNode::remove(int index) {
 		bool resultIsGroupHead = this->isGroupHead || buf[0].isGroupHead;
 		new(this) TreeNode(std::move(buf[0]));
 		this->isGroupHead = resultIsGroupHead;
-		delete[] buf;
+		freeSubTrees(buf);
 	} else {
 		this->recalculateBoundsFromSubBounds();
 	}
@@ -182,6 +184,17 @@ void TreeNode::recalculateBoundsRecursive() {
 	recalculateBounds();
 }
 
+void TreeNode::refitOutdatedBoundsRecursive() {
+	for (size_t i = 0; i < nodeCount; i++) {
+		if(subTrees[i].hasOutdatedBounds) {
+			subTrees[i].refitOutdatedBoundsRecursive();
+		}
+	}
+
+	recalculateBoundsFromSubBounds();
+	hasOutdatedBounds = false;
+}
+
 bool TreeNode::recursiveFindAndReplaceObject(const void* find, void* replaceWith, const Bounds& objBounds) noexcept {
 	if(isLeafNode()) {
 		if(object == find) {
@@ -321,6 +334,31 @@ NodeStack::NodeStack(TreeNode& rootNode, const void* objToFind, const Bounds& ob
 	throw std::logic_error("Could not find obj in Tree!");
 }
 
+bool NodeStack::followPath(TreeNode& rootNode, const TreeLeafPath& path, const void* objToFind) {
+	top = stack;
+	*top = TreeStackElement{&rootNode, 0};
+	if(rootNode.nodeCount == 0) return false;
+	for(int level = 0; level < path.depth; level++) {
+		TreeNode* node = top->node;
+		int index = static_cast<int>((path.indices >> (2 * level)) & 0b11);
+		if(node->isLeafNode() || index >= node->nodeCount) return false;
+		top->index = index;
+		top++;
+		*top = TreeStackElement{&node->subTrees[index], 0};
+	}
+	return top->node->isLeafNode() && top->node->object == objToFind;
+}
+
+TreeLeafPath NodeStack::getPath() const {
+	TreeLeafPath path;
+	path.depth = static_cast<int>(top - stack);
+	assert(path.depth <= TreeLeafPath::MAX_DEPTH);
+	for(int level = 0; level < path.depth; level++) {
+		path.indices |= static_cast<uint64_t>(stack[level].index) << (2 * level);
+	}
+	return path;
+}
+
 NodeStack::NodeStack(const NodeStack& other) : stack{}, top(this->stack + (other.top - other.stack)) {
 	for(int i = 0; i < top - stack + 1; i++) {
 		this->stack[i] = other.stack[i];
@@ -386,6 +424,18 @@ void NodeStack::updateBoundsAllTheWayToTop() {
 	}
 }
 
+void NodeStack::markBoundsOutdatedAllTheWayToTop() {
+	assert(top + 1 >= stack);
+	if(top + 1 == stack) return;
+	TreeStackElement* newTop = top->node->isLeafNode() ? top - 1 : top;
+	while(newTop + 1 != stack) {
+		TreeNode* n = newTop->node;
+		if(n->hasOutdatedBounds) return; // everything above was already marked by an earlier object
+		n->hasOutdatedBounds = true;
+		newTop--;
+	}
+}
+
 void NodeStack::expandBoundsAllTheWayToTop() {
 	assert(top + 1 >= stack);
 	if(top + 1 == stack) return;
@@ -563,9 +613,9 @@ inline static void fillNodePairWithPermutation(TreeNode& first, TreeNode& second
 	int groupsNeeded = 1 + (bestPermutation.countB != 1);
 
 	if (existingGroups < groupsNeeded) {// tops one extra group to be made
-		availableGroups[1] = new TreeNode[MAX_BRANCHES];
+		availableGroups[1] = allocateSubTrees();
 	} else if (existingGroups > groupsNeeded) {
-		delete[] availableGroups[--existingGroups];
+		freeSubTrees(availableGroups[--existingGroups]);
 	}
 
 	first.subTrees = availableGroups[0];
@@ -633,30 +683,78 @@ inline static void optimizeNodePairVertical(TreeNode& node, TreeNode& group) {
 void TreeNode::improveStructure() {
 	if (!isLeafNode()) {
 		for (int i = 0; i < nodeCount; i++) subTrees[i].improveStructure();
-		// horizontal structure improvement
-		for (int i = 0; i < nodeCount - 1; i++) {
-			TreeNode& A = subTrees[i];
-			if (A.isGroupHead) continue;
-			for (int j = i + 1; j < nodeCount; j++) {
-				TreeNode& B = subTrees[j];
-				if (B.isGroupHead) continue;
-				if (intersects(A.bounds, B.bounds)) {
-					optimizeNodePairHorizontal(A, B);
-				}
+		improveStructureLocally();
+	}
+}
+
+void TreeNode::improveStructureLocally() {
+	// horizontal structure improvement
+	for (int i = 0; i < nodeCount - 1; i++) {
+		TreeNode& A = subTrees[i];
+		if (A.isGroupHead) continue;
+		for (int j = i + 1; j < nodeCount; j++) {
+			TreeNode& B = subTrees[j];
+			if (B.isGroupHead) continue;
+			if (intersects(A.bounds, B.bounds)) {
+				optimizeNodePairHorizontal(A, B);
 			}
 		}
-		// vertical structure improvement
-		for (int i = 0; i < nodeCount; i++) {
-			TreeNode& A = subTrees[i];
-			if (A.isLeafNode()) continue;
-			if (A.isGroupHead) continue;
-			for (int j = 0; j < nodeCount; j++) {
-				if (i == j) continue;
-				TreeNode& B = subTrees[j];
-				if (intersects(A.bounds, B.bounds)) {
-					optimizeNodePairVertical(B, A);
-				}
+	}
+	// vertical structure improvement
+	for (int i = 0; i < nodeCount; i++) {
+		TreeNode& A = subTrees[i];
+		if (A.isLeafNode()) continue;
+		if (A.isGroupHead) continue;
+		for (int j = 0; j < nodeCount; j++) {
+			if (i == j) continue;
+			TreeNode& B = subTrees[j];
+			if (intersects(A.bounds, B.bounds)) {
+				optimizeNodePairVertical(B, A);
 			}
 		}
 	}
 }
+
+size_t TreeNode::improveStructure(size_t nodeBudget, StructureImprovementCursor& cursor) {
+	if (isLeafNode() || nodeBudget == 0) return 0;
+
+	TreeNode* stack[MAX_HEIGHT];
+	stack[0] = this;
+	int depth = 1;
+	if (cursor.depth == 0) {
+		cursor.path[0] = 0;
+	} else {
+		// walk the stored path again, stopping early where the tree has changed underneath it
+		while (depth < cursor.depth) {
+			TreeNode* node = stack[depth - 1];
+			if (node->isLeafNode() || cursor.path[depth - 1] >= node->nodeCount) break;
+			stack[depth] = &node->subTrees[cursor.path[depth - 1]];
+			depth++;
+		}
+		if (!stack[depth - 1]->isLeafNode() && cursor.path[depth - 1] > stack[depth - 1]->nodeCount) {
+			cursor.path[depth - 1] = stack[depth - 1]->nodeCount;
+		}
+	}
+
+	size_t improvedCount = 0;
+	while (improvedCount < nodeBudget) {
+		TreeNode* node = stack[depth - 1];
+		if (!node->isLeafNode() && cursor.path[depth - 1] < node->nodeCount) {
+			// children first
+			assert(depth < MAX_HEIGHT);
+			stack[depth] = &node->subTrees[cursor.path[depth - 1]];
+			cursor.path[depth] = 0;
+			depth++;
+			continue;
+		}
+		if (!node->isLeafNode()) {
+			node->improveStructureLocally();
+			improvedCount++;
+		}
+		depth--;
+		if (depth == 0) break; // back at the root, the next call starts over
+		cursor.path[depth - 1]++;
+	}
+	cursor.depth = depth;
+	return improvedCount;
+}
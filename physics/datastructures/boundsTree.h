@@ -2,6 +2,8 @@
 
 #include "iteratorFactory.h"
 #include "iteratorEnd.h"
+#include "compiledBoundsTree.h"
+#include "treeNodePool.h"
 
 #include "../math/position.h"
 #include "../math/fix.h"
@@ -11,11 +13,25 @@
 #include <new>
 #include <assert.h>
 #include <stdexcept>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+class ThreadPool;
 
 #define MAX_BRANCHES 4
 #define MAX_HEIGHT 64
 #define LEAF_NODE_SIGNIFIER 0x7FFFFFFF
 
+/*
+	Remembers where a budgeted TreeNode::improveStructure stopped, as the child index taken at each level on the way down
+	Only indices are stored, so changes made to the tree in between can at worst make it skip or revisit some nodes
+*/
+struct StructureImprovementCursor {
+	int path[MAX_HEIGHT];
+	int depth = 0;
+};
+
 struct TreeNode {
 	Bounds bounds;
 	union {
@@ -28,6 +44,8 @@ struct TreeNode {
 	If false, then no subnodes are allowed to be exchanged with the rest of the tree. This node must be viewed as a black box. 
 	*/
 	bool isGroupHead = false;
+	/* set on the nodes above objects that have moved, until refitOutdatedBoundsRecursive brings their bounds up to date again */
+	bool hasOutdatedBounds = false;
 
 	inline bool isLeafNode() const { return nodeCount == LEAF_NODE_SIGNIFIER; }
 
@@ -40,7 +58,7 @@ struct TreeNode {
 	explicit TreeNode(const TreeNode& original);
 	TreeNode& operator=(const TreeNode& original);
 
-	inline TreeNode(TreeNode&& other) noexcept : nodeCount(other.nodeCount), subTrees(other.subTrees), bounds(other.bounds), isGroupHead(other.isGroupHead) {
+	inline TreeNode(TreeNode&& other) noexcept : nodeCount(other.nodeCount), subTrees(other.subTrees), bounds(other.bounds), isGroupHead(other.isGroupHead), hasOutdatedBounds(other.hasOutdatedBounds) {
 		other.subTrees = nullptr;
 		other.nodeCount = LEAF_NODE_SIGNIFIER;
 	}
@@ -49,6 +67,7 @@ struct TreeNode {
 		std::swap(this->subTrees, other.subTrees);
 		std::swap(this->bounds, other.bounds);
 		std::swap(this->isGroupHead, other.isGroupHead);
+		std::swap(this->hasOutdatedBounds, other.hasOutdatedBounds);
 		return *this;
 	}
 	
@@ -68,17 +87,40 @@ struct TreeNode {
 	void recalculateBounds();
 	void recalculateBoundsFromSubBounds();
 	void recalculateBoundsRecursive();
+	// only descends into and recalculates nodes with hasOutdatedBounds set
+	void refitOutdatedBoundsRecursive();
 
 	bool recursiveFindAndReplaceObject(const void* find, void* replaceWith, const Bounds& bounds) noexcept;
 
 	void improveStructure();
+	// only rearranges the direct children of this node and their children, without recursing any further
+	void improveStructureLocally();
+	size_t improveStructure(size_t nodeBudget, StructureImprovementCursor& cursor);
 
 	size_t getNumberOfObjectsInNode() const;
 	size_t getLengthOfLongestBranch() const;
 };
 
+/*
+	Returns MAX_BRANCHES default constructed nodes to be used as the subTrees of a node, from the pool of the current TreeNodePoolScope
+	freeSubTrees destroys all MAX_BRANCHES nodes and gives the block back to the pool it came from
+*/
+TreeNode* allocateSubTrees();
+void freeSubTrees(TreeNode* subTrees);
+
 long long computeCost(const Bounds& bounds);
 
+/*
+	Builds a tree over the given nodes top down, splitting them with the binned surface area heuristic into up to MAX_BRANCHES children per node
+	The nodes are treated as opaque, groups and leaves are moved into the new tree as they are. The nodes array is reordered and left with moved-from nodes
+	If a pool is given, the lower subtrees are built in parallel, the resulting tree does not depend on the thread count
+*/
+TreeNode buildTreeTopDown(TreeNode* nodes, size_t count, ThreadPool* pool = nullptr);
+/*
+	Moves all leaves and group heads that aren't part of a larger group out of node and into output
+*/
+void collectTopLevelNodes(TreeNode& node, std::vector<TreeNode>& output);
+
 //Bounds computeBoundsOfList(const TreeNode* const* list, size_t count);
 
 //Bounds computeBoundsOfList(const TreeNode* list, size_t count);
@@ -88,6 +130,18 @@ struct TreeStackElement {
 	int index;
 };
 
+/*
+	The child indices leading from the root down to a leaf, 2 bits per level
+	Changes to the structure of the tree can make it lead elsewhere, so it has to be checked before use, see NodeStack::followPath
+*/
+struct TreeLeafPath {
+	uint64_t indices = 0;
+	int depth = 0;
+
+	static constexpr int MAX_DEPTH = 32;
+};
+static_assert(MAX_BRANCHES <= 4, "TreeLeafPath stores 2 bits per level");
+
 struct NodeStack {
 	TreeStackElement* top;
 	TreeStackElement stack[MAX_HEIGHT];
@@ -97,6 +151,11 @@ struct NodeStack {
 	// a find function, returning the stack of all nodes leading up to the requested object
 	NodeStack(TreeNode& rootNode, const void* objToFind, const Bounds& objBounds);
 
+	// sets up the stack along the given path, returns false if the path does not end in objToFind
+	bool followPath(TreeNode& rootNode, const TreeLeafPath& path, const void* objToFind);
+	// the path to the node currently pointed to, only valid if the stack isn't deeper than TreeLeafPath::MAX_DEPTH
+	TreeLeafPath getPath() const;
+
 	NodeStack(const NodeStack& other);
 	NodeStack(NodeStack&& other) noexcept;
 	NodeStack& operator=(const NodeStack& other);
@@ -114,6 +173,8 @@ struct NodeStack {
 	void riseUntilGroupHeadWhile();
 	void updateBoundsAllTheWayToTop();
 	void expandBoundsAllTheWayToTop();
+	// like updateBoundsAllTheWayToTop, but only flags the nodes, see TreeNode::refitOutdatedBoundsRecursive
+	void markBoundsOutdatedAllTheWayToTop();
 
 	// removes the object currently pointed to
 	void remove();
@@ -277,9 +338,42 @@ struct TreeIterFactory;
 
 template<typename Boundable>
 struct BoundsTree {
+	/*
+		Where the subTrees blocks of this tree come from, declared before rootNode so it is released after the nodes are freed
+	*/
+	TreeNodePoolHandle nodePool;
 	TreeNode rootNode;
+	StructureImprovementCursor improveStructureCursor;
+	/*
+		Counts the changes made through the methods of this tree, code that changes the nodes in some other way must call markModified
+	*/
+	size_t modificationCount = 0;
+	/*
+		Record of the changes to the leaves, for code that keeps data derived from the leaf bounds up to date, such as the pairs of overlapping leaves
+		While trackLeafChanges is set, every leaf whose bounds change is appended to changedLeaves along with its new bounds.
+		Other changes to the leaves, like adding, removing or regrouping objects, only set leafChangesIncomplete, as does exceeding MAX_TRACKED_LEAF_CHANGES.
+		The reader clears both once it has caught up, see clearLeafChanges
+	*/
+	struct LeafChange {
+		const void* object;
+		Bounds bounds;
+	};
+	static constexpr size_t MAX_TRACKED_LEAF_CHANGES = 65536;
+	bool trackLeafChanges = false;
+	bool leafChangesIncomplete = true;
+	std::vector<LeafChange> changedLeaves;
+	/*
+		Where each object was last found, so most lookups only have to check the path instead of searching the tree by bounds
+		Only ever used as a hint, a path that no longer leads to its object falls back to the search
+	*/
+	std::unordered_map<const void*, TreeLeafPath> leafPaths;
+	/*
+		Copy of the tree as of compiledModificationCount, see compile
+	*/
+	CompiledBoundsTree compiled;
+	size_t compiledModificationCount = 0;
 
-	BoundsTree() : rootNode() {
+	BoundsTree() : nodePool(TreeNodePool::create()), rootNode() {
 
 	}
 
@@ -294,11 +388,33 @@ struct BoundsTree {
 		return this->rootNode.nodeCount == 0;
 	}
 
+	inline void markModified() { modificationCount++; }
+
+	inline void clearLeafChanges() {
+		changedLeaves.clear();
+		leafChangesIncomplete = false;
+	}
+
+	inline bool isCompiledUpToDate() const { return compiledModificationCount == modificationCount; }
+	/*
+		Brings compiled up to date with the tree, does nothing if the tree wasn't modified since
+	*/
+	inline void compile() {
+		if(isCompiledUpToDate()) return;
+		compiled.compile(rootNode);
+		compiledModificationCount = modificationCount;
+	}
+
 	void clear() {
+		markLeafSetModified();
+		TreeNodePoolScope poolScope(nodePool.get());
+		leafPaths.clear();
 		this->rootNode = TreeNode();
 	}
 
 	void add(TreeNode&& node) {
+		markLeafSetModified();
+		TreeNodePoolScope poolScope(nodePool.get());
 		if(isEmpty()) {
 			this->rootNode = std::move(node);
 		} else {
@@ -314,31 +430,49 @@ struct BoundsTree {
 	}
 	
 	void addToExistingGroup(Boundable* obj, const Bounds& bounds, TreeNode& groupNode) {
+		markLeafSetModified();
+		TreeNodePoolScope poolScope(nodePool.get());
 		groupNode.addInside(TreeNode(obj, bounds, false));
 	}
 
+	/*
+		Returns the stack leading to obj, objBounds only has to be correct if obj moved within the tree since it was last looked up
+	*/
 	NodeStack find(const Boundable* obj, const Bounds& objBounds) {
-		return NodeStack(rootNode, obj, objBounds);
+		NodeStack stack;
+		auto found = leafPaths.find(obj);
+		if(found != leafPaths.end() && stack.followPath(rootNode, found->second, obj)) {
+			return stack;
+		}
+		stack = NodeStack(rootNode, obj, objBounds);
+		if(stack.top - stack.stack <= TreeLeafPath::MAX_DEPTH) {
+			leafPaths[obj] = stack.getPath();
+		}
+		return stack;
 	}
 
 	NodeStack findGroupFor(const Boundable* obj, const Bounds& objBounds) {
-		NodeStack iter(rootNode, obj, objBounds);
+		NodeStack iter = find(obj, objBounds);
 		iter.riseUntilGroupHeadWhile();
 		return iter;
 	}
 
 	bool findAndReplaceObject(const Boundable* find, Boundable* replaceWith, const Bounds& objBounds) noexcept {
+		markLeafSetModified();
+		leafPaths.erase(find);
 		return rootNode.recursiveFindAndReplaceObject(find, replaceWith, objBounds);
 	}
 
 	void addToExistingGroup(Boundable* obj, const Bounds& bounds, const Boundable* objInGroup, const Bounds& objInGroupBounds) {
-		NodeStack iter(rootNode, objInGroup, objInGroupBounds);
+		NodeStack iter = find(objInGroup, objInGroupBounds);
 		iter.riseUntilGroupHeadWhile();
 		addToExistingGroup(obj, bounds, **iter);
 		iter.expandBoundsAllTheWayToTop();
 	}
 
 	void addToExistingGroup(TreeNode&& newNode, const Boundable* objInGroup, const Bounds& objInGroupBounds) {
+		markLeafSetModified();
+		TreeNodePoolScope poolScope(nodePool.get());
 		NodeStack stack = findGroupFor(objInGroup, objInGroupBounds);
 		TreeNode& group = **stack;
 		group.addInside(std::move(newNode));
@@ -346,8 +480,11 @@ struct BoundsTree {
 	}
 
 	void remove(const Boundable* obj, const Bounds& strictBounds) {
+		markLeafSetModified();
+		TreeNodePoolScope poolScope(nodePool.get());
 		if (rootNode.isLeafNode()) {
 			if (rootNode.object == obj) {
+				leafPaths.erase(obj);
 				rootNode.nodeCount = 0;
 				rootNode.bounds = Bounds();
 				rootNode.object = nullptr;
@@ -355,8 +492,9 @@ struct BoundsTree {
 				throw std::logic_error("Attempting to remove nonexistent object!");
 			}
 		} else {
-			NodeStack stack(rootNode, obj, strictBounds);
+			NodeStack stack = find(obj, strictBounds);
 			stack.remove();
+			leafPaths.erase(obj);
 		}
 	}
 	void moveOutOfGroup(const Boundable* obj, const Bounds& strictBounds) {
@@ -372,8 +510,11 @@ struct BoundsTree {
 
 	// removes and returns the node for the given object
 	inline TreeNode grab(const Boundable* obj, const Bounds& objBounds) {
+		markLeafSetModified();
+		TreeNodePoolScope poolScope(nodePool.get());
 		if(this->rootNode.isLeafNode()) {
 			if(this->rootNode.object == obj) {
+				leafPaths.erase(obj);
 				TreeNode result(std::move(this->rootNode));
 				this->rootNode.object = nullptr;
 				this->rootNode.nodeCount = 0;
@@ -382,14 +523,18 @@ struct BoundsTree {
 				throw std::logic_error("Attempting to remove nonexistent object!");
 			}
 		}
-		NodeStack iter(rootNode, obj, objBounds);
+		NodeStack iter = find(obj, objBounds);
+		leafPaths.erase(obj);
 		return iter.grab();
 	}
 
 	// removes and returns the group node for the given object
 	inline TreeNode grabGroupFor(const Boundable* obj, const Bounds& objBounds) {
+		markLeafSetModified();
+		TreeNodePoolScope poolScope(nodePool.get());
 		if(this->rootNode.isLeafNode()) {
 			if(this->rootNode.object == obj) {
+				leafPaths.erase(obj);
 				TreeNode result(std::move(this->rootNode));
 				this->rootNode.object = nullptr;
 				this->rootNode.nodeCount = 0;
@@ -398,13 +543,17 @@ struct BoundsTree {
 				throw std::logic_error("Attempting to remove nonexistent object!");
 			}
 		}
-		NodeStack iter(rootNode, obj, objBounds);
-		iter.riseUntilGroupHeadWhile();
-		return iter.grab();
+		NodeStack iter = findGroupFor(obj, objBounds);
+		TreeNode result = iter.grab();
+		for(TreeIterator leaf(result); leaf != IteratorEnd(); ++leaf) {
+			leafPaths.erase((*leaf)->object);
+		}
+		return result;
 	}
 
 	inline void recalculateBounds() {
 		if(isEmpty()) return;
+		markLeafSetModified();
 		for (TreeNode* currentNode : *this) {
 			Boundable* obj = static_cast<Boundable*>(currentNode->object);
 			currentNode->bounds = obj->getBounds();
@@ -412,30 +561,115 @@ struct BoundsTree {
 
 		rootNode.recalculateBoundsRecursive();
 	}
-	
+
 	inline void updateObjectBounds(const Boundable* obj, const Bounds& oldBounds) {
 		assert(!isEmpty());
-		NodeStack stack(rootNode, obj, oldBounds);
+		markModified();
+		NodeStack stack = find(obj, oldBounds);
 		stack.top->node->bounds = obj->getBounds();
+		recordLeafChange(obj, stack.top->node->bounds);
 		stack.top--;
 		stack.updateBoundsAllTheWayToTop();
 	}
 	inline void updateObjectGroupBounds(const Boundable* objInGroup, const Bounds& objOldBounds) {
 		assert(!isEmpty());
-		NodeStack stack(rootNode, objInGroup, objOldBounds);
+		markModified();
+		NodeStack stack = find(objInGroup, objOldBounds);
 		stack.riseUntilGroupHeadWhile(); // find group obj belongs to
 
 		for (TreeIterator iter(*stack.top->node); iter != IteratorEnd(); ++iter) {
 			TreeNode* node = *iter;
 			node->bounds = static_cast<Boundable*>(node->object)->getBounds();
+			recordLeafChange(node->object, node->bounds);
 		}
 		stack.top->node->recalculateBoundsRecursive(); // refresh group bounds
 		stack.top--;
 		stack.updateBoundsAllTheWayToTop(); // refresh rest of tree to accommodate
 	}
 
-	inline void improveStructure() { if(!isEmpty()) rootNode.improveStructure(); }
+	/*
+		Same as updateObjectGroupBounds, except that the nodes above the group are only marked as outdated
+		After moving many objects, refitOutdatedBounds then recalculates every affected node exactly once, 
+		instead of once for every object below it. Until then the tree can only be used to find other objects by their old bounds. 
+
+		leafBounds(const Boundable& obj, const Bounds& currentLeafBounds) returns the bounds to be stored for obj, it must contain obj.getBounds()
+		Only if it differs from currentLeafBounds for any object in the group is anything above the group touched, in which case this returns true
+	*/
+	template<typename LeafBounds>
+	inline bool markObjectGroupBoundsOutdated(const Boundable* objInGroup, const Bounds& objOldBounds, const LeafBounds& leafBounds) {
+		assert(!isEmpty());
+		NodeStack stack = find(objInGroup, objOldBounds);
+		stack.riseUntilGroupHeadWhile(); // find group obj belongs to
+
+		bool anyChanged = false;
+		for (TreeIterator iter(*stack.top->node); iter != IteratorEnd(); ++iter) {
+			TreeNode* node = *iter;
+			Bounds newBounds = leafBounds(*static_cast<const Boundable*>(node->object), node->bounds);
+			if(newBounds != node->bounds) {
+				node->bounds = newBounds;
+				recordLeafChange(node->object, newBounds);
+				anyChanged = true;
+			}
+		}
+		if(!anyChanged) return false;
+
+		markModified();
+		stack.top->node->recalculateBoundsRecursive(); // refresh group bounds
+		stack.top--;
+		stack.markBoundsOutdatedAllTheWayToTop();
+		return true;
+	}
+	inline bool markObjectGroupBoundsOutdated(const Boundable* objInGroup, const Bounds& objOldBounds) {
+		return markObjectGroupBoundsOutdated(objInGroup, objOldBounds, [](const Boundable& obj, const Bounds&) {return obj.getBounds(); });
+	}
+	/*
+		Recalculates the nodes marked by markObjectGroupBoundsOutdated, returns false if there were none
+	*/
+	inline bool refitOutdatedBounds() {
+		if(!rootNode.hasOutdatedBounds) return false;
+		markModified();
+		rootNode.refitOutdatedBoundsRecursive();
+		return true;
+	}
+
+	inline void improveStructure() {
+		if(isEmpty()) return;
+		markModified();
+		TreeNodePoolScope poolScope(nodePool.get());
+		rootNode.improveStructure();
+	}
+	/*
+		Replaces the whole tree with one built from scratch by buildTreeTopDown, keeping all groups intact
+		Much better than repeated improveStructure calls after adding many objects at once
+	*/
+	void rebuild(ThreadPool* pool = nullptr) {
+		if(isEmpty()) return;
+		markModified();
+		TreeNodePoolScope poolScope(nodePool.get());
+		refitOutdatedBounds();
+		std::vector<TreeNode> topLevelNodes;
+		collectTopLevelNodes(rootNode, topLevelNodes);
+		// free the old structure first, so the new one can reuse its blocks
+		rootNode = TreeNode();
+		rootNode = buildTreeTopDown(topLevelNodes.data(), topLevelNodes.size(), pool);
+		improveStructureCursor = StructureImprovementCursor();
+	}
+	/*
+		Improves the structure of at most nodeBudget nodes, in the same bottom up order as improveStructure,
+		continuing from where the previous call stopped. A call never goes past the root, so it can improve fewer nodes than nodeBudget
+		returns the number of nodes improved
+	*/
+	inline size_t improveStructure(size_t nodeBudget) { 
+		if(isEmpty()) return 0;
+		markModified();
+		TreeNodePoolScope poolScope(nodePool.get());
+		return rootNode.improveStructure(nodeBudget, improveStructureCursor);
+	}
 	
+	inline TreeNodePoolStatistics getNodePoolStatistics() const {
+		return nodePool->getStatistics();
+	}
+
 	inline size_t getNumberOfObjects() const {
 		if(isEmpty()) {
 			return 0;
@@ -444,6 +678,31 @@ struct BoundsTree {
 		}
 	}
 
+	/*
+		Calls func(Boundable& obj) for every object whose bounds intersect the given bounds
+		The compiled tree is used if it is up to date
+	*/
+	template<typename Func>
+	void forEachInBounds(const Bounds& bounds, const Func& func) {
+		if(isCompiledUpToDate()) {
+			compiled.forEachInBounds(bounds, [&func](void* obj) {func(*static_cast<Boundable*>(obj)); });
+		} else if(!isEmpty()) {
+			forEachInBoundsRecursive(rootNode, bounds, func);
+		}
+	}
+	/*
+		Calls func(Boundable& obj) for every object whose bounds are hit by the given ray
+		The compiled tree is used if it is up to date
+	*/
+	template<typename Func>
+	void forEachOnRay(const Ray& ray, const Func& func) {
+		if(isCompiledUpToDate()) {
+			compiled.forEachOnRay(ray, [&func](void* obj) {func(*static_cast<Boundable*>(obj)); });
+		} else if(!isEmpty()) {
+			forEachOnRayRecursive(rootNode, ray, func);
+		}
+	}
+
 	inline TreeIterator begin() { return TreeIterator(rootNode); };
 	inline ConstTreeIterator begin() const { return ConstTreeIterator(const_cast<TreeNode&>(rootNode)); };
 	inline IteratorEnd end() const { return IteratorEnd(); };
@@ -453,6 +712,46 @@ struct BoundsTree {
 
 	template<typename Filter>
 	inline TreeIterFactory<const Boundable, Filter> iterFiltered(const Filter& filter) const;
+
+private:
+	inline void markLeafSetModified() {
+		markModified();
+		leafChangesIncomplete = true;
+	}
+	inline void recordLeafChange(const void* object, const Bounds& bounds) {
+		if(!trackLeafChanges || leafChangesIncomplete) return;
+		if(changedLeaves.size() >= MAX_TRACKED_LEAF_CHANGES) {
+			changedLeaves.clear();
+			leafChangesIncomplete = true;
+			return;
+		}
+		changedLeaves.push_back(LeafChange{object, bounds});
+	}
+
+	template<typename Func>
+	static void forEachInBoundsRecursive(const TreeNode& node, const Bounds& bounds, const Func& func) {
+		if(!intersects(node.bounds, bounds)) return;
+		if(node.isLeafNode()) {
+			func(*static_cast<Boundable*>(node.object));
+		} else {
+			for(const TreeNode& subNode : node) {
+				forEachInBoundsRecursive(subNode, bounds, func);
+			}
+		}
+	}
+	template<typename Func>
+	static void forEachOnRayRecursive(const TreeNode& node, const Ray& ray, const Func& func) {
+		Position intersection;
+		double distance;
+		if(!doRayAndBoundsIntersect(node.bounds, ray, intersection, distance)) return;
+		if(node.isLeafNode()) {
+			func(*static_cast<Boundable*>(node.object));
+		} else {
+			for(const TreeNode& subNode : node) {
+				forEachOnRayRecursive(subNode, ray, func);
+			}
+		}
+	}
 };
 
 template<typename Boundable, typename Filter>
@@ -0,0 +1,200 @@
+#include "boundsTree.h"
+
+#include "../threading/threadPool.h"
+
+#include <algorithm>
+#include <limits>
+
+#define SAH_BIN_COUNT 16
+// past this depth ranges are split at the median, so a run of lopsided SAH splits can't exceed MAX_HEIGHT
+#define SAH_MAX_DEPTH 24
+// subtrees of fewer nodes than this are never handed out as a separate task
+#define PARALLEL_BUILD_MIN_NODES 256
+
+namespace {
+struct NodeRange {
+	TreeNode* nodes;
+	size_t count;
+};
+
+struct BuildTask {
+	TreeNode* nodes;
+	size_t count;
+	TreeNode* result;
+	int depth;
+};
+
+struct Bin {
+	Bounds bounds;
+	size_t count = 0;
+};
+}
+
+static double surfaceArea(const Bounds& bounds) {
+	double w = bounds.getWidth();
+	double h = bounds.getHeight();
+	double d = bounds.getDepth();
+	return w * h + h * d + d * w;
+}
+
+static Vec3 centroid(const TreeNode& node) {
+	return castPositionToVec3(node.bounds.getCenter());
+}
+
+static void splitAtMedian(TreeNode* nodes, size_t count, const Vec3& centroidMin, const Vec3& centroidMax) {
+	Vec3 extent = centroidMax - centroidMin;
+	int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+	std::nth_element(nodes, nodes + count / 2, nodes + count, [axis](const TreeNode& a, const TreeNode& b) {
+		return centroid(a)[axis] < centroid(b)[axis];
+	});
+}
+
+/*
+	Reorders the nodes so that [0, split) and [split, count) lie on either side of the cheapest binned SAH plane, returns split
+*/
+static size_t splitSAH(TreeNode* nodes, size_t count, int depth) {
+	Vec3 centroidMin = centroid(nodes[0]);
+	Vec3 centroidMax = centroidMin;
+	for(size_t i = 1; i < count; i++) {
+		Vec3 c = centroid(nodes[i]);
+		for(int axis = 0; axis < 3; axis++) {
+			centroidMin[axis] = std::min(centroidMin[axis], c[axis]);
+			centroidMax[axis] = std::max(centroidMax[axis], c[axis]);
+		}
+	}
+
+	if(depth >= SAH_MAX_DEPTH) {
+		splitAtMedian(nodes, count, centroidMin, centroidMax);
+		return count / 2;
+	}
+
+	double bestCost = std::numeric_limits<double>::infinity();
+	int bestAxis = -1;
+	int bestBin = 0;
+	for(int axis = 0; axis < 3; axis++) {
+		double extent = centroidMax[axis] - centroidMin[axis];
+		if(extent <= 0.0) continue;
+		double binScale = SAH_BIN_COUNT / extent;
+
+		Bin bins[SAH_BIN_COUNT];
+		for(size_t i = 0; i < count; i++) {
+			int b = std::min(static_cast<int>((centroid(nodes[i])[axis] - centroidMin[axis]) * binScale), SAH_BIN_COUNT - 1);
+			bins[b].bounds = (bins[b].count == 0) ? nodes[i].bounds : unionOfBounds(bins[b].bounds, nodes[i].bounds);
+			bins[b].count++;
+		}
+
+		// rightCost[i] is the cost of everything in bins past i
+		double rightCost[SAH_BIN_COUNT];
+		Bounds rightBounds;
+		size_t rightCount = 0;
+		for(int i = SAH_BIN_COUNT - 1; i > 0; i--) {
+			if(bins[i].count != 0) {
+				rightBounds = (rightCount == 0) ? bins[i].bounds : unionOfBounds(rightBounds, bins[i].bounds);
+				rightCount += bins[i].count;
+			}
+			rightCost[i - 1] = (rightCount == 0) ? 0.0 : surfaceArea(rightBounds) * rightCount;
+		}
+
+		Bounds leftBounds;
+		size_t leftCount = 0;
+		for(int i = 0; i < SAH_BIN_COUNT - 1; i++) {
+			if(bins[i].count != 0) {
+				leftBounds = (leftCount == 0) ? bins[i].bounds : unionOfBounds(leftBounds, bins[i].bounds);
+				leftCount += bins[i].count;
+			}
+			if(leftCount == 0 || leftCount == count) continue;
+			double cost = surfaceArea(leftBounds) * leftCount + rightCost[i];
+			if(cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = i;
+			}
+		}
+	}
+
+	if(bestAxis == -1) {
+		// all centroids coincide, no plane separates them
+		return count / 2;
+	}
+
+	double binScale = SAH_BIN_COUNT / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+	TreeNode* split = std::partition(nodes, nodes + count, [&](const TreeNode& node) {
+		return std::min(static_cast<int>((centroid(node)[bestAxis] - centroidMin[bestAxis]) * binScale), SAH_BIN_COUNT - 1) <= bestBin;
+	});
+	return split - nodes;
+}
+
+/*
+	Builds the subtree for the given nodes into result. The nodes are split into up to MAX_BRANCHES ranges by repeatedly splitting the largest one.
+	If tasks is not null, ranges that are small enough are left for the caller to build by pushing them onto tasks.
+	The bounds of newly created nodes are left for the caller to compute once the whole tree is built
+*/
+static void buildNode(TreeNode* nodes, size_t count, TreeNode& result, int depth, std::vector<BuildTask>* tasks, size_t taskSize) {
+	if(count == 1) {
+		result = std::move(nodes[0]);
+		return;
+	}
+
+	NodeRange ranges[MAX_BRANCHES];
+	int rangeCount = 0;
+	if(count <= MAX_BRANCHES) {
+		for(size_t i = 0; i < count; i++) {
+			ranges[rangeCount++] = NodeRange{nodes + i, 1};
+		}
+	} else {
+		ranges[rangeCount++] = NodeRange{nodes, count};
+		while(rangeCount < MAX_BRANCHES) {
+			int largest = 0;
+			for(int i = 1; i < rangeCount; i++) {
+				if(ranges[i].count > ranges[largest].count) largest = i;
+			}
+			NodeRange r = ranges[largest];
+			size_t split = splitSAH(r.nodes, r.count, depth);
+			ranges[largest] = NodeRange{r.nodes, split};
+			ranges[rangeCount++] = NodeRange{r.nodes + split, r.count - split};
+		}
+	}
+
+	TreeNode* subTrees = allocateSubTrees();
+	for(int i = 0; i < rangeCount; i++) {
+		if(tasks != nullptr && ranges[i].count > 1 && ranges[i].count <= taskSize) {
+			tasks->push_back(BuildTask{ranges[i].nodes, ranges[i].count, &subTrees[i], depth + 1});
+		} else {
+			buildNode(ranges[i].nodes, ranges[i].count, subTrees[i], depth + 1, tasks, taskSize);
+		}
+	}
+	result = TreeNode(Bounds(), subTrees, rangeCount);
+}
+
+TreeNode buildTreeTopDown(TreeNode* nodes, size_t count, ThreadPool* pool) {
+	assert(count != 0);
+	TreeNode root;
+	if(pool == nullptr || pool->getThreadCount() == 1 || count < 2 * PARALLEL_BUILD_MIN_NODES) {
+		buildNode(nodes, count, root, 0, nullptr, 0);
+	} else {
+		// the upper levels are built here, everything below is split into tasks of at most taskSize nodes
+		// the split decisions don't depend on who builds a subtree, so the resulting tree is the same for any thread count
+		size_t taskSize = std::max<size_t>(PARALLEL_BUILD_MIN_NODES, count / (pool->getThreadCount() * 8));
+		std::vector<BuildTask> tasks;
+		buildNode(nodes, count, root, 0, &tasks, taskSize);
+		// the workers allocate from the same node pool as the calling thread
+		TreeNodePool* nodePool = TreeNodePoolScope::getCurrentPool();
+		pool->parallelFor(tasks.size(), [&tasks, nodePool](size_t taskIndex, size_t workerIndex) {
+			TreeNodePoolScope poolScope(nodePool);
+			const BuildTask& task = tasks[taskIndex];
+			buildNode(task.nodes, task.count, *task.result, task.depth, nullptr, 0);
+		});
+	}
+	root.recalculateBoundsRecursive();
+	return root;
+}
+
+void collectTopLevelNodes(TreeNode& node, std::vector<TreeNode>& output) {
+	if(node.isLeafNode() || node.isGroupHead) {
+		output.push_back(std::move(node));
+	} else {
+		for(TreeNode& subNode : node) {
+			collectTopLevelNodes(subNode, output);
+		}
+	}
+}
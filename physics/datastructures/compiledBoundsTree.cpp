@@ -0,0 +1,71 @@
+#include "compiledBoundsTree.h"
+
+#include "boundsTree.h"
+
+#include "../simd/simdKernels.h"
+
+#include <limits>
+
+static_assert(MAX_BRANCHES == 4, "CompiledBoundsTree::Node stores exactly 4 children");
+
+void CompiledBoundsTree::compile(const TreeNode& rootNode) {
+	nodes.clear();
+	leafObjects.clear();
+	empty = rootNode.nodeCount == 0;
+	if(empty) return;
+
+	root.ref = compileRecursive(rootNode);
+	root.bounds = rootNode.bounds;
+	root.cost = computeCost(rootNode.bounds);
+	root.isGroupHead = rootNode.isGroupHead;
+}
+
+CompiledBoundsTree::ChildRef CompiledBoundsTree::compileRecursive(const TreeNode& node) {
+	if(node.isLeafNode()) {
+		leafObjects.push_back(node.object);
+		return ~static_cast<ChildRef>(leafObjects.size() - 1);
+	}
+
+	ChildRef index = static_cast<ChildRef>(nodes.size());
+	nodes.emplace_back();
+
+	Node compiled;
+	compiled.childCount = node.nodeCount;
+	compiled.groupHeadMask = 0;
+	for(int i = 0; i < 4; i++) {
+		if(i < node.nodeCount) {
+			const TreeNode& subNode = node[i];
+			const Bounds& b = subNode.bounds;
+			compiled.minX[i] = b.min.x.value; compiled.minY[i] = b.min.y.value; compiled.minZ[i] = b.min.z.value;
+			compiled.maxX[i] = b.max.x.value; compiled.maxY[i] = b.max.y.value; compiled.maxZ[i] = b.max.z.value;
+			compiled.cost[i] = computeCost(b);
+			compiled.children[i] = compileRecursive(subNode);
+			if(subNode.isGroupHead) compiled.groupHeadMask |= 1 << i;
+		} else {
+			// empty slots can't intersect anything
+			compiled.minX[i] = compiled.minY[i] = compiled.minZ[i] = std::numeric_limits<int64_t>::max();
+			compiled.maxX[i] = compiled.maxY[i] = compiled.maxZ[i] = std::numeric_limits<int64_t>::min();
+			compiled.cost[i] = 0;
+			compiled.children[i] = 0;
+		}
+	}
+	// the recursion may have reallocated nodes
+	nodes[index] = compiled;
+	return index;
+}
+
+CompiledBoundsTree::Child CompiledBoundsTree::getChild(const Node& node, int index) const {
+	Child result;
+	result.ref = node.children[index];
+	result.bounds = Bounds(
+		Position(Fix<32>(node.minX[index]), Fix<32>(node.minY[index]), Fix<32>(node.minZ[index])), 
+		Position(Fix<32>(node.maxX[index]), Fix<32>(node.maxY[index]), Fix<32>(node.maxZ[index]))
+	);
+	result.cost = node.cost[index];
+	result.isGroupHead = (node.groupHeadMask & (1 << index)) != 0;
+	return result;
+}
+
+int CompiledBoundsTree::intersectingChildren(const Node& node, const Bounds& bounds) {
+	return getSIMDKernels().intersectingChildren(node, bounds);
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "../math/bounds.h"
+#include "../math/ray.h"
+
+#include <vector>
+#include <cstdint>
+
+struct TreeNode;
+
+// index of the lowest set bit of a nonzero child mask
+inline int lowestChildInMask(int mask) {
+	int index = 0;
+	while((mask & (1 << index)) == 0) index++;
+	return index;
+}
+
+/*
+	Read only copy of a bounds tree, laid out for fast queries
+
+	All nodes sit in one array, each node holds the bounds of its up to 4 children with one array per coordinate,
+	so a box can be tested against all children of a node at once with SIMD instructions.
+	The bounds are stored as the raw Fix<32> values of the tree, so every test gives exactly the same result as on the tree itself
+*/
+struct CompiledBoundsTree {
+	// index into nodes if >= 0, ~index into leafObjects if < 0
+	using ChildRef = int32_t;
+
+	struct alignas(32) Node {
+		int64_t minX[4];
+		int64_t minY[4];
+		int64_t minZ[4];
+		int64_t maxX[4];
+		int64_t maxY[4];
+		int64_t maxZ[4];
+		// computeCost of the bounds of each child
+		long long cost[4];
+		ChildRef children[4];
+		int childCount;
+		// bit i is set if child i is a group head
+		int groupHeadMask;
+	};
+
+	/*
+		A child together with the bounds that its parent stores for it
+	*/
+	struct Child {
+		ChildRef ref;
+		Bounds bounds;
+		long long cost;
+		bool isGroupHead;
+
+		inline bool isLeafNode() const { return ref < 0; }
+	};
+
+	std::vector<Node> nodes;
+	std::vector<void*> leafObjects;
+	// the root has no parent to store its bounds
+	Child root;
+	bool empty = true;
+
+	/*
+		Replaces the contents with a copy of the tree below rootNode, the existing buffers are reused
+	*/
+	void compile(const TreeNode& rootNode);
+
+	inline bool isEmpty() const { return empty; }
+	inline const Node& getNode(const Child& child) const { return nodes[child.ref]; }
+	inline void* getObject(const Child& leaf) const { return leafObjects[~leaf.ref]; }
+	Child getChild(const Node& node, int index) const;
+
+	/*
+		Returns a bitmask of the children of node whose bounds intersect the given bounds, in the same way as intersects(Bounds, Bounds)
+	*/
+	static int intersectingChildren(const Node& node, const Bounds& bounds);
+
+	/*
+		Calls func(void* object) for every object whose bounds intersect the given bounds
+	*/
+	template<typename Func>
+	void forEachInBounds(const Bounds& bounds, const Func& func) const {
+		if(empty || !intersects(root.bounds, bounds)) return;
+		forEachInBoundsRecursive(root, bounds, func);
+	}
+
+	/*
+		Calls func(void* object) for every object whose bounds are hit by the given ray, as tested by doRayAndBoundsIntersect
+	*/
+	template<typename Func>
+	void forEachOnRay(const Ray& ray, const Func& func) const {
+		if(empty || !hitsBounds(ray, root.bounds)) return;
+		forEachOnRayRecursive(root, ray, func);
+	}
+
+private:
+	ChildRef compileRecursive(const TreeNode& node);
+
+	static inline bool hitsBounds(const Ray& ray, const Bounds& bounds) {
+		Position p;
+		double d;
+		return doRayAndBoundsIntersect(bounds, ray, p, d);
+	}
+
+	template<typename Func>
+	void forEachInBoundsRecursive(const Child& child, const Bounds& bounds, const Func& func) const {
+		if(child.isLeafNode()) {
+			func(getObject(child));
+			return;
+		}
+		const Node& node = getNode(child);
+		for(int mask = intersectingChildren(node, bounds); mask != 0; mask &= mask - 1) {
+			forEachInBoundsRecursive(getChild(node, lowestChildInMask(mask)), bounds, func);
+		}
+	}
+
+	template<typename Func>
+	void forEachOnRayRecursive(const Child& child, const Ray& ray, const Func& func) const {
+		if(child.isLeafNode()) {
+			func(getObject(child));
+			return;
+		}
+		const Node& node = getNode(child);
+		for(int i = 0; i < node.childCount; i++) {
+			Child subChild = getChild(node, i);
+			if(hitsBounds(ray, subChild.bounds)) {
+				forEachOnRayRecursive(subChild, ray, func);
+			}
+		}
+	}
+};
@@ -0,0 +1,127 @@
+#include "treeNodePool.h"
+
+#include "boundsTree.h"
+
+#include <new>
+#include <cstdint>
+
+#define TREE_NODE_SLAB_SIZE 16384
+
+namespace {
+struct SlabHeader {
+	TreeNodePool* pool;
+};
+}
+
+static constexpr size_t BLOCK_SIZE = sizeof(TreeNode) * MAX_BRANCHES;
+// the header takes up the first few blocks of every slab
+static constexpr size_t HEADER_BLOCKS = (sizeof(SlabHeader) + BLOCK_SIZE - 1) / BLOCK_SIZE;
+static constexpr size_t BLOCKS_PER_SLAB = TREE_NODE_SLAB_SIZE / BLOCK_SIZE;
+static_assert(BLOCKS_PER_SLAB > HEADER_BLOCKS, "a slab must fit at least one block");
+static_assert(BLOCK_SIZE % alignof(TreeNode) == 0, "blocks must keep the alignment of TreeNode");
+
+static thread_local TreeNodePool* currentPool = nullptr;
+
+static TreeNodePool* getSharedPool() {
+	// never released, trees that outlive this function's static storage may still hand blocks back
+	static TreeNodePool* sharedPool = TreeNodePool::create();
+	return sharedPool;
+}
+
+static SlabHeader* getSlabOf(const void* block) {
+	return reinterpret_cast<SlabHeader*>(reinterpret_cast<uintptr_t>(block) & ~static_cast<uintptr_t>(TREE_NODE_SLAB_SIZE - 1));
+}
+
+TreeNodePool* TreeNodePool::create() {
+	return new TreeNodePool();
+}
+
+TreeNodePool::~TreeNodePool() {
+	for(void* slab : slabs) {
+		::operator delete(slab, std::align_val_t(TREE_NODE_SLAB_SIZE));
+	}
+}
+
+void TreeNodePool::release() {
+	bool unused;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		released = true;
+		unused = statistics.getBlocksInUse() == 0;
+	}
+	if(unused) delete this;
+}
+
+void* TreeNodePool::allocateBlock() {
+	std::lock_guard<std::mutex> lock(mutex);
+	if(freeList == nullptr) {
+		char* slab = static_cast<char*>(::operator new(TREE_NODE_SLAB_SIZE, std::align_val_t(TREE_NODE_SLAB_SIZE)));
+		new(slab) SlabHeader{this};
+		slabs.push_back(slab);
+		statistics.slabsAllocated++;
+		// pushed in reverse, so consecutive allocations get consecutive blocks
+		for(size_t i = BLOCKS_PER_SLAB; i-- > HEADER_BLOCKS;) {
+			FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + i * BLOCK_SIZE);
+			block->next = freeList;
+			freeList = block;
+		}
+	}
+	FreeBlock* block = freeList;
+	freeList = block->next;
+	statistics.blocksAllocated++;
+	return block;
+}
+
+void TreeNodePool::giveBack(void* block) {
+	bool unused;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+		freeBlock->next = freeList;
+		freeList = freeBlock;
+		statistics.blocksFreed++;
+		unused = released && statistics.getBlocksInUse() == 0;
+	}
+	if(unused) delete this;
+}
+
+void TreeNodePool::freeBlock(void* block) {
+	getPoolOf(block)->giveBack(block);
+}
+
+TreeNodePool* TreeNodePool::getPoolOf(const void* block) {
+	return getSlabOf(block)->pool;
+}
+
+TreeNodePoolStatistics TreeNodePool::getStatistics() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return statistics;
+}
+
+TreeNodePoolScope::TreeNodePoolScope(TreeNodePool* pool) : previous(currentPool) {
+	currentPool = pool;
+}
+
+TreeNodePoolScope::~TreeNodePoolScope() {
+	currentPool = previous;
+}
+
+TreeNodePool* TreeNodePoolScope::getCurrentPool() {
+	return (currentPool != nullptr) ? currentPool : getSharedPool();
+}
+
+TreeNode* allocateSubTrees() {
+	TreeNode* subTrees = static_cast<TreeNode*>(TreeNodePoolScope::getCurrentPool()->allocateBlock());
+	for(int i = 0; i < MAX_BRANCHES; i++) {
+		new(subTrees + i) TreeNode();
+	}
+	return subTrees;
+}
+
+void freeSubTrees(TreeNode* subTrees) {
+	if(subTrees == nullptr) return;
+	for(int i = 0; i < MAX_BRANCHES; i++) {
+		subTrees[i].~TreeNode();
+	}
+	TreeNodePool::freeBlock(subTrees);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+struct TreeNodePoolStatistics {
+	size_t blocksAllocated;
+	size_t blocksFreed;
+	// slabs requested from the system allocator, every other allocation is served from the free list
+	size_t slabsAllocated;
+
+	inline size_t getBlocksInUse() const { return blocksAllocated - blocksFreed; }
+};
+
+/*
+	Thread safe pool for the MAX_BRANCHES sized subTrees blocks of TreeNodes
+	Blocks are carved out of large slabs and freed blocks go onto a free list, so once a tree has reached its size,
+	restructuring it no longer goes to the system allocator, and the nodes of one tree stay close together in memory.
+
+	Slabs are aligned to their size and start with a pointer to their pool, so a block can be given back by its address alone,
+	~TreeNode doesn't need to know which tree it belonged to.
+	Nodes can move from one tree to another, so a pool only goes away once its owner has released it and all its blocks are freed.
+*/
+class TreeNodePool {
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	std::mutex mutex;
+	FreeBlock* freeList = nullptr;
+	std::vector<void*> slabs;
+	TreeNodePoolStatistics statistics{0, 0, 0};
+	bool released = false;
+
+	TreeNodePool() = default;
+	~TreeNodePool();
+
+	void giveBack(void* block);
+public:
+	TreeNodePool(const TreeNodePool&) = delete;
+	TreeNodePool& operator=(const TreeNodePool&) = delete;
+
+	static TreeNodePool* create();
+	/*
+		Used by the owner instead of delete, the pool is deleted once the last of its blocks is freed
+	*/
+	void release();
+
+	/*
+		Returns uninitialized memory for one block
+	*/
+	void* allocateBlock();
+	/*
+		Returns a block to the pool it came from
+	*/
+	static void freeBlock(void* block);
+	static TreeNodePool* getPoolOf(const void* block);
+
+	TreeNodePoolStatistics getStatistics();
+};
+
+struct TreeNodePoolReleaser {
+	inline void operator()(TreeNodePool* pool) const { pool->release(); }
+};
+using TreeNodePoolHandle = std::unique_ptr<TreeNodePool, TreeNodePoolReleaser>;
+
+/*
+	Makes new blocks allocated on this thread come from the given pool until the scope ends
+	Outside of any scope, or with a null pool, they come from a shared pool that is never released
+*/
+class TreeNodePoolScope {
+	TreeNodePool* previous;
+public:
+	explicit TreeNodePoolScope(TreeNodePool* pool);
+	~TreeNodePoolScope();
+
+	TreeNodePoolScope(const TreeNodePoolScope&) = delete;
+	TreeNodePoolScope& operator=(const TreeNodePoolScope&) = delete;
+
+	static TreeNodePool* getCurrentPool();
+};
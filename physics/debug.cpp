@@ -7,9 +7,11 @@
 #include <fstream>
 #include <chrono>
 #include <sstream>
+#include <mutex>
 
 #include "../util/log.h"
 #include "misc/toString.h"
+#include "profiling.h"
 
 namespace Debug {
 	void(*logVecAction)(Position, Vec3, VectorType) = [](Position, Vec3, VectorType) {};
@@ -17,10 +19,22 @@ namespace Debug {
 	void(*logCFrameAction)(CFrame, CFrameType) = [](CFrame, CFrameType) {};
 	void(*logShapeAction)(const Polyhedron&, const GlobalCFrame&) = [](const Polyhedron&, const GlobalCFrame&) {};
 	
-	void logVector(Position origin, Vec3 vec, VectorType type) { logVecAction(origin, vec, type); };
-	void logPoint(Position point, PointType type) { logPointAction(point, type); }
-	void logCFrame(CFrame frame, CFrameType type) { logCFrameAction(frame, type); };
-	void logShape(const Polyhedron& shape, const GlobalCFrame& location) { logShapeAction(shape, location); };
+	// the log actions don't have to be thread safe, so calls made from within a parallel section are serialized
+	std::mutex logMutex;
+	template<typename Action, typename... Args>
+	inline void callLogAction(Action action, const Args&... args) {
+		if(currentProfilingWorker < 0) {
+			action(args...);
+		} else {
+			std::lock_guard<std::mutex> lock(logMutex);
+			action(args...);
+		}
+	}
+	
+	void logVector(Position origin, Vec3 vec, VectorType type) { callLogAction(logVecAction, origin, vec, type); };
+	void logPoint(Position point, PointType type) { callLogAction(logPointAction, point, type); }
+	void logCFrame(CFrame frame, CFrameType type) { callLogAction(logCFrameAction, frame, type); };
+	void logShape(const Polyhedron& shape, const GlobalCFrame& location) { callLogAction(logShapeAction, shape, location); };
 
 	void setVectorLogAction(void(*logger)(Position origin, Vec3 vec, VectorType type)) { logVecAction = logger; };
 	void setPointLogAction(void(*logger)(Position point, PointType type)) { logPointAction = logger; }
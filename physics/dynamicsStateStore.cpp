@@ -0,0 +1,98 @@
+#include "dynamicsStateStore.h"
+
+#include <algorithm>
+#include <cassert>
+
+// force, moment, forceResponse, momentResponse, rotation, velocity, angularVelocity, velocityStep, acceleration, angularAcceleration
+#define DYNAMICS_COMPONENT_COUNT (3 + 3 + 6 + 6 + 9 + 3 + 3 + 3 + 3 + 3)
+
+static void assignComponents(double** components, int count, double*& next, size_t capacity) {
+	for(int i = 0; i < count; i++) {
+		components[i] = next;
+		next += capacity;
+	}
+}
+
+void DynamicsStateStore::grow(size_t newCapacity) {
+	std::vector<double> newData(newCapacity * DYNAMICS_COMPONENT_COUNT, 0.0);
+	for(size_t c = 0; c < DYNAMICS_COMPONENT_COUNT; c++) {
+		std::copy(data.begin() + c * capacity, data.begin() + c * capacity + size, newData.begin() + c * newCapacity);
+	}
+	data = std::move(newData);
+	capacity = newCapacity;
+
+	double* next = data.data();
+	assignComponents(arrays.force, 3, next, capacity);
+	assignComponents(arrays.moment, 3, next, capacity);
+	assignComponents(arrays.forceResponse, 6, next, capacity);
+	assignComponents(arrays.momentResponse, 6, next, capacity);
+	assignComponents(arrays.rotation, 9, next, capacity);
+	assignComponents(arrays.velocity, 3, next, capacity);
+	assignComponents(arrays.angularVelocity, 3, next, capacity);
+	assignComponents(arrays.velocityStep, 3, next, capacity);
+	assignComponents(acceleration, 3, next, capacity);
+	assignComponents(angularAcceleration, 3, next, capacity);
+}
+
+size_t DynamicsStateStore::add(const DynamicsState& state) {
+	if(size == capacity) {
+		grow(std::max(size_t(16), capacity * 2));
+	}
+	size_t index = size++;
+	set(index, state);
+	return index;
+}
+
+DynamicsState DynamicsStateStore::remove(size_t index) {
+	assert(index < size);
+	DynamicsState removed = get(index);
+	size--;
+	if(index != size) {
+		for(size_t c = 0; c < DYNAMICS_COMPONENT_COUNT; c++) {
+			double* component = data.data() + c * capacity;
+			component[index] = component[size];
+		}
+	}
+	return removed;
+}
+
+void DynamicsStateStore::clear() {
+	size = 0;
+}
+
+DynamicsState DynamicsStateStore::get(size_t index) const {
+	DynamicsState state;
+	state.totalForce = getForce(index);
+	state.totalMoment = getMoment(index);
+	state.forceResponse = getForceResponse(index);
+	state.momentResponse = getMomentResponse(index);
+	state.motionOfCenterOfMass = getMotion(index);
+	return state;
+}
+
+void DynamicsStateStore::set(size_t index, const DynamicsState& state) {
+	setForce(index, state.totalForce);
+	setMoment(index, state.totalMoment);
+	setForceResponse(index, state.forceResponse);
+	setMomentResponse(index, state.momentResponse);
+	setMotion(index, state.motionOfCenterOfMass);
+}
+
+Motion DynamicsStateStore::getMotion(size_t index) const {
+	return Motion(getVelocity(index), getAngularVelocity(index), getVec3(acceleration, index), getVec3(angularAcceleration, index));
+}
+
+void DynamicsStateStore::setMotion(size_t index, const Motion& motion) {
+	setVelocity(index, motion.getVelocity());
+	setAngularVelocity(index, motion.getAngularVelocity());
+	setVec3(acceleration, index, motion.getAcceleration());
+	setVec3(angularAcceleration, index, motion.getAngularAcceleration());
+}
+
+void DynamicsStateStore::setRotation(size_t index, const Mat3& rotation) {
+	for(int row = 0; row < 3; row++) {
+		for(int col = 0; col < 3; col++) {
+			arrays.rotation[row * 3 + col][index] = rotation(row, col);
+		}
+	}
+}
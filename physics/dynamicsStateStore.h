@@ -0,0 +1,101 @@
+#pragma once
+
+#include "math/linalg/vec.h"
+#include "math/linalg/mat.h"
+#include "motion.h"
+#include "simd/simdKernels.h"
+
+#include <vector>
+#include <cstddef>
+
+/*
+	The state of a MotorizedPhysical that turns the forces on it into motion
+*/
+struct DynamicsState {
+	Vec3 totalForce = Vec3(0.0, 0.0, 0.0);
+	Vec3 totalMoment = Vec3(0.0, 0.0, 0.0);
+	SymmetricMat3 forceResponse;
+	SymmetricMat3 momentResponse;
+	Motion motionOfCenterOfMass;
+};
+
+/*
+	Owns the DynamicsState of all MotorizedPhysicals of a world, as a structure of arrays with one contiguous array per scalar component
+	The world keeps the state of physicals[i] at index i, which the physical remembers as its dynamicsIndex
+	so the velocity step of consecutive physicals runs as one SIMD kernel over the arrays, see SIMDKernels::integrateVelocities
+*/
+class DynamicsStateStore {
+	// component c of all bodies starts at c * capacity
+	std::vector<double> data;
+	size_t capacity = 0;
+	size_t size = 0;
+	DynamicsStateArrays arrays{};
+	double* acceleration[3]{};
+	double* angularAcceleration[3]{};
+
+	void grow(size_t newCapacity);
+
+	static inline Vec3 getVec3(double* const* components, size_t index) {
+		return Vec3(components[0][index], components[1][index], components[2][index]);
+	}
+	static inline void setVec3(double* const* components, size_t index, const Vec3& value) {
+		components[0][index] = value[0];
+		components[1][index] = value[1];
+		components[2][index] = value[2];
+	}
+	static inline SymmetricMat3 getSymmetric(double* const* components, size_t index) {
+		return SymmetricMat3{
+			components[0][index],
+			components[1][index], components[3][index],
+			components[2][index], components[4][index], components[5][index]
+		};
+	}
+	static inline void setSymmetric(double* const* components, size_t index, const SymmetricMat3& value) {
+		components[0][index] = value(0, 0);
+		components[1][index] = value(0, 1);
+		components[2][index] = value(0, 2);
+		components[3][index] = value(1, 1);
+		components[4][index] = value(1, 2);
+		components[5][index] = value(2, 2);
+	}
+
+public:
+	DynamicsStateStore() = default;
+	DynamicsStateStore(const DynamicsStateStore&) = delete;
+	DynamicsStateStore& operator=(const DynamicsStateStore&) = delete;
+
+	// adds a body with the given state at the end, returns its index
+	size_t add(const DynamicsState& state);
+	/*
+		Removes the body at index and returns its state, the last body is moved into its place
+	*/
+	DynamicsState remove(size_t index);
+	void clear();
+
+	inline size_t getSize() const { return size; }
+	inline const DynamicsStateArrays& getArrays() const { return arrays; }
+
+	DynamicsState get(size_t index) const;
+	void set(size_t index, const DynamicsState& state);
+
+	inline Vec3 getForce(size_t index) const { return getVec3(arrays.force, index); }
+	inline void setForce(size_t index, const Vec3& force) { setVec3(arrays.force, index, force); }
+	inline Vec3 getMoment(size_t index) const { return getVec3(arrays.moment, index); }
+	inline void setMoment(size_t index, const Vec3& moment) { setVec3(arrays.moment, index, moment); }
+	inline SymmetricMat3 getForceResponse(size_t index) const { return getSymmetric(arrays.forceResponse, index); }
+	inline void setForceResponse(size_t index, const SymmetricMat3& response) { setSymmetric(arrays.forceResponse, index, response); }
+	inline SymmetricMat3 getMomentResponse(size_t index) const { return getSymmetric(arrays.momentResponse, index); }
+	inline void setMomentResponse(size_t index, const SymmetricMat3& response) { setSymmetric(arrays.momentResponse, index, response); }
+	inline Vec3 getVelocity(size_t index) const { return getVec3(arrays.velocity, index); }
+	inline void setVelocity(size_t index, const Vec3& velocity) { setVec3(arrays.velocity, index, velocity); }
+	inline Vec3 getAngularVelocity(size_t index) const { return getVec3(arrays.angularVelocity, index); }
+	inline void setAngularVelocity(size_t index, const Vec3& angularVelocity) { setVec3(arrays.angularVelocity, index, angularVelocity); }
+	Motion getMotion(size_t index) const;
+	void setMotion(size_t index, const Motion& motion);
+
+	/*
+		The rotation and velocityStep arrays are not part of the state, they are only the input and output of integrateVelocities
+	*/
+	void setRotation(size_t index, const Mat3& rotation);
+	inline Vec3 getVelocityStep(size_t index) const { return getVec3(arrays.velocityStep, index); }
+};
@@ -233,7 +233,11 @@ void CylinderClass::setScaleY(double newY, DiagonalMat3& scale) const {
 	scale[1] = newY;
 }
 
-PolyhedronShapeClass::PolyhedronShapeClass(Polyhedron&& poly) : poly(poly), ShapeClass(poly.getVolume(), poly.getCenterOfMass(), poly.getScalableInertiaAroundCenterOfMass(), CONVEX_POLYHEDRON_CLASS_ID) {}
+PolyhedronShapeClass::PolyhedronShapeClass(Polyhedron&& poly, int hillClimbingMinVertexCount) : poly(poly), ShapeClass(poly.getVolume(), poly.getCenterOfMass(), poly.getScalableInertiaAroundCenterOfMass(), CONVEX_POLYHEDRON_CLASS_ID) {
+	if(this->poly.vertexCount >= hillClimbingMinVertexCount) {
+		adjacency = VertexAdjacency(this->poly);
+	}
+}
 
 bool PolyhedronShapeClass::containsPoint(Vec3 point) const {
 	return poly.containsPoint(point);
@@ -251,6 +255,16 @@ double PolyhedronShapeClass::getScaledMaxRadiusSq(DiagonalMat3 scale) const {
 	return poly.getScaledMaxRadiusSq(scale);
 }
 Vec3f PolyhedronShapeClass::furthestInDirection(const Vec3f& direction) const {
+	if(usesHillClimbing()) {
+		return adjacency.getVertex(adjacency.furthestIndexInDirection(direction, 0));
+	}
+	return poly.furthestInDirection(direction);
+}
+Vec3f PolyhedronShapeClass::furthestInDirectionFrom(const Vec3f& direction, int& vertexHint) const {
+	if(usesHillClimbing()) {
+		vertexHint = adjacency.furthestIndexInDirection(direction, vertexHint);
+		return adjacency.getVertex(vertexHint);
+	}
 	return poly.furthestInDirection(direction);
 }
 Polyhedron PolyhedronShapeClass::asPolyhedron() const {
@@ -2,12 +2,16 @@
 
 #include "polyhedron.h"
 #include "shapeClass.h"
+#include "vertexAdjacency.h"
 
 #define CUBE_CLASS_ID 0
 #define SPHERE_CLASS_ID 1
 #define CYLINDER_CLASS_ID 2
 #define CONVEX_POLYHEDRON_CLASS_ID 10
 
+// polyhedra with at least this many vertices find their support vertices by hill climbing instead of scanning all vertices
+#define HILL_CLIMBING_MIN_VERTEX_COUNT 32
+
 
 class CubeClass : public ShapeClass {
 	CubeClass();
@@ -60,8 +64,10 @@ public:
 
 class PolyhedronShapeClass : public ShapeClass {
 	Polyhedron poly;
+	// empty if poly has fewer vertices than the hill climbing threshold
+	VertexAdjacency adjacency;
 public:
-	PolyhedronShapeClass(Polyhedron&& poly);
+	PolyhedronShapeClass(Polyhedron&& poly, int hillClimbingMinVertexCount = HILL_CLIMBING_MIN_VERTEX_COUNT);
 
 	virtual bool containsPoint(Vec3 point) const override;
 	virtual double getIntersectionDistance(Vec3 origin, Vec3 direction) const override;
@@ -69,5 +75,9 @@ public:
 	virtual double getScaledMaxRadius(DiagonalMat3 scale) const override;
 	virtual double getScaledMaxRadiusSq(DiagonalMat3 scale) const override;
 	virtual Vec3f furthestInDirection(const Vec3f& direction) const override;
+	virtual Vec3f furthestInDirectionFrom(const Vec3f& direction, int& vertexHint) const override;
 	virtual Polyhedron asPolyhedron() const override;
+
+	inline const Polyhedron& getPolyhedron() const { return poly; }
+	inline bool usesHillClimbing() const { return !adjacency.isEmpty(); }
 };
@@ -1,8 +1,17 @@
 #include "computationBuffer.h"
 
-#include "../../util/log.h"
 #include "genericIntersection.h"
 
+#include <algorithm>
+
+template<typename T>
+static void growArray(T*& buf, int oldCapacity, int newCapacity) {
+	T* newBuf = new T[newCapacity];
+	std::copy(buf, buf + oldCapacity, newBuf);
+	delete[] buf;
+	buf = newBuf;
+}
+
 ComputationBuffers::ComputationBuffers(int initialVertCount, int initialTriangleCount) :
 	vertexCapacity(initialVertCount), triangleCapacity(initialTriangleCount) {
 	createVertexBuffersUnsafe(initialVertCount);
@@ -11,14 +20,16 @@ ComputationBuffers::ComputationBuffers(int initialVertCount, int initialTriangle
 
 void ComputationBuffers::ensureCapacity(int vertCapacity, int triangleCapacity) {
 	if(this->vertexCapacity < vertCapacity) {
-		Log::debug("Increasing vertex buffer capacity from %d to %d", this->vertexCapacity, vertCapacity);
-		deleteVertexBuffers();
-		createVertexBuffersUnsafe(vertCapacity);
+		growArray(vertBuf, this->vertexCapacity, vertCapacity);
+		growArray(knownVecs, this->vertexCapacity, vertCapacity);
+		this->vertexCapacity = vertCapacity;
 	}
 	if(this->triangleCapacity < triangleCapacity) {
-		Log::debug("Increasing vertex buffer capacity from %d to %d", this->triangleCapacity, triangleCapacity);
-		deleteTriangleBuffers();
-		createTriangleBuffersUnsafe(triangleCapacity);
+		growArray(triangleBuf, this->triangleCapacity, triangleCapacity);
+		growArray(neighborBuf, this->triangleCapacity, triangleCapacity);
+		growArray(edgeBuf, this->triangleCapacity, triangleCapacity);
+		growArray(removalBuf, this->triangleCapacity, triangleCapacity);
+		this->triangleCapacity = triangleCapacity;
 	}
 }
 
@@ -52,3 +63,47 @@ void ComputationBuffers::deleteTriangleBuffers() {
 	delete[] edgeBuf;
 	delete[] removalBuf;
 }
+
+ComputationBufferPool::ComputationBufferPool(int initialVertCount, int initialTriangleCount) :
+	initialVertCount(initialVertCount), initialTriangleCount(initialTriangleCount),
+	statistics{0, 0, 0, initialVertCount, initialTriangleCount} {}
+
+ComputationBufferPool::Lease ComputationBufferPool::lease(int vertCapacity, int triangleCapacity) {
+	std::unique_ptr<ComputationBuffers> buffers;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		statistics.currentlyLeased++;
+		statistics.maxLeased = std::max(statistics.maxLeased, statistics.currentlyLeased);
+		if(!freeBuffers.empty()) {
+			buffers = std::move(freeBuffers.back());
+			freeBuffers.pop_back();
+		} else {
+			statistics.buffersCreated++;
+		}
+	}
+	if(!buffers) {
+		buffers = std::make_unique<ComputationBuffers>(std::max(initialVertCount, vertCapacity), std::max(initialTriangleCount, triangleCapacity));
+	} else {
+		buffers->ensureCapacity(vertCapacity, triangleCapacity);
+	}
+	return Lease(*this, std::move(buffers));
+}
+
+void ComputationBufferPool::giveBack(std::unique_ptr<ComputationBuffers> buffers) {
+	std::lock_guard<std::mutex> lock(mutex);
+	statistics.currentlyLeased--;
+	statistics.maxVertexCapacity = std::max(statistics.maxVertexCapacity, buffers->vertexCapacity);
+	statistics.maxTriangleCapacity = std::max(statistics.maxTriangleCapacity, buffers->triangleCapacity);
+	freeBuffers.push_back(std::move(buffers));
+}
+
+ComputationBufferPoolStatistics ComputationBufferPool::getStatistics() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return statistics;
+}
+
+ComputationBufferPool::Lease::Lease(ComputationBufferPool& pool, std::unique_ptr<ComputationBuffers> buffers) : pool(pool), buffers(std::move(buffers)) {}
+
+ComputationBufferPool::Lease::~Lease() {
+	pool.giveBack(std::move(buffers));
+}
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <cstddef>
+
 struct ComputationBuffers;
 
 #include "../math/linalg/vec.h"
@@ -19,6 +24,10 @@ struct ComputationBuffers {
 	int triangleCapacity;
 
 	ComputationBuffers(int initialVertCount, int initialTriangleCount);
+	/*
+		Grows the buffers to at least the given capacities, the contents are kept
+		Pointers into the buffers are invalidated when they grow
+	*/
 	void ensureCapacity(int vertCapacity, int triangleCapacity);
 
 	~ComputationBuffers();
@@ -33,4 +42,58 @@ private:
 	void createTriangleBuffersUnsafe(int triangleCapacity);
 	void deleteVertexBuffers();
 	void deleteTriangleBuffers();
-};
\ No newline at end of file
+};
+
+struct ComputationBufferPoolStatistics {
+	size_t buffersCreated;
+	size_t currentlyLeased;
+	// highest number of buffers that were leased at the same time
+	size_t maxLeased;
+	// largest capacities any buffer in the pool has grown to
+	int maxVertexCapacity;
+	int maxTriangleCapacity;
+};
+
+/*
+	Thread safe pool of ComputationBuffers
+	A thread leases a set of buffers for the duration of a computation, and they are handed back once the Lease goes out of scope.
+	Later leases reuse these buffers, so there are only as many as there were computations running at the same time.
+	Buffers that had to grow during a computation keep their larger capacity.
+*/
+class ComputationBufferPool {
+	std::mutex mutex;
+	std::vector<std::unique_ptr<ComputationBuffers>> freeBuffers;
+	int initialVertCount;
+	int initialTriangleCount;
+	ComputationBufferPoolStatistics statistics;
+
+	void giveBack(std::unique_ptr<ComputationBuffers> buffers);
+public:
+	class Lease {
+		ComputationBufferPool& pool;
+		std::unique_ptr<ComputationBuffers> buffers;
+	public:
+		Lease(ComputationBufferPool& pool, std::unique_ptr<ComputationBuffers> buffers);
+		~Lease();
+
+		Lease(const Lease&) = delete;
+		Lease(Lease&&) = delete;
+		Lease& operator=(const Lease&) = delete;
+		Lease& operator=(Lease&&) = delete;
+
+		inline ComputationBuffers& operator*() const { return *buffers; }
+		inline ComputationBuffers* operator->() const { return buffers.get(); }
+	};
+
+	ComputationBufferPool(int initialVertCount, int initialTriangleCount);
+
+	ComputationBufferPool(const ComputationBufferPool&) = delete;
+	ComputationBufferPool& operator=(const ComputationBufferPool&) = delete;
+
+	/*
+		Returns buffers with at least the given capacities
+	*/
+	Lease lease(int vertCapacity = 0, int triangleCapacity = 0);
+
+	ComputationBufferPoolStatistics getStatistics();
+};
@@ -4,4 +4,10 @@
 
 struct GenericCollidable {
 	virtual Vec3f furthestInDirection(const Vec3f& direction) const = 0;
+
+	/*
+		Same as furthestInDirection, vertexHint is the index of the vertex found by an earlier search in a similar direction, or -1
+		Shapes that can search from a known vertex start there and set vertexHint to the vertex they found, others leave it alone
+	*/
+	virtual Vec3f furthestInDirectionFrom(const Vec3f& direction, int& vertexHint) const { return furthestInDirection(direction); }
 };
@@ -16,6 +16,7 @@
 #include "../catchable_assert.h"
 
 #include <stdexcept>
+#include <algorithm>
 
 
 inline static void incDebugTally(HistoricTally<long long, IterationTime>& tally, int iterTime) {
@@ -78,9 +79,9 @@ static int furthestIndexInDirection(Vec3* vertices, int vertexCount, Vec3 direct
 }
 
 static MinkPoint getSupport(const ColissionPair& info, const Vec3f& searchDirection) {
-	Vec3f furthest1 = info.scaleFirst * info.first.furthestInDirection(info.scaleFirst * searchDirection);  // in local space of first
+	Vec3f furthest1 = info.scaleFirst * info.first.furthestInDirectionFrom(info.scaleFirst * searchDirection, info.supportHintFirst);  // in local space of first
 	Vec3f transformedSearchDirection = -info.transform.relativeToLocal(searchDirection);
-	Vec3f furthest2 = info.scaleSecond * info.second.furthestInDirection(info.scaleSecond * transformedSearchDirection);  // in local space of second
+	Vec3f furthest2 = info.scaleSecond * info.second.furthestInDirectionFrom(info.scaleSecond * transformedSearchDirection, info.supportHintSecond);  // in local space of second
 	Vec3f secondVertex = info.transform.localToGlobal(furthest2);  // converted to local space of first
 
 	/*catchable_assert(isVecValid(furthest1));
@@ -91,10 +92,16 @@ static MinkPoint getSupport(const ColissionPair& info, const Vec3f& searchDirect
 	return MinkPoint{ furthest1 - secondVertex, furthest1, secondVertex };  // local to first
 }
 
-std::optional<Tetrahedron> runGJKTransformed(const ColissionPair& info, Vec3f searchDirection) {
+std::optional<Tetrahedron> runGJKTransformed(const ColissionPair& info, Vec3f& searchDirection) {
 	MinkPoint A(getSupport(info, searchDirection));
 	MinkPoint B, C, D;
 
+	if(A.p * searchDirection < 0) {
+		// the initial direction already separates the shapes, usually because it is the result of a previous test
+		incDebugTally(GJKNoCollidesIterationStatistics, 0);
+		return std::optional<Tetrahedron>();
+	}
+
 	// set new searchdirection to be straight at the origin
 	searchDirection = -A.p;
 
@@ -234,7 +241,24 @@ void initializeBuffer(const Tetrahedron& s, ComputationBuffers& b) {
 	b.knownVecs[3] = MinkowskiPointIndices{s.D.originFirst, s.D.originSecond};
 }
 
+/*
+	Makes sure there is room to add another point to the builder, growing bufs if needed
+	addPoint may use two more triangles than there are now, and the removal and edge buffers need at most as many
+*/
+static void ensureRoomForPoint(ConvexShapeBuilder& builder, ComputationBuffers& bufs) {
+	if(builder.vertexCount < bufs.vertexCapacity && builder.triangleCount + 2 <= bufs.triangleCapacity) return;
+
+	bufs.ensureCapacity(std::max(bufs.vertexCapacity * 2, builder.vertexCount + 1), std::max(bufs.triangleCapacity * 2, builder.triangleCount + 2));
+
+	builder.vertexBuf = bufs.vertBuf;
+	builder.triangleBuf = bufs.triangleBuf;
+	builder.neighborBuf = bufs.neighborBuf;
+	builder.removalBuffer = bufs.removalBuf;
+	builder.newTriangleBuffer = bufs.edgeBuf;
+}
+
 bool runEPATransformed(const ColissionPair& info, const Tetrahedron& s, Vec3f& intersection, Vec3f& exitVector, ComputationBuffers& bufs) {
+	bufs.ensureCapacity(4, 4);
 	initializeBuffer(s, bufs);
 
 	ConvexShapeBuilder builder(bufs.vertBuf, bufs.triangleBuf, 4, 4, bufs.neighborBuf, bufs.removalBuf, bufs.edgeBuf);
@@ -266,6 +290,7 @@ bool runEPATransformed(const ColissionPair& info, const Tetrahedron& s, Vec3f& i
 
 		// Do not remove! The inversion catches NaN as well!
 		if(!(newPointDistSq <= distSq * 1.01)) {
+			ensureRoomForPoint(builder, bufs);
 			bufs.knownVecs[builder.vertexCount] = curIndices;
 			builder.addPoint(point.p, closestTriangleIndex);
 		} else {
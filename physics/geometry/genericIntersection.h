@@ -53,7 +53,19 @@ struct ColissionPair {
 	CFramef transform;
 	DiagonalMat3f scaleFirst;
 	DiagonalMat3f scaleSecond;
+	// the support vertices found by the last support query, each query starts searching from these
+	mutable int supportHintFirst = -1;
+	mutable int supportHintSecond = -1;
 };
 
-std::optional<Tetrahedron> runGJKTransformed(const ColissionPair& colissionPair, Vec3f initialSearchDirection);
+/*
+	The search starts in searchDirection, which is left at the direction the search ended in.
+	For shapes that don't intersect this direction separates them, so passing it back in for the next test of the same shapes
+	ends that test at the very first support point for as long as they stay apart
+*/
+std::optional<Tetrahedron> runGJKTransformed(const ColissionPair& colissionPair, Vec3f& searchDirection);
+inline std::optional<Tetrahedron> runGJKTransformed(const ColissionPair& colissionPair, const Vec3f& initialSearchDirection) {
+	Vec3f searchDirection = initialSearchDirection;
+	return runGJKTransformed(colissionPair, searchDirection);
+}
 bool runEPATransformed(const ColissionPair& colissionPair, const Tetrahedron& s, Vec3f& intersection, Vec3f& exitVector, ComputationBuffers& bufs);
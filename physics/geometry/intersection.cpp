@@ -1,6 +1,7 @@
 #include "intersection.h"
 
 #include "genericIntersection.h"
+#include "primitiveIntersection.h"
 #include "../physicsProfiler.h"
 #include "../profiling.h"
 #include "computationBuffer.h"
@@ -15,17 +16,37 @@
 
 #include <algorithm>
 
-std::optional<Intersection> intersectsTransformed(const Shape& first, const Shape& second, const CFrame& relativeTransform) {
-	return intersectsTransformed(*first.baseShape, *second.baseShape, relativeTransform, first.scale, second.scale);
+std::optional<Intersection> intersectsTransformed(const Shape& first, const Shape& second, const CFrame& relativeTransform, IntersectionWarmStart* warmStart) {
+	std::optional<Intersection> primitiveResult;
+	// pairs without a closed form routine are only checked here, their GJK run is marked as GJK_COL
+	physicsMeasure.mark(PhysicsProcess::PRIMITIVE_COL);
+	if(intersectsPrimitives(*first.baseShape, *second.baseShape, relativeTransform, first.scale, second.scale, primitiveResult)) {
+		return primitiveResult;
+	}
+	return intersectsTransformed(*first.baseShape, *second.baseShape, relativeTransform, first.scale, second.scale, warmStart);
 }
 
 
-ComputationBuffers buffers(1000, 2000);
+// large enough for most EPA runs, the few that need more grow their buffers
+ComputationBufferPool computationBufferPool(64, 128);
 
-std::optional<Intersection> intersectsTransformed(const GenericCollidable& first, const GenericCollidable& second, const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond) {
+std::optional<Intersection> intersectsTransformed(const GenericCollidable& first, const GenericCollidable& second, const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond, IntersectionWarmStart* warmStart) {
 	ColissionPair info{first, second, relativeTransform, scaleFirst, scaleSecond};
+	if(warmStart != nullptr) {
+		info.supportHintFirst = warmStart->supportVertexFirst;
+		info.supportHintSecond = warmStart->supportVertexSecond;
+	}
 	physicsMeasure.mark(PhysicsProcess::GJK_COL);
-	std::optional collides = runGJKTransformed(info, -relativeTransform.position);
+	Vec3f searchDirection = (warmStart != nullptr && warmStart->hasSearchDirection) ? warmStart->searchDirection : Vec3f(-relativeTransform.position);
+	std::optional collides = runGJKTransformed(info, searchDirection);
+	if(warmStart != nullptr) {
+		// a degenerate direction is no better than the default one
+		float directionLengthSq = lengthSquared(searchDirection);
+		warmStart->hasSearchDirection = directionLengthSq > 0.0f && std::isfinite(directionLengthSq);
+		warmStart->searchDirection = searchDirection;
+		warmStart->supportVertexFirst = info.supportHintFirst;
+		warmStart->supportVertexSecond = info.supportHintSecond;
+	}
 
 	if(collides) {
 		Tetrahedron& result = collides.value();
@@ -55,7 +76,8 @@ std::optional<Intersection> intersectsTransformed(const GenericCollidable& first
 		catchable_assert(isVecValid(result.D.originFirst));
 		catchable_assert(isVecValid(result.D.originSecond));
 
-		bool epaResult = runEPATransformed(info, result, intersection, exitVector, buffers);
+		ComputationBufferPool::Lease buffers = computationBufferPool.lease();
+		bool epaResult = runEPATransformed(info, result, intersection, exitVector, *buffers);
 
 		catchable_assert(isVecValid(exitVector));
 		if(!epaResult) {
@@ -8,6 +8,7 @@
 
 class Shape;
 class Polyhedron;
+class ComputationBufferPool;
 
 struct Intersection {
 	// Local to first
@@ -20,7 +21,22 @@ struct Intersection {
 		exitVector(exitVector) {}
 };
 
-std::optional<Intersection> intersectsTransformed(const Shape& first, const Shape& second, const CFrame& relativeTransform);
-std::optional<Intersection> intersectsTransformed(const GenericCollidable& first, const GenericCollidable& second, const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond);
+/*
+	Kept by the caller between tests of the same two shapes, so that GJK can start searching where the previous test ended
+	The direction is local to first, it stays useful for as long as the shapes don't turn much relative to each other
+	The support vertices let shapes that hill climb their support function start from the vertices found last time
+*/
+struct IntersectionWarmStart {
+	Vec3f searchDirection = Vec3f(0.0f, 0.0f, 0.0f);
+	bool hasSearchDirection = false;
+	int supportVertexFirst = -1;
+	int supportVertexSecond = -1;
+};
 
+std::optional<Intersection> intersectsTransformed(const Shape& first, const Shape& second, const CFrame& relativeTransform, IntersectionWarmStart* warmStart = nullptr);
+std::optional<Intersection> intersectsTransformed(const GenericCollidable& first, const GenericCollidable& second, const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond, IntersectionWarmStart* warmStart = nullptr);
 
+/*
+	Buffers used by the EPA step of intersectsTransformed, safe to share between threads
+*/
+extern ComputationBufferPool computationBufferPool;
@@ -0,0 +1,244 @@
+#include "primitiveIntersection.h"
+
+#include "shapeClass.h"
+#include "builtinShapeClasses.h"
+
+#include <cmath>
+#include <algorithm>
+
+// components of a direction smaller than this are treated as perpendicular to it when picking the touching feature of a box
+#define BOX_FEATURE_TOLERANCE 1e-4
+
+static double clampTo(double value, double halfExtent) {
+	return std::max(-halfExtent, std::min(value, halfExtent));
+}
+
+static double featureSign(double component) {
+	if(std::abs(component) < BOX_FEATURE_TOLERANCE) return 0.0;
+	return (component > 0.0) ? 1.0 : -1.0;
+}
+
+/*
+	point is the deepest point of second, pointing from first to second with length depth
+	the intersection is put halfway between the deepest point of second and the surface of first
+*/
+static Intersection makeIntersection(const Vec3& deepestPointOfSecond, const Vec3& normal, double depth) {
+	return Intersection(deepestPointOfSecond + normal * (depth * 0.5), normal * depth);
+}
+
+std::optional<Intersection> intersectSphereSphere(const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond, const CFrame& relativeTransform) {
+	double r1 = scaleFirst[0];
+	double r2 = scaleSecond[0];
+	Vec3 delta = relativeTransform.position;
+	double distSq = lengthSquared(delta);
+	double radiusSum = r1 + r2;
+	if(distSq >= radiusSum * radiusSum) return std::optional<Intersection>();
+
+	double dist = std::sqrt(distSq);
+	Vec3 normal = (dist > 0.0) ? delta / dist : Vec3(1.0, 0.0, 0.0);
+	return makeIntersection(delta - normal * r2, normal, radiusSum - dist);
+}
+
+std::optional<Intersection> intersectBoxSphere(const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond, const CFrame& relativeTransform) {
+	Vec3 halfExtents(scaleFirst[0], scaleFirst[1], scaleFirst[2]);
+	double radius = scaleSecond[0];
+	Vec3 center = relativeTransform.position;
+
+	Vec3 closest(clampTo(center.x, halfExtents.x), clampTo(center.y, halfExtents.y), clampTo(center.z, halfExtents.z));
+	Vec3 outside = center - closest;
+	double outsideDistSq = lengthSquared(outside);
+	if(outsideDistSq > 0.0) {
+		if(outsideDistSq >= radius * radius) return std::optional<Intersection>();
+		double dist = std::sqrt(outsideDistSq);
+		Vec3 normal = outside / dist;
+		return makeIntersection(center - normal * radius, normal, radius - dist);
+	}
+
+	// the center is inside the box, push it out through the nearest face
+	int nearestAxis = 0;
+	double nearestFaceDist = halfExtents[0] - std::abs(center[0]);
+	for(int axis = 1; axis < 3; axis++) {
+		double faceDist = halfExtents[axis] - std::abs(center[axis]);
+		if(faceDist < nearestFaceDist) {
+			nearestFaceDist = faceDist;
+			nearestAxis = axis;
+		}
+	}
+	Vec3 normal(0.0, 0.0, 0.0);
+	normal[nearestAxis] = (center[nearestAxis] >= 0.0) ? 1.0 : -1.0;
+	return makeIntersection(center - normal * radius, normal, nearestFaceDist + radius);
+}
+
+std::optional<Intersection> intersectCylinderSphere(const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond, const CFrame& relativeTransform) {
+	double cylinderRadius = scaleFirst[0];
+	double halfHeight = scaleFirst[2];
+	double radius = scaleSecond[0];
+	Vec3 center = relativeTransform.position;
+
+	double radialDist = std::sqrt(center.x * center.x + center.y * center.y);
+	Vec3 radialDirection = (radialDist > 0.0) ? Vec3(center.x / radialDist, center.y / radialDist, 0.0) : Vec3(1.0, 0.0, 0.0);
+
+	if(radialDist > cylinderRadius || std::abs(center.z) > halfHeight) {
+		Vec3 closest = radialDirection * std::min(radialDist, cylinderRadius);
+		closest.z = clampTo(center.z, halfHeight);
+		Vec3 outside = center - closest;
+		double outsideDistSq = lengthSquared(outside);
+		if(outsideDistSq >= radius * radius) return std::optional<Intersection>();
+		double dist = std::sqrt(outsideDistSq);
+		Vec3 normal = outside / dist;
+		return makeIntersection(center - normal * radius, normal, radius - dist);
+	}
+
+	// the center is inside the cylinder, push it out through the side or the nearest cap, whichever is closer
+	double sideDist = cylinderRadius - radialDist;
+	double capDist = halfHeight - std::abs(center.z);
+	if(sideDist < capDist) {
+		return makeIntersection(center - radialDirection * radius, radialDirection, sideDist + radius);
+	} else {
+		Vec3 normal(0.0, 0.0, (center.z >= 0.0) ? 1.0 : -1.0);
+		return makeIntersection(center - normal * radius, normal, capDist + radius);
+	}
+}
+
+/*
+	Separating axis test over the 3 face normals of each box and the 9 cross products of their edges
+	The axis with the least overlap gives the exitVector, the contact point is taken from the features that touch along it
+*/
+std::optional<Intersection> intersectBoxBox(const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond, const CFrame& relativeTransform) {
+	Vec3 a(scaleFirst[0], scaleFirst[1], scaleFirst[2]);
+	Vec3 b(scaleSecond[0], scaleSecond[1], scaleSecond[2]);
+	Vec3 t = relativeTransform.position;
+	Vec3 axesB[3]{relativeTransform.rotation.getX(), relativeTransform.rotation.getY(), relativeTransform.rotation.getZ()};
+
+	double bestOverlap = INFINITY;
+	Vec3 bestNormal;
+	int bestAxis = -1;
+
+	// axis must be normalized, returns false if the boxes are separated along it
+	auto testAxis = [&](const Vec3& axis, int axisIndex) {
+		double radiusA = a.x * std::abs(axis.x) + a.y * std::abs(axis.y) + a.z * std::abs(axis.z);
+		double radiusB = b.x * std::abs(axesB[0] * axis) + b.y * std::abs(axesB[1] * axis) + b.z * std::abs(axesB[2] * axis);
+		double dist = t * axis;
+		double overlap = radiusA + radiusB - std::abs(dist);
+		if(overlap <= 0.0) return false;
+		if(overlap < bestOverlap) {
+			bestOverlap = overlap;
+			bestNormal = (dist < 0.0) ? -axis : axis;
+			bestAxis = axisIndex;
+		}
+		return true;
+	};
+
+	for(int i = 0; i < 3; i++) {
+		Vec3 axis(0.0, 0.0, 0.0);
+		axis[i] = 1.0;
+		if(!testAxis(axis, i)) return std::optional<Intersection>();
+	}
+	for(int j = 0; j < 3; j++) {
+		if(!testAxis(axesB[j], 3 + j)) return std::optional<Intersection>();
+	}
+	for(int i = 0; i < 3; i++) {
+		Vec3 axisA(0.0, 0.0, 0.0);
+		axisA[i] = 1.0;
+		for(int j = 0; j < 3; j++) {
+			Vec3 axis = axisA % axesB[j];
+			double axisLengthSq = lengthSquared(axis);
+			// parallel edges, the face axes already cover this direction
+			if(axisLengthSq < 1e-12) continue;
+			if(!testAxis(axis / std::sqrt(axisLengthSq), 6 + i * 3 + j)) return std::optional<Intersection>();
+		}
+	}
+
+	Vec3 n = bestNormal;
+	// the feature of each box closest to the other, faces and edges that lie flat against the normal are averaged to their center
+	Vec3 deepestA(featureSign(n.x) * a.x, featureSign(n.y) * a.y, featureSign(n.z) * a.z);
+	Vec3 deepestB = t;
+	for(int j = 0; j < 3; j++) {
+		deepestB -= axesB[j] * (featureSign(axesB[j] * n) * b[j]);
+	}
+
+	if(bestAxis < 3) {
+		// a face of first, keep the touching feature of second within that face
+		for(int k = 0; k < 3; k++) {
+			if(k != bestAxis) deepestB[k] = clampTo(deepestB[k], a[k]);
+		}
+		return makeIntersection(deepestB, n, bestOverlap);
+	} else if(bestAxis < 6) {
+		// a face of second, keep the touching feature of first within that face
+		int faceAxis = bestAxis - 3;
+		Vec3 localToB = relativeTransform.globalToLocal(deepestA);
+		for(int k = 0; k < 3; k++) {
+			if(k != faceAxis) localToB[k] = clampTo(localToB[k], b[k]);
+		}
+		Vec3 onFaceOfB = relativeTransform.localToGlobal(localToB);
+		return makeIntersection(onFaceOfB - n * bestOverlap, n, bestOverlap);
+	} else {
+		// edge against edge, the contact is between the closest points of the two edges
+		int edgeA = (bestAxis - 6) / 3;
+		int edgeB = (bestAxis - 6) % 3;
+		Vec3 centerA = deepestA;
+		centerA[edgeA] = 0.0;
+		Vec3 centerB = deepestB + axesB[edgeB] * (featureSign(axesB[edgeB] * n) * b[edgeB]);
+		Vec3 directionA(0.0, 0.0, 0.0);
+		directionA[edgeA] = 1.0;
+		const Vec3& directionB = axesB[edgeB];
+
+		Vec3 offset = centerA - centerB;
+		double cosAngle = directionA * directionB;
+		double denom = 1.0 - cosAngle * cosAngle;
+		double alongA = (cosAngle * (directionB * offset) - directionA * offset) / denom;
+		double alongB = (directionB * offset - cosAngle * (directionA * offset)) / denom;
+		Vec3 closestA = centerA + directionA * clampTo(alongA, a[edgeA]);
+		Vec3 closestB = centerB + directionB * clampTo(alongB, b[edgeB]);
+		return Intersection((closestA + closestB) * 0.5, n * bestOverlap);
+	}
+}
+
+typedef std::optional<Intersection>(*PrimitiveIntersectionFunc)(const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond, const CFrame& relativeTransform);
+
+struct PrimitiveRoutine {
+	PrimitiveIntersectionFunc func;
+	// the routine takes the shapes in the opposite order
+	bool swapped;
+};
+
+#define PRIMITIVE_CLASS_COUNT 3
+static_assert(CUBE_CLASS_ID == 0 && SPHERE_CLASS_ID == 1 && CYLINDER_CLASS_ID == 2, "the table below is indexed by intersectionClassID");
+
+static const PrimitiveRoutine primitiveRoutines[PRIMITIVE_CLASS_COUNT][PRIMITIVE_CLASS_COUNT]{
+	/* cube */     {{intersectBoxBox, false},         {intersectBoxSphere, false},      {nullptr, false}},
+	/* sphere */   {{intersectBoxSphere, true},       {intersectSphereSphere, false},   {intersectCylinderSphere, true}},
+	/* cylinder */ {{nullptr, false},                 {intersectCylinderSphere, false}, {nullptr, false}},
+};
+
+// the routines assume spheres and cylinders keep a round cross section, anything stretched goes to GJK
+static bool hasSupportedScale(int intersectionClassID, const DiagonalMat3& scale) {
+	switch(intersectionClassID) {
+	case SPHERE_CLASS_ID: return scale[0] == scale[1] && scale[1] == scale[2];
+	case CYLINDER_CLASS_ID: return scale[0] == scale[1];
+	default: return true;
+	}
+}
+
+bool intersectsPrimitives(const ShapeClass& first, const ShapeClass& second, const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond, std::optional<Intersection>& result) {
+	int firstID = first.intersectionClassID;
+	int secondID = second.intersectionClassID;
+	if(firstID < 0 || firstID >= PRIMITIVE_CLASS_COUNT || secondID < 0 || secondID >= PRIMITIVE_CLASS_COUNT) return false;
+
+	const PrimitiveRoutine& routine = primitiveRoutines[firstID][secondID];
+	if(routine.func == nullptr) return false;
+	if(!hasSupportedScale(firstID, scaleFirst) || !hasSupportedScale(secondID, scaleSecond)) return false;
+
+	if(!routine.swapped) {
+		result = routine.func(scaleFirst, scaleSecond, relativeTransform);
+	} else {
+		std::optional<Intersection> swappedResult = routine.func(scaleSecond, scaleFirst, ~relativeTransform);
+		if(swappedResult) {
+			// back to the frame of first, moving second out is the opposite of moving first out
+			result = Intersection(relativeTransform.localToGlobal(swappedResult->intersection), -relativeTransform.localToRelative(swappedResult->exitVector));
+		} else {
+			result = std::optional<Intersection>();
+		}
+	}
+	return true;
+}
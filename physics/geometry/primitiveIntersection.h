@@ -0,0 +1,27 @@
+#pragma once
+
+#include <optional>
+
+#include "../math/linalg/vec.h"
+#include "../math/linalg/mat.h"
+#include "../math/cframe.h"
+#include "intersection.h"
+
+class ShapeClass;
+
+/*
+	Closed form intersection of two scaled builtin shape classes, relativeTransform is the CFrame of second relative to first
+	Returns false if there is no closed form routine for this pair of intersectionClassIDs, the caller should fall back to GJK and EPA then
+	Otherwise result is set to the intersection, with the same conventions as intersectsTransformed:
+	intersection and exitVector are local to first, exitVector is how far second must move to no longer collide
+*/
+bool intersectsPrimitives(const ShapeClass& first, const ShapeClass& second, const CFrame& relativeTransform, const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond, std::optional<Intersection>& result);
+
+/*
+	The routines behind intersectsPrimitives, the first shape is at the origin
+	Boxes span -scale..scale, spheres have radius scale[0], cylinders have radius scale[0] and span -scale[2]..scale[2] along z
+*/
+std::optional<Intersection> intersectSphereSphere(const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond, const CFrame& relativeTransform);
+std::optional<Intersection> intersectBoxSphere(const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond, const CFrame& relativeTransform);
+std::optional<Intersection> intersectBoxBox(const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond, const CFrame& relativeTransform);
+std::optional<Intersection> intersectCylinderSphere(const DiagonalMat3& scaleFirst, const DiagonalMat3& scaleSecond, const CFrame& relativeTransform);
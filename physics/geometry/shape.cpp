@@ -2,11 +2,32 @@
 
 #include "polyhedron.h"
 #include "shapeClass.h"
+#include "shapeClassRegistry.h"
 
 Shape::Shape() : baseShape(nullptr), scale{1,1,1} {}
-Shape::Shape(const ShapeClass* baseShape, DiagonalMat3 scale) : baseShape(baseShape), scale(scale) {}
-Shape::Shape(const ShapeClass* baseShape) : baseShape(baseShape), scale{1,1,1} {}
-Shape::Shape(const ShapeClass* baseShape, double width, double height, double depth) : baseShape(baseShape), scale{width / 2, height / 2, depth / 2} {}
+Shape::Shape(const ShapeClass* baseShape, DiagonalMat3 scale) : baseShape(baseShape), scale(scale) {
+	getShapeClassRegistry().retain(baseShape);
+}
+Shape::Shape(const ShapeClass* baseShape) : baseShape(baseShape), scale{1,1,1} {
+	getShapeClassRegistry().retain(baseShape);
+}
+Shape::Shape(const ShapeClass* baseShape, double width, double height, double depth) : baseShape(baseShape), scale{width / 2, height / 2, depth / 2} {
+	getShapeClassRegistry().retain(baseShape);
+}
+Shape::~Shape() {
+	getShapeClassRegistry().release(baseShape);
+}
+Shape::Shape(const Shape& other) : baseShape(other.baseShape), scale(other.scale) {
+	getShapeClassRegistry().retain(baseShape);
+}
+Shape& Shape::operator=(const Shape& other) {
+	// retained first, for assigning a shape to itself or to one with the same class
+	getShapeClassRegistry().retain(other.baseShape);
+	getShapeClassRegistry().release(this->baseShape);
+	this->baseShape = other.baseShape;
+	this->scale = other.scale;
+	return *this;
+}
 
 bool Shape::containsPoint(Vec3 point) const {
 	return baseShape->containsPoint(~scale * point);
@@ -10,6 +10,11 @@
 class ShapeClass;
 class Polyhedron;
 
+/*
+	Every Shape holds a reference to its baseShape in the ShapeClassRegistry, so the classes made by polyhedronShape
+	are deleted once the last Shape using them, usually the hitbox of the last Part, is gone. Builtin classes are not counted
+	baseShape must not be assigned directly, that would bypass the counting
+*/
 class Shape {
 	Shape(const ShapeClass* baseShape, DiagonalMat3 scale);
 public:
@@ -19,6 +24,11 @@ public:
 	Shape();
 	Shape(const ShapeClass* baseShape);
 	Shape(const ShapeClass* baseShape, double width, double height, double depth);
+	~Shape();
+
+	// a moved Shape is copied, so that its baseShape stays valid for the code that still reads it afterwards
+	Shape(const Shape& other);
+	Shape& operator=(const Shape& other);
 
 	bool containsPoint(Vec3 point) const;
 	double getIntersectionDistance(Vec3 origin, Vec3 direction) const;
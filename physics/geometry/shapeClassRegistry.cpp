@@ -0,0 +1,131 @@
+#include "shapeClassRegistry.h"
+
+#include "polyhedron.h"
+#include "builtinShapeClasses.h"
+
+#include <cstring>
+#include <cstdint>
+#include <cassert>
+
+static size_t combineHash(size_t seed, uint32_t value) {
+	return seed ^ (size_t(value) + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2));
+}
+
+static uint32_t floatBits(float f) {
+	uint32_t bits;
+	std::memcpy(&bits, &f, sizeof(float));
+	return bits;
+}
+
+// vertices are compared bitwise, so that equal contents always have equal hashes
+size_t ShapeClassRegistry::hashPolyhedron(const Polyhedron& poly) {
+	size_t hash = combineHash(uint32_t(poly.vertexCount), uint32_t(poly.triangleCount));
+	for(int i = 0; i < poly.vertexCount; i++) {
+		Vec3f vertex = poly.getVertex(i);
+		hash = combineHash(hash, floatBits(vertex.x));
+		hash = combineHash(hash, floatBits(vertex.y));
+		hash = combineHash(hash, floatBits(vertex.z));
+	}
+	for(int i = 0; i < poly.triangleCount; i++) {
+		Triangle triangle = poly.getTriangle(i);
+		hash = combineHash(hash, uint32_t(triangle.firstIndex));
+		hash = combineHash(hash, uint32_t(triangle.secondIndex));
+		hash = combineHash(hash, uint32_t(triangle.thirdIndex));
+	}
+	return hash;
+}
+
+bool ShapeClassRegistry::haveSameContents(const Polyhedron& a, const Polyhedron& b) {
+	if(a.vertexCount != b.vertexCount || a.triangleCount != b.triangleCount) return false;
+	for(int i = 0; i < a.vertexCount; i++) {
+		Vec3f va = a.getVertex(i);
+		Vec3f vb = b.getVertex(i);
+		if(floatBits(va.x) != floatBits(vb.x) || floatBits(va.y) != floatBits(vb.y) || floatBits(va.z) != floatBits(vb.z)) return false;
+	}
+	for(int i = 0; i < a.triangleCount; i++) {
+		Triangle ta = a.getTriangle(i);
+		Triangle tb = b.getTriangle(i);
+		if(ta.firstIndex != tb.firstIndex || ta.secondIndex != tb.secondIndex || ta.thirdIndex != tb.thirdIndex) return false;
+	}
+	return true;
+}
+
+ShapeClassRegistry::~ShapeClassRegistry() {
+	for(const std::pair<const ShapeClass* const, Entry>& entry : entries) {
+		delete entry.second.shapeClass;
+	}
+}
+
+const PolyhedronShapeClass* ShapeClassRegistry::acquire(Polyhedron&& normalizedPoly) {
+	size_t contentHash = hashPolyhedron(normalizedPoly);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto candidates = classesByHash.equal_range(contentHash);
+	for(auto it = candidates.first; it != candidates.second; ++it) {
+		if(haveSameContents(it->second->getPolyhedron(), normalizedPoly)) {
+			entries.at(it->second).referenceCount++;
+			statistics.classesShared++;
+			return it->second;
+		}
+	}
+
+	const PolyhedronShapeClass* shapeClass = new PolyhedronShapeClass(std::move(normalizedPoly));
+	classesByHash.emplace(contentHash, shapeClass);
+	entries.emplace(shapeClass, Entry{shapeClass, contentHash, 1});
+	statistics.classesCreated++;
+	return shapeClass;
+}
+
+// only polyhedra are interned, the other classes are skipped without taking the lock
+static bool mayBeRegistered(const ShapeClass* shapeClass) {
+	return shapeClass != nullptr && shapeClass->intersectionClassID == CONVEX_POLYHEDRON_CLASS_ID;
+}
+
+void ShapeClassRegistry::retain(const ShapeClass* shapeClass) {
+	if(!mayBeRegistered(shapeClass)) return;
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = entries.find(shapeClass);
+	if(found == entries.end()) return;
+	found->second.referenceCount++;
+}
+
+bool ShapeClassRegistry::release(const ShapeClass* shapeClass) {
+	if(!mayBeRegistered(shapeClass)) return false;
+	const PolyhedronShapeClass* toDelete;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto found = entries.find(shapeClass);
+		if(found == entries.end()) return false;
+		assert(found->second.referenceCount > 0);
+		if(--found->second.referenceCount != 0) return false;
+
+		auto candidates = classesByHash.equal_range(found->second.contentHash);
+		for(auto it = candidates.first; it != candidates.second; ++it) {
+			if(it->second == shapeClass) {
+				classesByHash.erase(it);
+				break;
+			}
+		}
+		toDelete = found->second.shapeClass;
+		entries.erase(found);
+		statistics.classesDeleted++;
+	}
+	delete toDelete;
+	return true;
+}
+
+size_t ShapeClassRegistry::getReferenceCount(const ShapeClass* shapeClass) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = entries.find(shapeClass);
+	return (found != entries.end()) ? found->second.referenceCount : 0;
+}
+
+ShapeClassRegistryStatistics ShapeClassRegistry::getStatistics() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return statistics;
+}
+
+ShapeClassRegistry& getShapeClassRegistry() {
+	static ShapeClassRegistry* registry = new ShapeClassRegistry();
+	return *registry;
+}
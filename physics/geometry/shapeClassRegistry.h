@@ -0,0 +1,73 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+
+class ShapeClass;
+class Polyhedron;
+class PolyhedronShapeClass;
+
+struct ShapeClassRegistryStatistics {
+	// number of PolyhedronShapeClasses the registry had to create
+	size_t classesCreated;
+	// number of requests that were answered with an existing class
+	size_t classesShared;
+	// number of classes that were deleted because all their references were released
+	size_t classesDeleted;
+
+	inline size_t getLiveClassCount() const { return classesCreated - classesDeleted; }
+};
+
+/*
+	Thread safe interning of the PolyhedronShapeClasses made by polyhedronShape
+	Normalized polyhedra with exactly the same vertices and triangles share one class, they are looked up by a hash of their contents.
+
+	Every acquire and retain holds one reference to the class, release gives it back,
+	and the class is deleted once the last reference is released. Shapes hold a reference for as long as they exist.
+	retain and release ignore classes the registry did not create, so they can be called on the baseShape of any Shape
+*/
+class ShapeClassRegistry {
+	struct Entry {
+		const PolyhedronShapeClass* shapeClass;
+		size_t contentHash;
+		size_t referenceCount;
+	};
+
+	mutable std::mutex mutex;
+	std::unordered_multimap<size_t, const PolyhedronShapeClass*> classesByHash;
+	std::unordered_map<const ShapeClass*, Entry> entries;
+	ShapeClassRegistryStatistics statistics{};
+
+public:
+	ShapeClassRegistry() = default;
+	~ShapeClassRegistry();
+
+	ShapeClassRegistry(const ShapeClassRegistry&) = delete;
+	ShapeClassRegistry& operator=(const ShapeClassRegistry&) = delete;
+
+	/*
+		Returns the class for the given normalized polyhedron, creating it if no equal one is registered yet
+		The caller holds one reference to the returned class
+	*/
+	const PolyhedronShapeClass* acquire(Polyhedron&& normalizedPoly);
+
+	// adds a reference to shapeClass
+	void retain(const ShapeClass* shapeClass);
+	// removes a reference from shapeClass, returns true if this deleted it
+	bool release(const ShapeClass* shapeClass);
+
+	// number of references held to shapeClass, 0 if the registry did not create it
+	size_t getReferenceCount(const ShapeClass* shapeClass) const;
+	ShapeClassRegistryStatistics getStatistics() const;
+
+	static size_t hashPolyhedron(const Polyhedron& poly);
+	static bool haveSameContents(const Polyhedron& a, const Polyhedron& b);
+};
+
+/*
+	The registry used by polyhedronShape
+	It is never destroyed, so shapes held by static objects stay valid until the program exits
+*/
+ShapeClassRegistry& getShapeClassRegistry();
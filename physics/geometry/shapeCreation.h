@@ -7,4 +7,8 @@ class Polyhedron;
 Shape sphereShape(double radius);
 Shape cylinderShape(double radius, double height);
 Shape boxShape(double width, double height, double depth);
+/*
+	Equal polyhedra, up to translation and scale along the axes, share one ShapeClass, see ShapeClassRegistry
+	The class is deleted once no Shape uses it anymore
+*/
 Shape polyhedronShape(const Polyhedron& poly);
@@ -0,0 +1,58 @@
+#include "vertexAdjacency.h"
+
+#include "triangleMesh.h"
+
+#include <algorithm>
+
+VertexAdjacency::VertexAdjacency(const TriangleMesh& mesh) : vertices(mesh.vertexCount), neighborOffsets(mesh.vertexCount + 1, 0) {
+	for(int i = 0; i < mesh.vertexCount; i++) {
+		vertices[i] = mesh.getVertex(i);
+	}
+
+	// edges are shared between triangles, the duplicates are removed below
+	std::vector<std::vector<int>> neighborLists(mesh.vertexCount);
+	for(int t = 0; t < mesh.triangleCount; t++) {
+		Triangle triangle = mesh.getTriangle(t);
+		for(int i = 0; i < 3; i++) {
+			int from = triangle.indexes[i];
+			int to = triangle.indexes[(i + 1) % 3];
+			neighborLists[from].push_back(to);
+			neighborLists[to].push_back(from);
+		}
+	}
+	for(int v = 0; v < mesh.vertexCount; v++) {
+		std::vector<int>& list = neighborLists[v];
+		std::sort(list.begin(), list.end());
+		list.erase(std::unique(list.begin(), list.end()), list.end());
+		neighborOffsets[v + 1] = neighborOffsets[v] + static_cast<int>(list.size());
+	}
+	neighbors.reserve(neighborOffsets[mesh.vertexCount]);
+	for(const std::vector<int>& list : neighborLists) {
+		neighbors.insert(neighbors.end(), list.begin(), list.end());
+	}
+}
+
+int VertexAdjacency::furthestIndexInDirection(const Vec3f& direction, int startVertex) const {
+	int vertexCount = getVertexCount();
+	int current = (startVertex >= 0 && startVertex < vertexCount) ? startVertex : 0;
+	float currentDot = vertices[current] * direction;
+
+	// every step strictly increases the dot product, so no vertex is visited twice, the bound only guards against NaN directions
+	for(int step = 0; step < vertexCount; step++) {
+		int best = current;
+		float bestDot = currentDot;
+		const int* neighborsBegin = getNeighbors(current);
+		const int* neighborsEnd = neighborsBegin + getNeighborCount(current);
+		for(const int* neighbor = neighborsBegin; neighbor != neighborsEnd; ++neighbor) {
+			float dot = vertices[*neighbor] * direction;
+			if(dot > bestDot) {
+				bestDot = dot;
+				best = *neighbor;
+			}
+		}
+		if(best == current) break;
+		current = best;
+		currentDot = bestDot;
+	}
+	return current;
+}
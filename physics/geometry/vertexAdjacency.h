@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+
+#include "../math/linalg/vec.h"
+
+class TriangleMesh;
+
+/*
+	The vertices of a convex mesh together with their neighbours along the edges of its triangles
+	The neighbours of vertex i are neighbors[neighborOffsets[i]] up to neighbors[neighborOffsets[i+1]]
+
+	On a convex mesh every vertex that is no further in some direction than all of its neighbours is the furthest vertex of the whole mesh,
+	so the furthest vertex can be found by walking from neighbour to neighbour, starting close to it makes that a handful of steps
+*/
+class VertexAdjacency {
+	std::vector<Vec3f> vertices;
+	std::vector<int> neighborOffsets;
+	std::vector<int> neighbors;
+public:
+	VertexAdjacency() = default;
+	explicit VertexAdjacency(const TriangleMesh& mesh);
+
+	inline bool isEmpty() const { return vertices.empty(); }
+	inline int getVertexCount() const { return static_cast<int>(vertices.size()); }
+	inline int getNeighborCount(int vertex) const { return neighborOffsets[vertex + 1] - neighborOffsets[vertex]; }
+	inline const int* getNeighbors(int vertex) const { return neighbors.data() + neighborOffsets[vertex]; }
+	inline Vec3f getVertex(int index) const { return vertices[index]; }
+
+	/*
+		Walks from startVertex to the vertex furthest in the given direction, startVertex may be out of range, the walk starts at vertex 0 then
+		Must not be empty
+	*/
+	int furthestIndexInDirection(const Vec3f& direction, int startVertex) const;
+};
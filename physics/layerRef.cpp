@@ -1,6 +1,8 @@
 #include "layerRef.h"
 #include "layer.h"
 
+#include <algorithm>
+
 
 void LayerRef::notifyPartBoundsUpdated(const Part* updatedPart, const Bounds& oldBounds) {
 	if(layer != nullptr) layer->trees[static_cast<int>(subLayer)].updateObjectBounds(updatedPart, oldBounds);
@@ -8,6 +10,21 @@ void LayerRef::notifyPartBoundsUpdated(const Part* updatedPart, const Bounds& ol
 void LayerRef::notifyPartGroupBoundsUpdated(const Part* mainPart, const Bounds& oldMainPartBounds) {
 	if(layer != nullptr) layer->trees[static_cast<int>(subLayer)].updateObjectGroupBounds(mainPart, oldMainPartBounds);
 }
+void LayerRef::notifyPartGroupBoundsOutdated(const Part* mainPart, const Bounds& oldMainPartBounds) {
+	if(layer != nullptr) layer->trees[static_cast<int>(subLayer)].markObjectGroupBoundsOutdated(mainPart, oldMainPartBounds);
+}
+void LayerRef::notifyPartGroupBoundsOutdated(const Part* mainPart, const Bounds& oldMainPartBounds, double margin, Vec3 predictedMovement) {
+	if(layer == nullptr) return;
+	BoundsTree<Part>& tree = layer->trees[static_cast<int>(subLayer)];
+
+	Vec3Fix growMin(std::min(predictedMovement.x, 0.0) - margin, std::min(predictedMovement.y, 0.0) - margin, std::min(predictedMovement.z, 0.0) - margin);
+	Vec3Fix growMax(std::max(predictedMovement.x, 0.0) + margin, std::max(predictedMovement.y, 0.0) + margin, std::max(predictedMovement.z, 0.0) + margin);
+	tree.markObjectGroupBoundsOutdated(mainPart, oldMainPartBounds, [&](const Part& part, const Bounds& currentLeafBounds) {
+		Bounds exactBounds = part.getBounds();
+		if(currentLeafBounds.contains(exactBounds)) return currentLeafBounds;
+		return Bounds(exactBounds.min + growMin, exactBounds.max + growMax);
+	});
+}
 
 void LayerRef::notifyPartStdMoved(Part* oldPartPtr, Part* newPartPtr) noexcept {
 	if(layer != nullptr) {
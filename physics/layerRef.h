@@ -1,6 +1,7 @@
 #pragma once
 
 #include "math/bounds.h"
+#include "math/linalg/vec.h"
 
 class WorldLayer;
 class Part;
@@ -20,6 +21,15 @@ public:
 
 	void notifyPartBoundsUpdated(const Part* updatedPart, const Bounds& oldBounds);
 	void notifyPartGroupBoundsUpdated(const Part* mainPart, const Bounds& oldMainPartBounds);
+	/*
+		Like notifyPartGroupBoundsUpdated, but leaves the nodes above the group outdated until the tree's refitOutdatedBounds is called
+	*/
+	void notifyPartGroupBoundsOutdated(const Part* mainPart, const Bounds& oldMainPartBounds);
+	/*
+		Same as above, but the leaves of the group are enlarged by margin in all directions and by predictedMovement in its direction, 
+		and left alone as long as they still contain their part
+	*/
+	void notifyPartGroupBoundsOutdated(const Part* mainPart, const Bounds& oldMainPartBounds, double margin, Vec3 predictedMovement);
 	/*
 		When a part is std::move'd to a different location, this function is called to update any pointers
 		This is something that in general should not be performed when the part is already in a world, but this function is provided for completeness
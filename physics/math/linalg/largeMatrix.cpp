@@ -62,3 +62,182 @@ void destructiveSolve(LargeMatrix<T>& m, LargeVector<T>& v) {
 template void destructiveSolve<double>(LargeMatrix<double>& m, LargeVector<double>& v);
 template void destructiveSolve<float>(LargeMatrix<float>& m, LargeVector<float>& v);
 
+template<typename T>
+LargeLUDecomposition<T>::LargeLUDecomposition(LargeMatrix<T> matrix) : lu(std::move(matrix)), permutation(lu.height) {
+	if(lu.width != lu.height) throw "Dimensions do not align!";
+	size_t size = lu.height;
+
+	for(size_t i = 0; i < size; i++) {
+		permutation[i] = i;
+	}
+
+	for(size_t i = 0; i < size; i++) {
+		T bestPivot = std::abs(lu.get(i, i));
+		size_t bestPivotIndex = i;
+		for(size_t j = i + 1; j < size; j++) {
+			T newPivot = std::abs(lu.get(j, i));
+			if(newPivot > bestPivot) {
+				bestPivot = newPivot;
+				bestPivotIndex = j;
+			}
+		}
+
+		if(bestPivotIndex != i) {
+			for(size_t k = 0; k < size; k++) {
+				std::swap(lu.get(i, k), lu.get(bestPivotIndex, k));
+			}
+			std::swap(permutation[i], permutation[bestPivotIndex]);
+		}
+
+		T pivot = lu.get(i, i);
+		for(size_t j = i + 1; j < size; j++) {
+			T factor = lu.get(j, i) / pivot;
+			lu.get(j, i) = factor;
+			for(size_t k = i + 1; k < size; k++) {
+				lu.get(j, k) -= lu.get(i, k) * factor;
+			}
+		}
+	}
+}
+
+template<typename T>
+void LargeLUDecomposition<T>::solve(LargeVector<T>& v) const {
+	if(v.size != size()) throw "Dimensions do not align!";
+
+	LargeVector<T> result(size());
+	for(size_t i = 0; i < size(); i++) {
+		result[i] = v[permutation[i]];
+	}
+
+	// forward substitution with L
+	for(size_t i = 0; i < size(); i++) {
+		T value = result[i];
+		for(size_t k = 0; k < i; k++) {
+			value -= lu.get(i, k) * result[k];
+		}
+		result[i] = value;
+	}
+
+	// back substitution with U
+	for(size_t i = size(); i-- > 0;) {
+		T value = result[i];
+		for(size_t k = i + 1; k < size(); k++) {
+			value -= lu.get(i, k) * result[k];
+		}
+		result[i] = value / lu.get(i, i);
+	}
+
+	v = std::move(result);
+}
+
+template<typename T>
+void LargeLUDecomposition<T>::solve(LargeMatrix<T>& rightHandSides) const {
+	if(rightHandSides.height != size()) throw "Dimensions do not align!";
+	size_t count = rightHandSides.width;
+
+	LargeMatrix<T> result(count, size());
+	for(size_t i = 0; i < size(); i++) {
+		for(size_t c = 0; c < count; c++) {
+			result.get(i, c) = rightHandSides.get(permutation[i], c);
+		}
+	}
+
+	// rows are stored contiguously, so every step is applied to all right hand sides at once
+	for(size_t i = 0; i < size(); i++) {
+		for(size_t k = 0; k < i; k++) {
+			T factor = lu.get(i, k);
+			for(size_t c = 0; c < count; c++) {
+				result.get(i, c) -= factor * result.get(k, c);
+			}
+		}
+	}
+
+	for(size_t i = size(); i-- > 0;) {
+		for(size_t k = i + 1; k < size(); k++) {
+			T factor = lu.get(i, k);
+			for(size_t c = 0; c < count; c++) {
+				result.get(i, c) -= factor * result.get(k, c);
+			}
+		}
+		T pivot = lu.get(i, i);
+		for(size_t c = 0; c < count; c++) {
+			result.get(i, c) /= pivot;
+		}
+	}
+
+	rightHandSides = std::move(result);
+}
+
+template class LargeLUDecomposition<double>;
+template class LargeLUDecomposition<float>;
+
+template<typename T, size_t BlockSize>
+static Vector<T, BlockSize> getBlockOf(const LargeVector<T>& v, size_t blockIndex) {
+	Vector<T, BlockSize> result;
+	for(size_t i = 0; i < BlockSize; i++) {
+		result[i] = v[blockIndex * BlockSize + i];
+	}
+	return result;
+}
+
+template<typename T, size_t BlockSize>
+SparseBlockLUDecomposition<T, BlockSize>::SparseBlockLUDecomposition(SparseBlockMatrix<T, BlockSize> matrix) : factors(std::move(matrix)), inverseDiagonal(factors.blockCount()) {
+	size_t blockCount = factors.blockCount();
+
+	// the elimination below relies on the nonzero pattern being symmetric, and on every diagonal block being present
+	for(size_t row = 0; row < blockCount; row++) {
+		factors.getBlock(row, row);
+		for(size_t i = 0; i < factors.blockRows[row].size(); i++) {
+			factors.getBlock(factors.blockRows[row][i].column, row);
+		}
+	}
+
+	for(size_t k = 0; k < blockCount; k++) {
+		inverseDiagonal[k] = ~*factors.findBlock(k, k);
+
+		// as the pattern is symmetric, the rows that have a block in column k are the columns right of the diagonal in row k
+		const std::vector<typename SparseBlockMatrix<T, BlockSize>::Block>& pivotRow = factors.blockRows[k];
+		for(const typename SparseBlockMatrix<T, BlockSize>::Block& target : pivotRow) {
+			size_t i = target.column;
+			if(i <= k) continue;
+
+			Matrix<T, BlockSize, BlockSize>& lowerRef = factors.getBlock(i, k);
+			lowerRef = lowerRef * inverseDiagonal[k];
+			Matrix<T, BlockSize, BlockSize> lower = lowerRef;
+
+			for(const typename SparseBlockMatrix<T, BlockSize>::Block& upper : pivotRow) {
+				if(upper.column <= k) continue;
+				factors.getBlock(i, upper.column) -= lower * upper.value;
+			}
+		}
+	}
+}
+
+template<typename T, size_t BlockSize>
+void SparseBlockLUDecomposition<T, BlockSize>::solve(LargeVector<T>& v) const {
+	if(v.size != factors.size()) throw "Dimensions do not align!";
+	size_t blockCount = factors.blockCount();
+
+	// forward substitution with L
+	for(size_t row = 0; row < blockCount; row++) {
+		Vector<T, BlockSize> value = getBlockOf<T, BlockSize>(v, row);
+		for(const typename SparseBlockMatrix<T, BlockSize>::Block& block : factors.blockRows[row]) {
+			if(block.column >= row) break;
+			value -= block.value * getBlockOf<T, BlockSize>(v, block.column);
+		}
+		v.setSubVector(row * BlockSize, value);
+	}
+
+	// back substitution with U
+	for(size_t row = blockCount; row-- > 0;) {
+		Vector<T, BlockSize> value = getBlockOf<T, BlockSize>(v, row);
+		for(const typename SparseBlockMatrix<T, BlockSize>::Block& block : factors.blockRows[row]) {
+			if(block.column <= row) continue;
+			value -= block.value * getBlockOf<T, BlockSize>(v, block.column);
+		}
+		v.setSubVector(row * BlockSize, inverseDiagonal[row] * value);
+	}
+}
+
+template class SparseBlockLUDecomposition<double, 3>;
+template class SparseBlockLUDecomposition<float, 3>;
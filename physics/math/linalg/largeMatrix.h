@@ -2,6 +2,8 @@
 
 #include "mat.h"
 #include <utility>
+#include <vector>
+#include <algorithm>
 
 template<typename T>
 class LargeVector {
@@ -203,6 +205,128 @@ public:
 	}
 };
 
+/*
+	Square matrix made up of BlockSize x BlockSize blocks, only the blocks that have been set are stored
+	Every block row keeps its blocks sorted by column
+*/
+template<typename T, size_t BlockSize>
+class SparseBlockMatrix {
+public:
+	struct Block {
+		size_t column;
+		Matrix<T, BlockSize, BlockSize> value;
+	};
+
+	std::vector<std::vector<Block>> blockRows;
+
+	SparseBlockMatrix(size_t blockCount) : blockRows(blockCount) {}
+
+	inline size_t blockCount() const { return blockRows.size(); }
+	inline size_t size() const { return blockRows.size() * BlockSize; }
+
+	/*
+		Returns the block at the given block row and column, a zero block is inserted if it wasn't stored yet
+	*/
+	Matrix<T, BlockSize, BlockSize>& getBlock(size_t blockRow, size_t blockCol) {
+		assert(blockRow < blockCount() && blockCol < blockCount());
+		std::vector<Block>& row = blockRows[blockRow];
+		auto found = std::lower_bound(row.begin(), row.end(), blockCol, [](const Block& block, size_t col) {return block.column < col; });
+		if(found == row.end() || found->column != blockCol) {
+			found = row.insert(found, Block{blockCol, Matrix<T, BlockSize, BlockSize>::ZEROS()});
+		}
+		return found->value;
+	}
+
+	/*
+		Returns nullptr for blocks that are not stored
+	*/
+	const Matrix<T, BlockSize, BlockSize>* findBlock(size_t blockRow, size_t blockCol) const {
+		assert(blockRow < blockCount() && blockCol < blockCount());
+		const std::vector<Block>& row = blockRows[blockRow];
+		auto found = std::lower_bound(row.begin(), row.end(), blockCol, [](const Block& block, size_t col) {return block.column < col; });
+		if(found == row.end() || found->column != blockCol) {
+			return nullptr;
+		}
+		return &found->value;
+	}
+
+	inline void setBlock(size_t blockRow, size_t blockCol, const Matrix<T, BlockSize, BlockSize>& value) {
+		getBlock(blockRow, blockCol) = value;
+	}
+
+	size_t storedBlockCount() const {
+		size_t total = 0;
+		for(const std::vector<Block>& row : blockRows) {
+			total += row.size();
+		}
+		return total;
+	}
+
+	LargeMatrix<T> toDense() const {
+		LargeMatrix<T> result(size(), size());
+		for(T& value : result) {
+			value = T(0);
+		}
+		for(size_t blockRow = 0; blockRow < blockCount(); blockRow++) {
+			for(const Block& block : blockRows[blockRow]) {
+				result.setSubMatrix(blockRow * BlockSize, block.column * BlockSize, block.value);
+			}
+		}
+		return result;
+	}
+};
+
+/*
+	LU decomposition with partial pivoting of a square LargeMatrix
+	Once factored, any number of right hand sides can be solved, either one at a time or all at once as the columns of a LargeMatrix
+*/
+template<typename T>
+class LargeLUDecomposition {
+	// L below the diagonal, its diagonal consists of ones, U on and above the diagonal
+	LargeMatrix<T> lu;
+	// row i of lu came from row permutation[i] of the original matrix
+	std::vector<size_t> permutation;
+public:
+	LargeLUDecomposition(LargeMatrix<T> matrix);
+
+	inline size_t size() const { return lu.height; }
+
+	/*
+		Overwrites v with the solution x of matrix * x = v
+	*/
+	void solve(LargeVector<T>& v) const;
+
+	/*
+		Solves for every column of rightHandSides at once, overwriting them with the solutions
+	*/
+	void solve(LargeMatrix<T>& rightHandSides) const;
+};
+
+/*
+	Block LU decomposition of a SparseBlockMatrix, without pivoting
+	Meant for block diagonally dominant or symmetric positive definite systems such as the constraint systems, every diagonal block must be invertible
+	Once factored, any number of right hand sides can be solved, each costing only a sparse forward and back substitution
+*/
+template<typename T, size_t BlockSize>
+class SparseBlockLUDecomposition {
+	// the blocks left of the diagonal hold L, which has identity blocks on its diagonal, the other blocks hold U
+	SparseBlockMatrix<T, BlockSize> factors;
+	std::vector<Matrix<T, BlockSize, BlockSize>> inverseDiagonal;
+public:
+	SparseBlockLUDecomposition(SparseBlockMatrix<T, BlockSize> matrix);
+
+	inline size_t size() const { return factors.size(); }
+	/*
+		Number of blocks stored in L and U, including the fill-in created by the decomposition
+	*/
+	inline size_t storedBlockCount() const { return factors.storedBlockCount(); }
+
+	/*
+		Overwrites v with the solution x of matrix * x = v
+	*/
+	void solve(LargeVector<T>& v) const;
+};
+
 template<typename T>
 LargeVector<T> operator*(const LargeMatrix<T>& m, const LargeVector<T>& v) {
 	if (v.size != m.width) throw "Dimensions do not align!";
@@ -235,6 +359,25 @@ LargeVector<T> operator*(const LargeSymmetricMatrix<T>& m, const LargeVector<T>&
 	return newVector;
 }
 
+template<typename T, size_t BlockSize>
+LargeVector<T> operator*(const SparseBlockMatrix<T, BlockSize>& m, const LargeVector<T>& v) {
+	if(v.size != m.size()) throw "Dimensions do not align!";
+	LargeVector<T> newVector(m.size());
+
+	for(size_t blockRow = 0; blockRow < m.blockCount(); blockRow++) {
+		Vector<T, BlockSize> total;
+		for(const typename SparseBlockMatrix<T, BlockSize>::Block& block : m.blockRows[blockRow]) {
+			Vector<T, BlockSize> part;
+			for(size_t i = 0; i < BlockSize; i++) {
+				part[i] = v[block.column * BlockSize + i];
+			}
+			total += block.value * part;
+		}
+		newVector.setSubVector(blockRow * BlockSize, total);
+	}
+	return newVector;
+}
+
 template<typename T>
 void destructiveSolve(LargeMatrix<T>& m, LargeVector<T>& v);
 
@@ -11,6 +11,7 @@ public:
 
 	virtual void apply(WorldPrototype* world) override {
 		for (MotorizedPhysical* p : world->iterPhysicals()) {
+			if(p->isSleeping) continue; // resting on something, applying gravity would wake it up
 			p->applyForceAtCenterOfMass(gravity * p->totalMass);
 		}
 	}
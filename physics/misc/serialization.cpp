@@ -236,7 +236,7 @@ void SerializationSessionPrototype::serializePhysicalInContext(const Physical& p
 }
 
 void SerializationSessionPrototype::serializeMotorizedPhysicalInContext(const MotorizedPhysical& phys, std::ostream& ostream) {
-	::serialize<Motion>(phys.motionOfCenterOfMass, ostream);
+	::serialize<Motion>(phys.getMotionOfCenterOfMass(), ostream);
 	::serialize<GlobalCFrame>(phys.getMainPart()->getCFrame(), ostream);
 
 	serializePhysicalInContext(phys, ostream);
@@ -262,7 +262,7 @@ MotorizedPhysical* DeSerializationSessionPrototype::deserializeMotorizedPhysical
 	r.setCFrame(cf);
 	MotorizedPhysical* mainPhys = new MotorizedPhysical(std::move(r));
 	indexToPhysicalMap.push_back(static_cast<Physical*>(mainPhys));
-	mainPhys->motionOfCenterOfMass = motion;
+	mainPhys->setMotionOfCenterOfMass(motion);
 
 	deserializeConnectionsOfPhysicalWithContext(*mainPhys, istream);
 
@@ -373,6 +373,8 @@ void DeSerializationSessionPrototype::deserializeWorld(WorldPrototype& world, st
 		p->setCFrame(cf);
 		world.addTerrainPart(p);
 	}
+	world.optimizeObjectTrees();
+	world.optimizeTerrain();
 
 	std::uint32_t constraintCount = ::deserialize<std::uint32_t>(istream);
 	world.constraints.reserve(constraintCount);
@@ -0,0 +1,164 @@
+#include "overlappingPairCache.h"
+
+#include "part.h"
+#include "physical.h"
+
+#include <functional>
+
+using CompiledChild = CompiledBoundsTree::Child;
+
+OverlappingPairCache::PairKey::PairKey(const Part* a, const Part* b) : first(std::less<const Part*>()(a, b) ? a : b), second(std::less<const Part*>()(a, b) ? b : a) {}
+
+size_t OverlappingPairCache::PairKeyHash::operator()(const PairKey& key) const {
+	size_t h1 = std::hash<const Part*>()(key.first);
+	size_t h2 = std::hash<const Part*>()(key.second);
+	return h1 ^ (h2 + 0x9e3779b97f4a7c15 + (h1 << 6) + (h1 >> 2));
+}
+
+void OverlappingPairCache::addPair(std::vector<OverlappingPair>& pairs, PairIndexMap& indices, const OverlappingPair& pair) {
+	indices.emplace(PairKey(pair.p1, pair.p2), pairs.size());
+	pairs.push_back(pair);
+}
+
+void OverlappingPairCache::removePair(std::vector<OverlappingPair>& pairs, PairIndexMap& indices, size_t index) {
+	indices.erase(PairKey(pairs[index].p1, pairs[index].p2));
+	if(index != pairs.size() - 1) {
+		pairs[index] = pairs.back();
+		indices[PairKey(pairs[index].p1, pairs[index].p2)] = index;
+	}
+	pairs.pop_back();
+}
+
+static void collectLeafBounds(const CompiledBoundsTree& tree, std::unordered_map<const void*, Bounds>& output) {
+	if(tree.isEmpty()) return;
+	if(tree.root.isLeafNode()) {
+		output[tree.getObject(tree.root)] = tree.root.bounds;
+		return;
+	}
+	for(const CompiledBoundsTree::Node& node : tree.nodes) {
+		for(int i = 0; i < node.childCount; i++) {
+			CompiledChild child = tree.getChild(node, i);
+			if(child.isLeafNode()) {
+				output[tree.getObject(child)] = child.bounds;
+			}
+		}
+	}
+}
+
+// calls func(Part* part, const Bounds& leafBounds) for every leaf that intersects bounds, child must intersect bounds
+template<typename Func>
+static void forEachLeafInBounds(const CompiledBoundsTree& tree, const CompiledChild& child, const Bounds& bounds, const Func& func) {
+	if(child.isLeafNode()) {
+		func(static_cast<Part*>(tree.getObject(child)), child.bounds);
+		return;
+	}
+	const CompiledBoundsTree::Node& node = tree.getNode(child);
+	for(int mask = CompiledBoundsTree::intersectingChildren(node, bounds); mask != 0; mask &= mask - 1) {
+		forEachLeafInBounds(tree, tree.getChild(node, lowestChildInMask(mask)), bounds, func);
+	}
+}
+
+template<typename Func>
+static void forEachLeafInBounds(const CompiledBoundsTree& tree, const Bounds& bounds, const Func& func) {
+	if(tree.isEmpty() || !intersects(tree.root.bounds, bounds)) return;
+	forEachLeafInBounds(tree, tree.root, bounds, func);
+}
+
+bool OverlappingPairCache::canUpdate(const BoundsTree<Part>& objectTree, const BoundsTree<Part>& terrainTree) const {
+	return isBuilt && objectTree.trackLeafChanges && !objectTree.leafChangesIncomplete && terrainTree.modificationCount == terrainModificationCount;
+}
+
+void OverlappingPairCache::rebuild(const std::vector<ColissionCandidate>& objectCandidates, const std::vector<ColissionCandidate>& terrainCandidates, const BoundsTree<Part>& objectTree, const BoundsTree<Part>& terrainTree) {
+	std::unordered_map<const void*, Bounds> leafBounds;
+	collectLeafBounds(objectTree.compiled, leafBounds);
+	collectLeafBounds(terrainTree.compiled, leafBounds);
+
+	auto rebuildList = [&leafBounds](std::vector<OverlappingPair>& pairs, PairIndexMap& indices, const std::vector<ColissionCandidate>& candidates) {
+		std::vector<OverlappingPair> newPairs;
+		PairIndexMap newIndices;
+		newPairs.reserve(candidates.size());
+		for(const ColissionCandidate& candidate : candidates) {
+			OverlappingPair pair{candidate.p1, candidate.p2, leafBounds[candidate.p1], leafBounds[candidate.p2], ColissionPairData()};
+			auto found = indices.find(PairKey(candidate.p1, candidate.p2));
+			if(found != indices.end()) {
+				pair.data = pairs[found->second].data;
+			}
+			addPair(newPairs, newIndices, pair);
+		}
+		pairs = std::move(newPairs);
+		indices = std::move(newIndices);
+	};
+	rebuildList(objectPairs, objectPairIndices, objectCandidates);
+	rebuildList(terrainPairs, terrainPairIndices, terrainCandidates);
+
+	terrainModificationCount = terrainTree.modificationCount;
+	isBuilt = true;
+	rebuildCount++;
+}
+
+void OverlappingPairCache::update(const BoundsTree<Part>& objectTree, const BoundsTree<Part>& terrainTree) {
+	assert(canUpdate(objectTree, terrainTree));
+	updateCount++;
+	if(objectTree.changedLeaves.empty()) return;
+
+	// a leaf can have changed several times, only its latest bounds count
+	std::unordered_map<const void*, size_t> changeIndices;
+	std::vector<BoundsTree<Part>::LeafChange> changes;
+	for(const BoundsTree<Part>::LeafChange& change : objectTree.changedLeaves) {
+		auto inserted = changeIndices.emplace(change.object, changes.size());
+		if(inserted.second) {
+			changes.push_back(change);
+		} else {
+			changes[inserted.first->second].bounds = change.bounds;
+		}
+	}
+
+	// drop the pairs of changed leaves that no longer overlap
+	auto refreshBounds = [&](const Part* part, Bounds& bounds) {
+		auto found = changeIndices.find(part);
+		if(found == changeIndices.end()) return false;
+		bounds = changes[found->second].bounds;
+		return true;
+	};
+	for(size_t i = 0; i < objectPairs.size();) {
+		OverlappingPair& pair = objectPairs[i];
+		bool changed = refreshBounds(pair.p1, pair.bounds1);
+		changed = refreshBounds(pair.p2, pair.bounds2) || changed;
+		if(changed && !intersects(pair.bounds1, pair.bounds2)) {
+			removePair(objectPairs, objectPairIndices, i);
+		} else {
+			i++;
+		}
+	}
+	for(size_t i = 0; i < terrainPairs.size();) {
+		OverlappingPair& pair = terrainPairs[i];
+		if(refreshBounds(pair.p1, pair.bounds1) && !intersects(pair.bounds1, pair.bounds2)) {
+			removePair(terrainPairs, terrainPairIndices, i);
+		} else {
+			i++;
+		}
+	}
+
+	// and add the pairs they newly overlap with
+	for(const BoundsTree<Part>::LeafChange& change : changes) {
+		Part* part = static_cast<Part*>(const_cast<void*>(change.object));
+		const MotorizedPhysical* physical = part->parent->mainPhysical;
+		forEachLeafInBounds(objectTree.compiled, change.bounds, [&](Part* other, const Bounds& otherBounds) {
+			if(other == part || other->parent->mainPhysical == physical) return;
+			if(objectPairIndices.find(PairKey(part, other)) != objectPairIndices.end()) return;
+			addPair(objectPairs, objectPairIndices, OverlappingPair{part, other, change.bounds, otherBounds, ColissionPairData()});
+		});
+		forEachLeafInBounds(terrainTree.compiled, change.bounds, [&](Part* terrain, const Bounds& terrainBounds) {
+			if(terrainPairIndices.find(PairKey(part, terrain)) != terrainPairIndices.end()) return;
+			addPair(terrainPairs, terrainPairIndices, OverlappingPair{part, terrain, change.bounds, terrainBounds, ColissionPairData()});
+		});
+	}
+}
+
+void OverlappingPairCache::clear() {
+	objectPairs.clear();
+	terrainPairs.clear();
+	objectPairIndices.clear();
+	terrainPairIndices.clear();
+	isBuilt = false;
+}
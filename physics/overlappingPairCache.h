@@ -0,0 +1,106 @@
+#pragma once
+
+#include "math/bounds.h"
+#include "math/linalg/vec.h"
+#include "datastructures/boundsTree.h"
+#include "geometry/intersection.h"
+#include "contactSolver.h"
+
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+
+class Part;
+
+/*
+	Data kept for a pair of parts for as long as their bounds overlap, carried over from one tick to the next
+*/
+struct ColissionPairData {
+	// number of consecutive narrow phase tests that found the parts intersecting, 0 if the last one didn't
+	size_t ticksInContact = 0;
+	// exitVector of the last intersection
+	Vec3 lastExitVector = Vec3(0.0, 0.0, 0.0);
+	// where the GJK search of the last test ended, local to p1
+	IntersectionWarmStart gjkWarmStart;
+	// contact points of the sequential impulse contact solver
+	ContactManifold contactManifold;
+};
+
+struct OverlappingPair {
+	Part* p1;
+	Part* p2;
+	// the leaf bounds of p1 and p2 in their trees
+	Bounds bounds1;
+	Bounds bounds2;
+	ColissionPairData data;
+};
+
+/*
+	Two parts whose bounds overlap, produced by the broad phase and checked by the narrow phase
+	pairData points into the OverlappingPairCache and stays valid until its next update
+*/
+struct ColissionCandidate {
+	Part* p1;
+	Part* p2;
+	ColissionPairData* pairData;
+};
+
+/*
+	All pairs of parts whose leaf bounds overlap in the object tree, or between the object and the terrain tree, kept from one tick to the next
+
+	As long as the object tree only reports changed leaf bounds (see BoundsTree::trackLeafChanges) and the terrain tree is left alone,
+	only the pairs of the changed leaves are looked at, and only the changed leaves are looked up in the trees.
+	Anything else, like adding, removing or regrouping parts, requires the pairs to be rebuilt from a full broad phase.
+	Parts of the same MotorizedPhysical never form a pair, just like parts within the same group of the tree.
+	Pairs keep the order in which they were found, so the result only depends on the changes made, not on where the parts are in memory
+*/
+class OverlappingPairCache {
+	struct PairKey {
+		const Part* first;
+		const Part* second;
+
+		PairKey(const Part* a, const Part* b);
+		inline bool operator==(const PairKey& other) const { return first == other.first && second == other.second; }
+	};
+	struct PairKeyHash {
+		size_t operator()(const PairKey& key) const;
+	};
+	using PairIndexMap = std::unordered_map<PairKey, size_t, PairKeyHash>;
+
+	std::vector<OverlappingPair> objectPairs;
+	std::vector<OverlappingPair> terrainPairs;
+	PairIndexMap objectPairIndices;
+	PairIndexMap terrainPairIndices;
+	size_t terrainModificationCount = 0;
+	bool isBuilt = false;
+
+	static void addPair(std::vector<OverlappingPair>& pairs, PairIndexMap& indices, const OverlappingPair& pair);
+	static void removePair(std::vector<OverlappingPair>& pairs, PairIndexMap& indices, size_t index);
+public:
+	// number of full rebuilds and of incremental updates so far
+	size_t rebuildCount = 0;
+	size_t updateCount = 0;
+
+	inline const std::vector<OverlappingPair>& getObjectPairs() const { return objectPairs; }
+	inline const std::vector<OverlappingPair>& getTerrainPairs() const { return terrainPairs; }
+	inline std::vector<OverlappingPair>& getObjectPairs() { return objectPairs; }
+	inline std::vector<OverlappingPair>& getTerrainPairs() { return terrainPairs; }
+
+	/*
+		Returns true if update can bring the pairs up to date with the given trees, otherwise they must be rebuilt
+	*/
+	bool canUpdate(const BoundsTree<Part>& objectTree, const BoundsTree<Part>& terrainTree) const;
+
+	/*
+		Replaces all pairs with the given ones, the data of pairs that were already present is kept
+		The candidates must be all overlapping pairs within the object tree and between the object and the terrain tree, of the current compiled trees
+	*/
+	void rebuild(const std::vector<ColissionCandidate>& objectCandidates, const std::vector<ColissionCandidate>& terrainCandidates, const BoundsTree<Part>& objectTree, const BoundsTree<Part>& terrainTree);
+
+	/*
+		Applies the leaf changes recorded by objectTree since the last update or rebuild, the trees must be compiled
+	*/
+	void update(const BoundsTree<Part>& objectTree, const BoundsTree<Part>& terrainTree);
+
+	void clear();
+};
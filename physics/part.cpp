@@ -74,9 +74,9 @@ Part& Part::operator=(Part&& other) noexcept {
 	return *this;
 }
 
-PartIntersection Part::intersects(const Part& other) const {
+PartIntersection Part::intersects(const Part& other, IntersectionWarmStart* warmStart) const {
 	CFrame relativeTransform = this->cframe.globalToLocal(other.cframe);
-	std::optional<Intersection> result = intersectsTransformed(this->hitbox, other.hitbox, relativeTransform);
+	std::optional<Intersection> result = intersectsTransformed(this->hitbox, other.hitbox, relativeTransform, warmStart);
 	if(result) {
 		Position intersection = this->cframe.localToGlobal(result.value().intersection);
 		Vec3 exitVector = this->cframe.localToRelative(result.value().exitVector);
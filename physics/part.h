@@ -8,6 +8,7 @@ class ConnectedPhysical;
 class MotorizedPhysical;
 class WorldPrototype;
 #include "geometry/shape.h"
+#include "geometry/intersection.h"
 #include "math/linalg/mat.h"
 #include "math/position.h"
 #include "math/globalCFrame.h"
@@ -69,7 +70,7 @@ public:
 	Part& operator=(Part&& other) noexcept;
 
 
-	PartIntersection intersects(const Part& other) const;
+	PartIntersection intersects(const Part& other, IntersectionWarmStart* warmStart = nullptr) const;
 	void scale(double scaleX, double scaleY, double scaleZ);
 
 	Bounds getBounds() const;
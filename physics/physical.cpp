@@ -8,6 +8,7 @@
 #include "math/linalg/trigonometry.h"
 
 #include "debug.h"
+#include "physicsProfiler.h"
 #include <algorithm>
 #include <limits>
 
@@ -554,6 +555,9 @@ void ConnectedPhysical::setCFrame(const GlobalCFrame& newCFrame) {
 }
 
 void MotorizedPhysical::setCFrame(const GlobalCFrame& newCFrame) {
+	// a moved physical has to stay at rest for the full sleep delay again before it can fall asleep
+	ticksAtRest = 0;
+	wakeUp();
 	rigidBody.setCFrame(newCFrame);
 	for(ConnectedPhysical& conPhys : childPhysicals) {
 		conPhys.refreshCFrameRecursive();
@@ -600,8 +604,7 @@ void MotorizedPhysical::refreshPhysicalProperties() {
 
 	SymmetricMat3 totalInertia = cache.getInertia();
 
-	this->forceResponse = SymmetricMat3::IDENTITY() * (1 / cache.totalMass);
-	this->momentResponse = ~totalInertia;
+	setResponses(SymmetricMat3::IDENTITY() * (1 / cache.totalMass), ~totalInertia);
 }
 
 void ConnectedPhysical::refreshCFrame() {
@@ -631,18 +634,31 @@ void MotorizedPhysical::fullRefreshOfConnectedPhysicals() {
 #pragma region update
 
 void MotorizedPhysical::update(double deltaT) {
+	DynamicsState state = isInDynamicsStore() ? world->dynamicsStore.get(dynamicsIndex) : dynamicsState;
 
-	Vec3 accel = forceResponse * totalForce * deltaT;
+	Vec3 accel = state.forceResponse * state.totalForce * deltaT;
 	
-	Vec3 localMoment = getCFrame().relativeToLocal(totalMoment);
-	Vec3 localRotAcc = momentResponse * localMoment * deltaT;
+	Vec3 localMoment = getCFrame().relativeToLocal(state.totalMoment);
+	Vec3 localRotAcc = state.momentResponse * localMoment * deltaT;
 	Vec3 rotAcc = getCFrame().localToRelative(localRotAcc);
 
-	totalForce = Vec3();
-	totalMoment = Vec3();
+	state.totalForce = Vec3();
+	state.totalMoment = Vec3();
 
-	motionOfCenterOfMass.translation.translation[0] += accel;
-	motionOfCenterOfMass.rotation.rotation[0] += rotAcc;
+	state.motionOfCenterOfMass.translation.translation[0] += accel;
+	state.motionOfCenterOfMass.rotation.rotation[0] += rotAcc;
+
+	if(isInDynamicsStore()) {
+		world->dynamicsStore.set(dynamicsIndex, state);
+	} else {
+		dynamicsState = state;
+	}
+
+	updatePosition(deltaT, accel);
+}
+
+void MotorizedPhysical::updatePosition(double deltaT, Vec3 velocityStep) {
+	markBoundsOutdated();
 
 	Vec3 oldCenterOfMass = this->totalCenterOfMass;
 	Vec3 angularMomentumBefore = getTotalAngularMomentum();
@@ -651,21 +667,50 @@ void MotorizedPhysical::update(double deltaT) {
 	refreshPhysicalProperties();
 
 	Vec3 deltaCOM = this->totalCenterOfMass - oldCenterOfMass;
-	Vec3 movementOfCenterOfMass = motionOfCenterOfMass.getVelocity() * deltaT + accel * deltaT * deltaT * 0.5 - getCFrame().localToRelative(deltaCOM);
+	Vec3 movementOfCenterOfMass = getVelocityOfCenterOfMass() * deltaT + velocityStep * deltaT * deltaT * 0.5 - getCFrame().localToRelative(deltaCOM);
 
-	rotateAroundCenterOfMass(Rotation::fromRotationVec(motionOfCenterOfMass.getAngularVelocity() * deltaT));
+	rotateAroundCenterOfMass(Rotation::fromRotationVec(getAngularVelocityOfCenterOfMass() * deltaT));
 	translateUnsafeRecursive(movementOfCenterOfMass);
 
 	Vec3 angularMomentumAfter = getTotalAngularMomentum();
 
-	SymmetricMat3 globalMomentResponse = getCFrame().getRotation().localToGlobal(momentResponse);
+	SymmetricMat3 globalMomentResponse = getCFrame().getRotation().localToGlobal(getMomentResponse());
 
 	Vec3 deltaAngularVelocity = globalMomentResponse * (angularMomentumAfter - angularMomentumBefore);
-	this->motionOfCenterOfMass.rotation.rotation[0] -= deltaAngularVelocity;
+	setAngularVelocityOfCenterOfMass(getAngularVelocityOfCenterOfMass() - deltaAngularVelocity);
 
 	updateAttachedPhysicals();
 }
 
+void MotorizedPhysical::markBoundsOutdated() {
+	if(hasOutdatedBounds || world == nullptr) return;
+	hasOutdatedBounds = true;
+	mainPartBoundsInTree = getMainPart()->getBounds();
+}
+
+void MotorizedPhysical::fallAsleep() {
+	if(isSleeping) return;
+	isSleeping = true;
+	DynamicsState state = isInDynamicsStore() ? world->dynamicsStore.get(dynamicsIndex) : dynamicsState;
+	state.motionOfCenterOfMass = Motion();
+	state.totalForce = Vec3();
+	state.totalMoment = Vec3();
+	if(isInDynamicsStore()) {
+		world->dynamicsStore.set(dynamicsIndex, state);
+	} else {
+		dynamicsState = state;
+	}
+	sleepStatistics.addToTally(SleepTransition::FELL_ASLEEP, 1);
+}
+
+void MotorizedPhysical::wakeUp() {
+	if(!isSleeping) return;
+	isSleeping = false;
+	// it has to stay at rest for the full sleep delay again, or a physical that is touched every now and then would never be simulated for more than a tick
+	ticksAtRest = 0;
+	sleepStatistics.addToTally(SleepTransition::WOKE_UP, 1);
+}
+
 #pragma endregion
 
 /*
@@ -676,7 +721,12 @@ void MotorizedPhysical::update(double deltaT) {
 
 void MotorizedPhysical::applyForceAtCenterOfMass(Vec3 force) {
 	assert(isVecValid(force));
-	totalForce += force;
+	wakeUp();
+	if(isInDynamicsStore()) {
+		world->dynamicsStore.setForce(dynamicsIndex, world->dynamicsStore.getForce(dynamicsIndex) + force);
+	} else {
+		dynamicsState.totalForce += force;
+	}
 
 	Debug::logVector(getCenterOfMass(), force, Debug::FORCE);
 }
@@ -684,7 +734,12 @@ void MotorizedPhysical::applyForceAtCenterOfMass(Vec3 force) {
 void MotorizedPhysical::applyForce(Vec3Relative origin, Vec3 force) {
 	assert(isVecValid(origin));
 	assert(isVecValid(force));
-	totalForce += force;
+	wakeUp();
+	if(isInDynamicsStore()) {
+		world->dynamicsStore.setForce(dynamicsIndex, world->dynamicsStore.getForce(dynamicsIndex) + force);
+	} else {
+		dynamicsState.totalForce += force;
+	}
 
 	Debug::logVector(getCenterOfMass() + origin, force, Debug::FORCE);
 
@@ -693,50 +748,64 @@ void MotorizedPhysical::applyForce(Vec3Relative origin, Vec3 force) {
 
 void MotorizedPhysical::applyMoment(Vec3 moment) {
 	assert(isVecValid(moment));
-	totalMoment += moment;
+	wakeUp();
+	if(isInDynamicsStore()) {
+		world->dynamicsStore.setMoment(dynamicsIndex, world->dynamicsStore.getMoment(dynamicsIndex) + moment);
+	} else {
+		dynamicsState.totalMoment += moment;
+	}
 	Debug::logVector(getCenterOfMass(), moment, Debug::MOMENT);
 }
 
 void MotorizedPhysical::applyImpulseAtCenterOfMass(Vec3 impulse) {
 	assert(isVecValid(impulse));
+	wakeUp();
 	Debug::logVector(getCenterOfMass(), impulse, Debug::IMPULSE);
-	motionOfCenterOfMass.translation.translation[0] += forceResponse * impulse;
+	setVelocityOfCenterOfMass(getVelocityOfCenterOfMass() + getForceResponse() * impulse);
 }
 void MotorizedPhysical::applyImpulse(Vec3Relative origin, Vec3Relative impulse) {
 	assert(isVecValid(origin));
 	assert(isVecValid(impulse));
+	wakeUp();
 	Debug::logVector(getCenterOfMass() + origin, impulse, Debug::IMPULSE);
-	motionOfCenterOfMass.translation.translation[0] += forceResponse * impulse;
+	setVelocityOfCenterOfMass(getVelocityOfCenterOfMass() + getForceResponse() * impulse);
 	Vec3 angularImpulse = origin % impulse;
 	applyAngularImpulse(angularImpulse);
 }
 void MotorizedPhysical::applyAngularImpulse(Vec3 angularImpulse) {
 	assert(isVecValid(angularImpulse));
+	wakeUp();
 	Debug::logVector(getCenterOfMass(), angularImpulse, Debug::ANGULAR_IMPULSE);
 	Vec3 localAngularImpulse = getCFrame().relativeToLocal(angularImpulse);
-	Vec3 localRotAcc = momentResponse * localAngularImpulse;
+	Vec3 localRotAcc = getMomentResponse() * localAngularImpulse;
 	Vec3 rotAcc = getCFrame().localToRelative(localRotAcc);
-	motionOfCenterOfMass.rotation.rotation[0] += rotAcc;
+	setAngularVelocityOfCenterOfMass(getAngularVelocityOfCenterOfMass() + rotAcc);
 }
 
 void MotorizedPhysical::applyDragAtCenterOfMass(Vec3 drag) {
 	assert(isVecValid(drag));
+	wakeUp();
+	markBoundsOutdated();
 	Debug::logVector(getCenterOfMass(), drag, Debug::POSITION);
-	translate(forceResponse * drag);
+	translate(getForceResponse() * drag);
 }
 void MotorizedPhysical::applyDrag(Vec3Relative origin, Vec3Relative drag) {
 	assert(isVecValid(origin));
 	assert(isVecValid(drag));
+	wakeUp();
+	markBoundsOutdated();
 	Debug::logVector(getCenterOfMass() + origin, drag, Debug::POSITION);
-	translateUnsafeRecursive(forceResponse * drag);
+	translateUnsafeRecursive(getForceResponse() * drag);
 	Vec3 angularDrag = origin % drag;
 	applyAngularDrag(angularDrag);
 }
 void MotorizedPhysical::applyAngularDrag(Vec3 angularDrag) {
 	assert(isVecValid(angularDrag));
+	wakeUp();
+	markBoundsOutdated();
 	Debug::logVector(getCenterOfMass(), angularDrag, Debug::INFO_VEC);
 	Vec3 localAngularDrag = getCFrame().relativeToLocal(angularDrag);
-	Vec3 localRotAcc = momentResponse * localAngularDrag;
+	Vec3 localRotAcc = getMomentResponse() * localAngularDrag;
 	Vec3 rotAcc = getCFrame().localToRelative(localRotAcc);
 	rotateAroundCenterOfMass(Rotation::fromRotationVec(rotAcc));
 }
@@ -783,7 +852,66 @@ Vec3 Physical::localToMain(const Vec3Local& vec) const {
 }*/
 
 Vec3 MotorizedPhysical::getVelocityOfCenterOfMass() const {
-	return this->motionOfCenterOfMass.getVelocity();
+	if(isInDynamicsStore()) return world->dynamicsStore.getVelocity(dynamicsIndex);
+	return dynamicsState.motionOfCenterOfMass.getVelocity();
+}
+Vec3 MotorizedPhysical::getAngularVelocityOfCenterOfMass() const {
+	if(isInDynamicsStore()) return world->dynamicsStore.getAngularVelocity(dynamicsIndex);
+	return dynamicsState.motionOfCenterOfMass.getAngularVelocity();
+}
+void MotorizedPhysical::setVelocityOfCenterOfMass(Vec3 velocity) {
+	if(isInDynamicsStore()) {
+		world->dynamicsStore.setVelocity(dynamicsIndex, velocity);
+	} else {
+		dynamicsState.motionOfCenterOfMass.translation.translation[0] = velocity;
+	}
+}
+void MotorizedPhysical::setAngularVelocityOfCenterOfMass(Vec3 angularVelocity) {
+	if(isInDynamicsStore()) {
+		world->dynamicsStore.setAngularVelocity(dynamicsIndex, angularVelocity);
+	} else {
+		dynamicsState.motionOfCenterOfMass.rotation.rotation[0] = angularVelocity;
+	}
+}
+void MotorizedPhysical::setMotionOfCenterOfMass(const Motion& motion) {
+	if(isInDynamicsStore()) {
+		world->dynamicsStore.setMotion(dynamicsIndex, motion);
+	} else {
+		dynamicsState.motionOfCenterOfMass = motion;
+	}
+}
+
+Vec3 MotorizedPhysical::getTotalForce() const {
+	if(isInDynamicsStore()) return world->dynamicsStore.getForce(dynamicsIndex);
+	return dynamicsState.totalForce;
+}
+Vec3 MotorizedPhysical::getTotalMoment() const {
+	if(isInDynamicsStore()) return world->dynamicsStore.getMoment(dynamicsIndex);
+	return dynamicsState.totalMoment;
+}
+SymmetricMat3 MotorizedPhysical::getForceResponse() const {
+	if(isInDynamicsStore()) return world->dynamicsStore.getForceResponse(dynamicsIndex);
+	return dynamicsState.forceResponse;
+}
+SymmetricMat3 MotorizedPhysical::getMomentResponse() const {
+	if(isInDynamicsStore()) return world->dynamicsStore.getMomentResponse(dynamicsIndex);
+	return dynamicsState.momentResponse;
+}
+void MotorizedPhysical::setMomentResponse(const SymmetricMat3& momentResponse) {
+	if(isInDynamicsStore()) {
+		world->dynamicsStore.setMomentResponse(dynamicsIndex, momentResponse);
+	} else {
+		dynamicsState.momentResponse = momentResponse;
+	}
+}
+void MotorizedPhysical::setResponses(const SymmetricMat3& forceResponse, const SymmetricMat3& momentResponse) {
+	if(isInDynamicsStore()) {
+		world->dynamicsStore.setForceResponse(dynamicsIndex, forceResponse);
+		world->dynamicsStore.setMomentResponse(dynamicsIndex, momentResponse);
+	} else {
+		dynamicsState.forceResponse = forceResponse;
+		dynamicsState.momentResponse = momentResponse;
+	}
 }
 
 /*
@@ -794,18 +922,18 @@ Vec3 MotorizedPhysical::getVelocityOfCenterOfMass() const {
 SymmetricMat3 MotorizedPhysical::getResponseMatrix(const Vec3Local& r) const {
 	Mat3 crossMat = createCrossProductEquivalent(r);
 
-	SymmetricMat3 rotationFactor = multiplyLeftRight(momentResponse , crossMat);
+	SymmetricMat3 rotationFactor = multiplyLeftRight(getMomentResponse(), crossMat);
 
-	return forceResponse + rotationFactor;
+	return getForceResponse() + rotationFactor;
 }
 
 Mat3 MotorizedPhysical::getResponseMatrix(const Vec3Local& actionPoint, const Vec3Local& responsePoint) const {
 	Mat3 actionCross = createCrossProductEquivalent(actionPoint);
 	Mat3 responseCross = createCrossProductEquivalent(responsePoint);
 
-	Mat3 rotationFactor = responseCross * momentResponse * actionCross;
+	Mat3 rotationFactor = responseCross * getMomentResponse() * actionCross;
 
-	return Mat3(forceResponse) - rotationFactor;
+	return Mat3(getForceResponse()) - rotationFactor;
 }
 double MotorizedPhysical::getInertiaOfPointInDirectionLocal(const Vec3Local& localPoint, const Vec3Local& localDirection) const {
 	SymmetricMat3 accMat = getResponseMatrix(localPoint);
@@ -839,7 +967,7 @@ GlobalCFrame MotorizedPhysical::getCenterOfMassCFrame() const {
 }
 
 Vec3 MotorizedPhysical::getTotalImpulse() const {
-	return this->motionOfCenterOfMass.getVelocity() * this->totalMass;
+	return getVelocityOfCenterOfMass() * this->totalMass;
 }
 
 Vec3 MotorizedPhysical::getTotalAngularMomentum() const {
@@ -851,7 +979,7 @@ Vec3 MotorizedPhysical::getTotalAngularMomentum() const {
 	Vec3 localInternalAngularMomentum = cache.getInternalAngularMomentum();
 	Vec3 globalInternalAngularMomentum = selfRot.localToGlobal(localInternalAngularMomentum);
 	
-	Vec3 externalAngularMomentum = totalInertia * this->motionOfCenterOfMass.getAngularVelocity();
+	Vec3 externalAngularMomentum = totalInertia * getAngularVelocityOfCenterOfMass();
 
 	return externalAngularMomentum + globalInternalAngularMomentum;
 }
@@ -870,7 +998,7 @@ Motion MotorizedPhysical::getMotion() const {
 	GlobalCFrame cf = this->getCFrame();
 	TranslationalMotion motionOfCom = localToGlobal(cf.getRotation(), cache.motionOfCenterOfMass);
 
-	return -motionOfCom + motionOfCenterOfMass.getMotionOfPoint(cf.localToRelative(-cache.centerOfMass));
+	return -motionOfCom + getMotionOfCenterOfMass().getMotionOfPoint(cf.localToRelative(-cache.centerOfMass));
 }
 Motion ConnectedPhysical::getMotion() const {
 	// All motion and offset variables here are expressed in the global frame
@@ -890,7 +1018,8 @@ Motion Physical::getMotionOfCenterOfMass() const {
 	return this->getMotion().getMotionOfPoint(this->getCFrame().localToRelative(this->rigidBody.localCenterOfMass));
 }
 Motion MotorizedPhysical::getMotionOfCenterOfMass() const {
-	return this->motionOfCenterOfMass;
+	if(isInDynamicsStore()) return world->dynamicsStore.getMotion(dynamicsIndex);
+	return dynamicsState.motionOfCenterOfMass;
 }
 Motion ConnectedPhysical::getMotionOfCenterOfMass() const {
 	return this->getMotion().getMotionOfPoint(this->getCFrame().localToRelative(this->rigidBody.localCenterOfMass));
@@ -969,7 +1098,7 @@ Motion COMMotionTree::getMotion() const {
 	GlobalCFrame cf = this->motorPhys->getCFrame();
 	TranslationalMotion motionOfCom = localToGlobal(cf.getRotation(), this->motionOfCenterOfMass);
 
-	return -motionOfCom + this->motorPhys->motionOfCenterOfMass.getMotionOfPoint(cf.localToRelative(-this->centerOfMass));
+	return -motionOfCom + this->motorPhys->getMotionOfCenterOfMass().getMotionOfPoint(cf.localToRelative(-this->centerOfMass));
 }
 
 Vec3 COMMotionTree::getInternalAngularMomentum() const {
@@ -1008,12 +1137,12 @@ bool Physical::isValid() const {
 bool MotorizedPhysical::isValid() const {
 	assert(Physical::isValid());
 	
-	assert(isVecValid(totalForce));
-	assert(isVecValid(totalMoment));
+	assert(isVecValid(getTotalForce()));
+	assert(isVecValid(getTotalMoment()));
 	assert(std::isfinite(totalMass));
 	assert(isVecValid(totalCenterOfMass));
-	assert(isMatValid(forceResponse));
-	assert(isMatValid(momentResponse));
+	assert(isMatValid(getForceResponse()));
+	assert(isMatValid(getMomentResponse()));
 
 	return true;
 }
@@ -15,6 +15,7 @@
 #include "rigidBody.h"
 #include "constraints/hardConstraint.h"
 #include "constraints/hardPhysicalConnection.h"
+#include "dynamicsStateStore.h"
 
 typedef Vec3 Vec3Local;
 typedef Vec3 Vec3Relative;
@@ -203,23 +204,57 @@ public:
 	bool isValid() const;
 };
 
+#define NOT_IN_DYNAMICS_STORE (~size_t(0))
+
 class MotorizedPhysical : public Physical {
 	friend class Physical;
 	friend class ConnectedPhysical;
+	friend class WorldPrototype;
+
+	/*
+		Force, moment, responses and motion of this physical while it is not in a world
+		Once it is added to one, the world's DynamicsStateStore owns them and this is out of date until the physical leaves the world again
+	*/
+	DynamicsState dynamicsState;
+	inline bool isInDynamicsStore() const { return dynamicsIndex != NOT_IN_DYNAMICS_STORE; }
+	void setResponses(const SymmetricMat3& forceResponse, const SymmetricMat3& momentResponse);
 public:
 	void refreshPhysicalProperties();
-	Vec3 totalForce = Vec3(0.0, 0.0, 0.0);
-	Vec3 totalMoment = Vec3(0.0, 0.0, 0.0);
 
 	double totalMass;
 	Vec3 totalCenterOfMass;
 
 	WorldPrototype* world = nullptr;
-	
-	SymmetricMat3 forceResponse;
-	SymmetricMat3 momentResponse;
+	// index of this physical in the DynamicsStateStore of its world, NOT_IN_DYNAMICS_STORE while it is in none
+	size_t dynamicsIndex = NOT_IN_DYNAMICS_STORE;
+
+	Vec3 getTotalForce() const;
+	Vec3 getTotalMoment() const;
+	SymmetricMat3 getForceResponse() const;
+	SymmetricMat3 getMomentResponse() const;
+	// replaces the moment response until the next refreshPhysicalProperties, a zero response keeps the physical from rotating
+	void setMomentResponse(const SymmetricMat3& momentResponse);
+	void setMotionOfCenterOfMass(const Motion& motion);
+	void setVelocityOfCenterOfMass(Vec3 velocity);
+	void setAngularVelocityOfCenterOfMass(Vec3 angularVelocity);
 
-	Motion motionOfCenterOfMass;
+	/*
+		A sleeping physical is not integrated, and is not tested for colissions against other sleeping physicals or terrain
+		It is woken by contact with an awake physical, by applying a force, impulse or drag to it, or by setCFrame
+	*/
+	bool isSleeping = false;
+	// number of consecutive ticks this physical has stayed below the world's sleep thresholds
+	size_t ticksAtRest = 0;
+	// where this physical was when it came to rest, used to measure how much it moved since
+	GlobalCFrame restingCFrame;
+
+	/*
+		Set once this physical has been moved during a tick without its world's tree being told
+		The world refits the bounds of all such physicals at once at the end of the tick, 
+		mainPartBoundsInTree holds the bounds the tree still has for the main part until then
+	*/
+	bool hasOutdatedBounds = false;
+	Bounds mainPartBoundsInTree;
 	
 	explicit MotorizedPhysical(Part* mainPart);
 	explicit MotorizedPhysical(RigidBody&& rigidBody);
@@ -238,6 +273,7 @@ public:
 	*/
 	Motion getMotionOfCenterOfMass() const;
 	Vec3 getVelocityOfCenterOfMass() const;
+	Vec3 getAngularVelocityOfCenterOfMass() const;
 
 	Position getCenterOfMass() const;
 	GlobalCFrame getCenterOfMassCFrame() const;
@@ -276,6 +312,21 @@ public:
 	void ensureWorld(WorldPrototype* world);
 
 	void update(double deltaT);
+	/*
+		The rest of update once the forces have been turned into velocity, for when the world does that step for many physicals at once
+		velocityStep is the velocity that step added
+	*/
+	void updatePosition(double deltaT, Vec3 velocityStep);
+	void markBoundsOutdated();
+
+	/*
+		Stops all motion of this physical and takes it out of the simulation until it is woken
+	*/
+	void fallAsleep();
+	/*
+		Puts a sleeping physical back into the simulation, it has to be at rest for sleepSettings.ticksUntilSleep ticks again to fall asleep
+	*/
+	void wakeUp();
 
 	void setCFrame(const GlobalCFrame& newCFrame);
 	
@@ -4,6 +4,7 @@ const char * physicsLabels[]{
 	"GJK Col",
 	"GJK No Col",
 	"EPA",
+	"Primitive Col",
 	"Collision",
 	"Externals",
 	"Col. Handling",
@@ -23,6 +24,11 @@ const char * intersectionLabels[]{
 	"Part Bound Reject"
 };
 
+const char* sleepLabels[]{
+	"Fell asleep",
+	"Woke up"
+};
+
 const char* iterationLabels[]{
 	"0",
 	"1",
@@ -51,3 +57,12 @@ CircularBuffer<int> gjkNoCollideIterStats(1);
 HistoricTally<long long, IterationTime> GJKCollidesIterationStatistics(iterationLabels, 1);
 HistoricTally<long long, IterationTime> GJKNoCollidesIterationStatistics(iterationLabels, 1);
 HistoricTally<long long, IterationTime> EPAIterationStatistics(iterationLabels, 1);
+HistoricTally<long long, SleepTransition> sleepStatistics(sleepLabels, 1);
+
+void mergeWorkerStatistics(size_t workerCount) {
+	intersectionStatistics.mergeWorkerTallies(workerCount);
+	GJKCollidesIterationStatistics.mergeWorkerTallies(workerCount);
+	GJKNoCollidesIterationStatistics.mergeWorkerTallies(workerCount);
+	EPAIterationStatistics.mergeWorkerTallies(workerCount);
+	sleepStatistics.mergeWorkerTallies(workerCount);
+}
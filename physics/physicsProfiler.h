@@ -6,6 +6,7 @@ enum class PhysicsProcess {
 	GJK_COL,
 	GJK_NO_COL,
 	EPA,
+	PRIMITIVE_COL,
 	COLISSION_OTHER,
 	EXTERNALS,
 	COLISSION_HANDLING,
@@ -27,6 +28,12 @@ enum class IntersectionResult {
 	COUNT
 };
 
+enum class SleepTransition {
+	FELL_ASLEEP,
+	WOKE_UP,
+	COUNT
+};
+
 enum class IterationTime {
 	INSTANT_QUIT = 0,
 	ONE_ITER = 1,
@@ -42,3 +49,9 @@ extern CircularBuffer<int> gjkNoCollideIterStats;
 extern HistoricTally<long long, IterationTime> GJKCollidesIterationStatistics;
 extern HistoricTally<long long, IterationTime> GJKNoCollidesIterationStatistics;
 extern HistoricTally<long long, IterationTime> EPAIterationStatistics;
+extern HistoricTally<long long, SleepTransition> sleepStatistics;
+
+/*
+	Adds the statistics gathered by the workers of a parallel section to the global tallies
+*/
+void mergeWorkerStatistics(size_t workerCount);
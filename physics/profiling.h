@@ -6,6 +6,15 @@
 #include "datastructures/buffers.h"
 #include "parallelArray.h"
 
+// maximum number of threads that can add to a HistoricTally at the same time
+#define MAX_TALLY_WORKERS 64
+
+/*
+	Index of the worker this thread is currently running as within a parallel section, -1 outside of parallel sections
+	Tallies made from within a parallel section go to a separate slot for each worker, and are only added to the main tally by mergeWorkerTallies
+*/
+inline thread_local int currentProfilingWorker = -1;
+
 class TimerMeasure {
 	std::chrono::high_resolution_clock::time_point lastClock = std::chrono::high_resolution_clock::now();
 public:
@@ -28,7 +37,12 @@ public:
 
 template<typename Unit, typename Category>
 class HistoricTally {
+	struct alignas(64) WorkerTally {
+		ParallelArray<Unit, static_cast<size_t>(Category::COUNT)> tally;
+	};
+
 	ParallelArray<Unit, static_cast<size_t>(Category::COUNT)> currentTally;
+	WorkerTally workerTallies[MAX_TALLY_WORKERS];
 public:
 	char const * labels[static_cast<size_t>(Category::COUNT)];
 	CircularBuffer<ParallelArray<Unit, static_cast<size_t>(Category::COUNT)>> history;
@@ -38,10 +52,31 @@ public:
 			this->labels[i] = labels[i];
 		}
 		clearCurrentTally();
+		for(WorkerTally& worker : workerTallies) {
+			for(size_t i = 0; i < static_cast<size_t>(Category::COUNT); i++) {
+				worker.tally[i] = Unit(0);
+			}
+		}
 	}
 
 	inline void addToTally(Category category, Unit amount) {
-		currentTally[static_cast<size_t>(category)] += amount;
+		if(currentProfilingWorker < 0) {
+			currentTally[static_cast<size_t>(category)] += amount;
+		} else {
+			workerTallies[currentProfilingWorker].tally[static_cast<size_t>(category)] += amount;
+		}
+	}
+
+	/*
+		Adds the tallies made by the first workerCount workers to the current tally, must not be called during a parallel section
+	*/
+	inline void mergeWorkerTallies(size_t workerCount) {
+		for(size_t w = 0; w < workerCount; w++) {
+			for(size_t i = 0; i < static_cast<size_t>(Category::COUNT); i++) {
+				currentTally[i] += workerTallies[w].tally[i];
+				workerTallies[w].tally[i] = Unit(0);
+			}
+		}
 	}
 
 	inline void clearCurrentTally() {
@@ -71,7 +106,9 @@ public:
 
 	inline BreakdownAverageProfiler(char const * const labels[static_cast<size_t>(ProcessType::COUNT)], size_t capacity) : HistoricTally<std::chrono::nanoseconds, ProcessType>(labels, capacity), tickHistory(capacity) {}
 
+	// marks made from within a parallel section are ignored, the section as a whole is attributed to the process marked before it
 	inline void mark(ProcessType process) {
+		if(currentProfilingWorker >= 0) return;
 		std::chrono::high_resolution_clock::time_point curTime = std::chrono::high_resolution_clock::now();
 		if(currentProcess != static_cast<ProcessType>(-1)) {
 			HistoricTally<std::chrono::nanoseconds, ProcessType>::addToTally(currentProcess, curTime - startTime);
@@ -81,6 +118,7 @@ public:
 	}
 
 	inline void mark(ProcessType process, ProcessType overrideOldProcess) {
+		if(currentProfilingWorker >= 0) return;
 		std::chrono::high_resolution_clock::time_point curTime = std::chrono::high_resolution_clock::now();
 		if (currentProcess != static_cast<ProcessType>(-1)) {
 			HistoricTally<std::chrono::nanoseconds, ProcessType>::addToTally(overrideOldProcess, curTime - startTime);
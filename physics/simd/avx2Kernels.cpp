@@ -0,0 +1,185 @@
+#include "simdKernels.h"
+
+#include <immintrin.h>
+#include <limits>
+
+// vertex arrays are padded to a multiple of 8, so they always hold whole blocks
+static size_t getPaddedCount(size_t vertexCount) {
+	return (vertexCount + 7) & ~static_cast<size_t>(7);
+}
+
+static __m256 dot8(__m256 x, __m256 y, __m256 z, __m256 dx, __m256 dy, __m256 dz) {
+	return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, dx), _mm256_mul_ps(y, dy)), _mm256_mul_ps(z, dz));
+}
+
+static int furthestIndexInDirection(const float* xValues, const float* yValues, const float* zValues, size_t vertexCount, const Vec3f& direction) {
+	__m256 dx = _mm256_set1_ps(direction.x);
+	__m256 dy = _mm256_set1_ps(direction.y);
+	__m256 dz = _mm256_set1_ps(direction.z);
+
+	__m256 bestDot = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+	__m256i bestIndices = _mm256_setzero_si256();
+	__m256i indices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i step = _mm256_set1_epi32(8);
+
+	size_t paddedCount = getPaddedCount(vertexCount);
+	for(size_t i = 0; i < paddedCount; i += 8) {
+		__m256 dot = dot8(_mm256_load_ps(xValues + i), _mm256_load_ps(yValues + i), _mm256_load_ps(zValues + i), dx, dy, dz);
+		// strictly greater, so every lane keeps the lowest index of its best dot
+		__m256 isBetter = _mm256_cmp_ps(dot, bestDot, _CMP_GT_OQ);
+		bestDot = _mm256_blendv_ps(bestDot, dot, isBetter);
+		bestIndices = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIndices), _mm256_castsi256_ps(indices), isBetter));
+		indices = _mm256_add_epi32(indices, step);
+	}
+
+	alignas(32) float dots[8];
+	alignas(32) int dotIndices[8];
+	_mm256_store_ps(dots, bestDot);
+	_mm256_store_si256(reinterpret_cast<__m256i*>(dotIndices), bestIndices);
+	int bestIndex = dotIndices[0];
+	float best = dots[0];
+	for(int lane = 1; lane < 8; lane++) {
+		if(dots[lane] > best || (dots[lane] == best && dotIndices[lane] < bestIndex)) {
+			best = dots[lane];
+			bestIndex = dotIndices[lane];
+		}
+	}
+	return bestIndex;
+}
+
+static float horizontalMin(__m256 v) {
+	__m128 m = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+	m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+	m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(m);
+}
+
+static float horizontalMax(__m256 v) {
+	__m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+	m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+	m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(m);
+}
+
+static BoundingBox getBounds(const float* xValues, const float* yValues, const float* zValues, size_t vertexCount) {
+	__m256 xMin = _mm256_load_ps(xValues), xMax = xMin;
+	__m256 yMin = _mm256_load_ps(yValues), yMax = yMin;
+	__m256 zMin = _mm256_load_ps(zValues), zMax = zMin;
+
+	size_t paddedCount = getPaddedCount(vertexCount);
+	for(size_t i = 8; i < paddedCount; i += 8) {
+		__m256 x = _mm256_load_ps(xValues + i);
+		__m256 y = _mm256_load_ps(yValues + i);
+		__m256 z = _mm256_load_ps(zValues + i);
+		xMin = _mm256_min_ps(xMin, x); xMax = _mm256_max_ps(xMax, x);
+		yMin = _mm256_min_ps(yMin, y); yMax = _mm256_max_ps(yMax, y);
+		zMin = _mm256_min_ps(zMin, z); zMax = _mm256_max_ps(zMax, z);
+	}
+	return BoundingBox{horizontalMin(xMin), horizontalMin(yMin), horizontalMin(zMin), horizontalMax(xMax), horizontalMax(yMax), horizontalMax(zMax)};
+}
+
+static BoundingBox getTransformedBounds(const float* xValues, const float* yValues, const float* zValues, size_t vertexCount, const Mat3f& referenceFrame) {
+	Vec3f xDir = referenceFrame.getRow(0);
+	Vec3f yDir = referenceFrame.getRow(1);
+	Vec3f zDir = referenceFrame.getRow(2);
+	__m256 xDirX = _mm256_set1_ps(xDir.x), xDirY = _mm256_set1_ps(xDir.y), xDirZ = _mm256_set1_ps(xDir.z);
+	__m256 yDirX = _mm256_set1_ps(yDir.x), yDirY = _mm256_set1_ps(yDir.y), yDirZ = _mm256_set1_ps(yDir.z);
+	__m256 zDirX = _mm256_set1_ps(zDir.x), zDirY = _mm256_set1_ps(zDir.y), zDirZ = _mm256_set1_ps(zDir.z);
+
+	__m256 xMin = _mm256_set1_ps(std::numeric_limits<float>::infinity()), yMin = xMin, zMin = xMin;
+	__m256 xMax = _mm256_set1_ps(-std::numeric_limits<float>::infinity()), yMax = xMax, zMax = xMax;
+
+	size_t paddedCount = getPaddedCount(vertexCount);
+	for(size_t i = 0; i < paddedCount; i += 8) {
+		__m256 x = _mm256_load_ps(xValues + i);
+		__m256 y = _mm256_load_ps(yValues + i);
+		__m256 z = _mm256_load_ps(zValues + i);
+		__m256 dotX = dot8(x, y, z, xDirX, xDirY, xDirZ);
+		__m256 dotY = dot8(x, y, z, yDirX, yDirY, yDirZ);
+		__m256 dotZ = dot8(x, y, z, zDirX, zDirY, zDirZ);
+		xMin = _mm256_min_ps(xMin, dotX); xMax = _mm256_max_ps(xMax, dotX);
+		yMin = _mm256_min_ps(yMin, dotY); yMax = _mm256_max_ps(yMax, dotY);
+		zMin = _mm256_min_ps(zMin, dotZ); zMax = _mm256_max_ps(zMax, dotZ);
+	}
+	return BoundingBox{horizontalMin(xMin), horizontalMin(yMin), horizontalMin(zMin), horizontalMax(xMax), horizontalMax(yMax), horizontalMax(zMax)};
+}
+
+int avx2IntersectingChildren(const CompiledBoundsTree::Node& node, const Bounds& bounds) {
+	// a child is separated from bounds if bounds.min > child.max or child.min > bounds.max on any axis
+	__m256i separated = _mm256_or_si256(
+		_mm256_cmpgt_epi64(_mm256_set1_epi64x(bounds.min.x.value), _mm256_load_si256(reinterpret_cast<const __m256i*>(node.maxX))),
+		_mm256_cmpgt_epi64(_mm256_load_si256(reinterpret_cast<const __m256i*>(node.minX)), _mm256_set1_epi64x(bounds.max.x.value))
+	);
+	separated = _mm256_or_si256(separated, _mm256_or_si256(
+		_mm256_cmpgt_epi64(_mm256_set1_epi64x(bounds.min.y.value), _mm256_load_si256(reinterpret_cast<const __m256i*>(node.maxY))),
+		_mm256_cmpgt_epi64(_mm256_load_si256(reinterpret_cast<const __m256i*>(node.minY)), _mm256_set1_epi64x(bounds.max.y.value))
+	));
+	separated = _mm256_or_si256(separated, _mm256_or_si256(
+		_mm256_cmpgt_epi64(_mm256_set1_epi64x(bounds.min.z.value), _mm256_load_si256(reinterpret_cast<const __m256i*>(node.maxZ))),
+		_mm256_cmpgt_epi64(_mm256_load_si256(reinterpret_cast<const __m256i*>(node.minZ)), _mm256_set1_epi64x(bounds.max.z.value))
+	));
+	return ~_mm256_movemask_pd(_mm256_castsi256_pd(separated)) & 0b1111;
+}
+
+// a + b + c, in that order
+static __m256d sum3(__m256d a, __m256d b, __m256d c) {
+	return _mm256_add_pd(_mm256_add_pd(a, b), c);
+}
+
+// row of a 3x3 matrix times (x, y, z), with the matrix elements given per body
+static __m256d dotRow(__m256d m0, __m256d m1, __m256d m2, __m256d x, __m256d y, __m256d z) {
+	return sum3(_mm256_mul_pd(m0, x), _mm256_mul_pd(m1, y), _mm256_mul_pd(m2, z));
+}
+
+void avx2IntegrateVelocities(const DynamicsStateArrays& state, size_t begin, size_t end, double deltaT) {
+	double* const* f = state.force;
+	double* const* m = state.moment;
+	double* const* fr = state.forceResponse;
+	double* const* mr = state.momentResponse;
+	double* const* r = state.rotation;
+	__m256d dt = _mm256_set1_pd(deltaT);
+	__m256d zero = _mm256_setzero_pd();
+
+	size_t i = begin;
+	for(; i + 4 <= end; i += 4) {
+		__m256d fx = _mm256_loadu_pd(f[0] + i), fy = _mm256_loadu_pd(f[1] + i), fz = _mm256_loadu_pd(f[2] + i);
+		__m256d mx = _mm256_loadu_pd(m[0] + i), my = _mm256_loadu_pd(m[1] + i), mz = _mm256_loadu_pd(m[2] + i);
+		__m256d fr00 = _mm256_loadu_pd(fr[0] + i), fr01 = _mm256_loadu_pd(fr[1] + i), fr02 = _mm256_loadu_pd(fr[2] + i);
+		__m256d fr11 = _mm256_loadu_pd(fr[3] + i), fr12 = _mm256_loadu_pd(fr[4] + i), fr22 = _mm256_loadu_pd(fr[5] + i);
+		__m256d mr00 = _mm256_loadu_pd(mr[0] + i), mr01 = _mm256_loadu_pd(mr[1] + i), mr02 = _mm256_loadu_pd(mr[2] + i);
+		__m256d mr11 = _mm256_loadu_pd(mr[3] + i), mr12 = _mm256_loadu_pd(mr[4] + i), mr22 = _mm256_loadu_pd(mr[5] + i);
+		__m256d r00 = _mm256_loadu_pd(r[0] + i), r01 = _mm256_loadu_pd(r[1] + i), r02 = _mm256_loadu_pd(r[2] + i);
+		__m256d r10 = _mm256_loadu_pd(r[3] + i), r11 = _mm256_loadu_pd(r[4] + i), r12 = _mm256_loadu_pd(r[5] + i);
+		__m256d r20 = _mm256_loadu_pd(r[6] + i), r21 = _mm256_loadu_pd(r[7] + i), r22 = _mm256_loadu_pd(r[8] + i);
+
+		__m256d ax = _mm256_mul_pd(dotRow(fr00, fr01, fr02, fx, fy, fz), dt);
+		__m256d ay = _mm256_mul_pd(dotRow(fr01, fr11, fr12, fx, fy, fz), dt);
+		__m256d az = _mm256_mul_pd(dotRow(fr02, fr12, fr22, fx, fy, fz), dt);
+
+		// the moment in local space, through the transposed rotation
+		__m256d lx = dotRow(r00, r10, r20, mx, my, mz);
+		__m256d ly = dotRow(r01, r11, r21, mx, my, mz);
+		__m256d lz = dotRow(r02, r12, r22, mx, my, mz);
+
+		__m256d localX = _mm256_mul_pd(dotRow(mr00, mr01, mr02, lx, ly, lz), dt);
+		__m256d localY = _mm256_mul_pd(dotRow(mr01, mr11, mr12, lx, ly, lz), dt);
+		__m256d localZ = _mm256_mul_pd(dotRow(mr02, mr12, mr22, lx, ly, lz), dt);
+
+		_mm256_storeu_pd(state.velocityStep[0] + i, ax);
+		_mm256_storeu_pd(state.velocityStep[1] + i, ay);
+		_mm256_storeu_pd(state.velocityStep[2] + i, az);
+		_mm256_storeu_pd(state.velocity[0] + i, _mm256_add_pd(_mm256_loadu_pd(state.velocity[0] + i), ax));
+		_mm256_storeu_pd(state.velocity[1] + i, _mm256_add_pd(_mm256_loadu_pd(state.velocity[1] + i), ay));
+		_mm256_storeu_pd(state.velocity[2] + i, _mm256_add_pd(_mm256_loadu_pd(state.velocity[2] + i), az));
+		_mm256_storeu_pd(state.angularVelocity[0] + i, _mm256_add_pd(_mm256_loadu_pd(state.angularVelocity[0] + i), dotRow(r00, r01, r02, localX, localY, localZ)));
+		_mm256_storeu_pd(state.angularVelocity[1] + i, _mm256_add_pd(_mm256_loadu_pd(state.angularVelocity[1] + i), dotRow(r10, r11, r12, localX, localY, localZ)));
+		_mm256_storeu_pd(state.angularVelocity[2] + i, _mm256_add_pd(_mm256_loadu_pd(state.angularVelocity[2] + i), dotRow(r20, r21, r22, localX, localY, localZ)));
+		for(int axis = 0; axis < 3; axis++) {
+			_mm256_storeu_pd(f[axis] + i, zero);
+			_mm256_storeu_pd(m[axis] + i, zero);
+		}
+	}
+	scalarIntegrateVelocities(state, i, end, deltaT);
+}
+
+const SIMDKernels avx2Kernels{"AVX2", furthestIndexInDirection, getBounds, getTransformedBounds, avx2IntersectingChildren, avx2IntegrateVelocities};
@@ -0,0 +1,88 @@
+#include "simdKernels.h"
+
+#include <immintrin.h>
+#include <limits>
+
+// vertex arrays are only padded to a multiple of 8, the last block of 16 may be half full
+static __mmask16 getBlockMask(size_t blockStart, size_t vertexCount) {
+	size_t paddedCount = (vertexCount + 7) & ~static_cast<size_t>(7);
+	return (blockStart + 16 <= paddedCount) ? __mmask16(0xFFFF) : __mmask16(0x00FF);
+}
+
+static __m512 dot16(__m512 x, __m512 y, __m512 z, __m512 dx, __m512 dy, __m512 dz) {
+	return _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(x, dx), _mm512_mul_ps(y, dy)), _mm512_mul_ps(z, dz));
+}
+
+static int furthestIndexInDirection(const float* xValues, const float* yValues, const float* zValues, size_t vertexCount, const Vec3f& direction) {
+	__m512 dx = _mm512_set1_ps(direction.x);
+	__m512 dy = _mm512_set1_ps(direction.y);
+	__m512 dz = _mm512_set1_ps(direction.z);
+
+	__m512 bestDot = _mm512_set1_ps(-std::numeric_limits<float>::infinity());
+	__m512i bestIndices = _mm512_setzero_si512();
+	__m512i indices = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	__m512i step = _mm512_set1_epi32(16);
+
+	for(size_t i = 0; i < vertexCount; i += 16) {
+		__mmask16 valid = getBlockMask(i, vertexCount);
+		__m512 x = _mm512_maskz_loadu_ps(valid, xValues + i);
+		__m512 y = _mm512_maskz_loadu_ps(valid, yValues + i);
+		__m512 z = _mm512_maskz_loadu_ps(valid, zValues + i);
+		__m512 dot = dot16(x, y, z, dx, dy, dz);
+		// strictly greater, so every lane keeps the lowest index of its best dot
+		__mmask16 isBetter = _mm512_mask_cmp_ps_mask(valid, dot, bestDot, _CMP_GT_OQ);
+		bestDot = _mm512_mask_mov_ps(bestDot, isBetter, dot);
+		bestIndices = _mm512_mask_mov_epi32(bestIndices, isBetter, indices);
+		indices = _mm512_add_epi32(indices, step);
+	}
+
+	float best = _mm512_reduce_max_ps(bestDot);
+	__mmask16 isBest = _mm512_cmp_ps_mask(bestDot, _mm512_set1_ps(best), _CMP_EQ_OQ);
+	if(isBest == 0) return 0;
+	return _mm512_mask_reduce_min_epi32(isBest, bestIndices);
+}
+
+static BoundingBox getBounds(const float* xValues, const float* yValues, const float* zValues, size_t vertexCount) {
+	__m512 xMin = _mm512_set1_ps(std::numeric_limits<float>::infinity()), yMin = xMin, zMin = xMin;
+	__m512 xMax = _mm512_set1_ps(-std::numeric_limits<float>::infinity()), yMax = xMax, zMax = xMax;
+
+	for(size_t i = 0; i < vertexCount; i += 16) {
+		__mmask16 valid = getBlockMask(i, vertexCount);
+		__m512 x = _mm512_maskz_loadu_ps(valid, xValues + i);
+		__m512 y = _mm512_maskz_loadu_ps(valid, yValues + i);
+		__m512 z = _mm512_maskz_loadu_ps(valid, zValues + i);
+		xMin = _mm512_mask_min_ps(xMin, valid, xMin, x); xMax = _mm512_mask_max_ps(xMax, valid, xMax, x);
+		yMin = _mm512_mask_min_ps(yMin, valid, yMin, y); yMax = _mm512_mask_max_ps(yMax, valid, yMax, y);
+		zMin = _mm512_mask_min_ps(zMin, valid, zMin, z); zMax = _mm512_mask_max_ps(zMax, valid, zMax, z);
+	}
+	return BoundingBox{_mm512_reduce_min_ps(xMin), _mm512_reduce_min_ps(yMin), _mm512_reduce_min_ps(zMin), _mm512_reduce_max_ps(xMax), _mm512_reduce_max_ps(yMax), _mm512_reduce_max_ps(zMax)};
+}
+
+static BoundingBox getTransformedBounds(const float* xValues, const float* yValues, const float* zValues, size_t vertexCount, const Mat3f& referenceFrame) {
+	Vec3f xDir = referenceFrame.getRow(0);
+	Vec3f yDir = referenceFrame.getRow(1);
+	Vec3f zDir = referenceFrame.getRow(2);
+	__m512 xDirX = _mm512_set1_ps(xDir.x), xDirY = _mm512_set1_ps(xDir.y), xDirZ = _mm512_set1_ps(xDir.z);
+	__m512 yDirX = _mm512_set1_ps(yDir.x), yDirY = _mm512_set1_ps(yDir.y), yDirZ = _mm512_set1_ps(yDir.z);
+	__m512 zDirX = _mm512_set1_ps(zDir.x), zDirY = _mm512_set1_ps(zDir.y), zDirZ = _mm512_set1_ps(zDir.z);
+
+	__m512 xMin = _mm512_set1_ps(std::numeric_limits<float>::infinity()), yMin = xMin, zMin = xMin;
+	__m512 xMax = _mm512_set1_ps(-std::numeric_limits<float>::infinity()), yMax = xMax, zMax = xMax;
+
+	for(size_t i = 0; i < vertexCount; i += 16) {
+		__mmask16 valid = getBlockMask(i, vertexCount);
+		__m512 x = _mm512_maskz_loadu_ps(valid, xValues + i);
+		__m512 y = _mm512_maskz_loadu_ps(valid, yValues + i);
+		__m512 z = _mm512_maskz_loadu_ps(valid, zValues + i);
+		__m512 dotX = dot16(x, y, z, xDirX, xDirY, xDirZ);
+		__m512 dotY = dot16(x, y, z, yDirX, yDirY, yDirZ);
+		__m512 dotZ = dot16(x, y, z, zDirX, zDirY, zDirZ);
+		xMin = _mm512_mask_min_ps(xMin, valid, xMin, dotX); xMax = _mm512_mask_max_ps(xMax, valid, xMax, dotX);
+		yMin = _mm512_mask_min_ps(yMin, valid, yMin, dotY); yMax = _mm512_mask_max_ps(yMax, valid, yMax, dotY);
+		zMin = _mm512_mask_min_ps(zMin, valid, zMin, dotZ); zMax = _mm512_mask_max_ps(zMax, valid, zMax, dotZ);
+	}
+	return BoundingBox{_mm512_reduce_min_ps(xMin), _mm512_reduce_min_ps(yMin), _mm512_reduce_min_ps(zMin), _mm512_reduce_max_ps(xMax), _mm512_reduce_max_ps(yMax), _mm512_reduce_max_ps(zMax)};
+}
+
+// a node only has 4 children, which already fit in one AVX2 register
+const SIMDKernels avx512Kernels{"AVX-512", furthestIndexInDirection, getBounds, getTransformedBounds, avx2IntersectingChildren, avx2IntegrateVelocities};
@@ -0,0 +1,106 @@
+#include "simdKernels.h"
+
+#include <limits>
+
+/*
+	The reference for all other variants, the dot products are summed in the same order as in the vectorized kernels
+*/
+
+static int furthestIndexInDirection(const float* xValues, const float* yValues, const float* zValues, size_t vertexCount, const Vec3f& direction) {
+	float bestDot = -std::numeric_limits<float>::infinity();
+	int bestIndex = 0;
+	for(size_t i = 0; i < vertexCount; i++) {
+		float dot = xValues[i] * direction.x + yValues[i] * direction.y + zValues[i] * direction.z;
+		if(dot > bestDot) {
+			bestDot = dot;
+			bestIndex = static_cast<int>(i);
+		}
+	}
+	return bestIndex;
+}
+
+static BoundingBox getBounds(const float* xValues, const float* yValues, const float* zValues, size_t vertexCount) {
+	float xmin = xValues[0], xmax = xValues[0];
+	float ymin = yValues[0], ymax = yValues[0];
+	float zmin = zValues[0], zmax = zValues[0];
+	for(size_t i = 1; i < vertexCount; i++) {
+		if(xValues[i] < xmin) xmin = xValues[i];
+		if(xValues[i] > xmax) xmax = xValues[i];
+		if(yValues[i] < ymin) ymin = yValues[i];
+		if(yValues[i] > ymax) ymax = yValues[i];
+		if(zValues[i] < zmin) zmin = zValues[i];
+		if(zValues[i] > zmax) zmax = zValues[i];
+	}
+	return BoundingBox{xmin, ymin, zmin, xmax, ymax, zmax};
+}
+
+static BoundingBox getTransformedBounds(const float* xValues, const float* yValues, const float* zValues, size_t vertexCount, const Mat3f& referenceFrame) {
+	Vec3f xDir = referenceFrame.getRow(0);
+	Vec3f yDir = referenceFrame.getRow(1);
+	Vec3f zDir = referenceFrame.getRow(2);
+
+	float mins[3]{std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity()};
+	float maxs[3]{-std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity()};
+	for(size_t i = 0; i < vertexCount; i++) {
+		float dots[3]{
+			xValues[i] * xDir.x + yValues[i] * xDir.y + zValues[i] * xDir.z,
+			xValues[i] * yDir.x + yValues[i] * yDir.y + zValues[i] * yDir.z,
+			xValues[i] * zDir.x + yValues[i] * zDir.y + zValues[i] * zDir.z
+		};
+		for(int axis = 0; axis < 3; axis++) {
+			if(dots[axis] < mins[axis]) mins[axis] = dots[axis];
+			if(dots[axis] > maxs[axis]) maxs[axis] = dots[axis];
+		}
+	}
+	return BoundingBox{mins[0], mins[1], mins[2], maxs[0], maxs[1], maxs[2]};
+}
+
+int scalarIntersectingChildren(const CompiledBoundsTree::Node& node, const Bounds& bounds) {
+	int result = 0;
+	for(int i = 0; i < 4; i++) {
+		bool separated =
+			bounds.min.x.value > node.maxX[i] || node.minX[i] > bounds.max.x.value ||
+			bounds.min.y.value > node.maxY[i] || node.minY[i] > bounds.max.y.value ||
+			bounds.min.z.value > node.maxZ[i] || node.minZ[i] > bounds.max.z.value;
+		if(!separated) result |= 1 << i;
+	}
+	return result;
+}
+
+void scalarIntegrateVelocities(const DynamicsStateArrays& state, size_t begin, size_t end, double deltaT) {
+	double* const* f = state.force;
+	double* const* m = state.moment;
+	double* const* fr = state.forceResponse;
+	double* const* mr = state.momentResponse;
+	double* const* r = state.rotation;
+	for(size_t i = begin; i < end; i++) {
+		double ax = (fr[0][i] * f[0][i] + fr[1][i] * f[1][i] + fr[2][i] * f[2][i]) * deltaT;
+		double ay = (fr[1][i] * f[0][i] + fr[3][i] * f[1][i] + fr[4][i] * f[2][i]) * deltaT;
+		double az = (fr[2][i] * f[0][i] + fr[4][i] * f[1][i] + fr[5][i] * f[2][i]) * deltaT;
+
+		// the moment in local space, through the transposed rotation
+		double lx = r[0][i] * m[0][i] + r[3][i] * m[1][i] + r[6][i] * m[2][i];
+		double ly = r[1][i] * m[0][i] + r[4][i] * m[1][i] + r[7][i] * m[2][i];
+		double lz = r[2][i] * m[0][i] + r[5][i] * m[1][i] + r[8][i] * m[2][i];
+
+		double localX = (mr[0][i] * lx + mr[1][i] * ly + mr[2][i] * lz) * deltaT;
+		double localY = (mr[1][i] * lx + mr[3][i] * ly + mr[4][i] * lz) * deltaT;
+		double localZ = (mr[2][i] * lx + mr[4][i] * ly + mr[5][i] * lz) * deltaT;
+
+		state.velocityStep[0][i] = ax;
+		state.velocityStep[1][i] = ay;
+		state.velocityStep[2][i] = az;
+		state.velocity[0][i] += ax;
+		state.velocity[1][i] += ay;
+		state.velocity[2][i] += az;
+		state.angularVelocity[0][i] += r[0][i] * localX + r[1][i] * localY + r[2][i] * localZ;
+		state.angularVelocity[1][i] += r[3][i] * localX + r[4][i] * localY + r[5][i] * localZ;
+		state.angularVelocity[2][i] += r[6][i] * localX + r[7][i] * localY + r[8][i] * localZ;
+		for(int axis = 0; axis < 3; axis++) {
+			f[axis][i] = 0.0;
+			m[axis][i] = 0.0;
+		}
+	}
+}
+
+const SIMDKernels scalarKernels{"scalar", furthestIndexInDirection, getBounds, getTransformedBounds, scalarIntersectingChildren, scalarIntegrateVelocities};
@@ -0,0 +1,72 @@
+#include "simdKernels.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+static bool cpuSupports(SIMDInstructionSet instructionSet) {
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	bool sse41 = (info[2] & (1 << 19)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if(instructionSet == SIMDInstructionSet::SSE4_1) return sse41;
+	if(!osxsave || !avx || maxLeaf < 7) return false;
+
+	// the operating system must save the ymm, and for AVX-512 the zmm and mask registers
+	unsigned long long enabledStates = _xgetbv(0);
+	__cpuidex(info, 7, 0);
+	if(instructionSet == SIMDInstructionSet::AVX2) {
+		return (enabledStates & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0;
+	}
+	if(instructionSet == SIMDInstructionSet::AVX512) {
+		return (enabledStates & 0xE6) == 0xE6 && (info[1] & (1 << 16)) != 0;
+	}
+	return false;
+}
+#else
+static bool cpuSupports(SIMDInstructionSet instructionSet) {
+	// these also check that the operating system saves the wider registers
+	__builtin_cpu_init();
+	switch(instructionSet) {
+	case SIMDInstructionSet::SSE4_1: return __builtin_cpu_supports("sse4.1");
+	case SIMDInstructionSet::AVX2: return __builtin_cpu_supports("avx2");
+	case SIMDInstructionSet::AVX512: return __builtin_cpu_supports("avx512f");
+	default: return false;
+	}
+}
+#endif
+
+bool isInstructionSetSupported(SIMDInstructionSet instructionSet) {
+	if(instructionSet == SIMDInstructionSet::SCALAR) return true;
+	return cpuSupports(instructionSet);
+}
+
+const SIMDKernels* getSIMDKernelsFor(SIMDInstructionSet instructionSet) {
+	if(!isInstructionSetSupported(instructionSet)) return nullptr;
+	switch(instructionSet) {
+	case SIMDInstructionSet::SCALAR: return &scalarKernels;
+	case SIMDInstructionSet::SSE4_1: return &sse41Kernels;
+	case SIMDInstructionSet::AVX2: return &avx2Kernels;
+	case SIMDInstructionSet::AVX512: return &avx512Kernels;
+	default: return nullptr;
+	}
+}
+
+static const SIMDKernels& selectBestKernels() {
+	for(int i = static_cast<int>(SIMDInstructionSet::COUNT) - 1; i > 0; i--) {
+		const SIMDKernels* kernels = getSIMDKernelsFor(static_cast<SIMDInstructionSet>(i));
+		if(kernels != nullptr) return *kernels;
+	}
+	return scalarKernels;
+}
+
+const SIMDKernels& getSIMDKernels() {
+	static const SIMDKernels& bestKernels = selectBestKernels();
+	return bestKernels;
+}
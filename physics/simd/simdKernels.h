@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+
+#include "../math/linalg/vec.h"
+#include "../math/linalg/mat.h"
+#include "../geometry/boundingBox.h"
+#include "../datastructures/compiledBoundsTree.h"
+
+enum class SIMDInstructionSet {
+	SCALAR,
+	SSE4_1,
+	AVX2,
+	AVX512,
+	COUNT
+};
+
+/*
+	Structure of arrays with the dynamics state of many bodies, every pointer points to one component of all bodies, see DynamicsStateStore
+	Rotation matrices are stored row by row, symmetric matrices as their upper triangle: 00, 01, 02, 11, 12, 22
+	velocityStep receives the velocity that integrateVelocities added
+*/
+struct DynamicsStateArrays {
+	double* force[3];
+	double* moment[3];
+	double* forceResponse[6];
+	double* momentResponse[6];
+	double* rotation[9];
+	double* velocity[3];
+	double* angularVelocity[3];
+	double* velocityStep[3];
+};
+
+/*
+	The vectorized inner loops of the engine, one table per instruction set
+	Every variant gives exactly the same results as the scalar one, they only differ in speed
+
+	Vertex arrays are laid out like the vertices of a TriangleMesh: separate x, y and z arrays, aligned to 32 bytes,
+	padded to a multiple of 8 with copies of the last vertex
+*/
+struct SIMDKernels {
+	const char* name;
+
+	// index of the first vertex with the greatest dot product with direction
+	int(*furthestIndexInDirection)(const float* xValues, const float* yValues, const float* zValues, size_t vertexCount, const Vec3f& direction);
+	BoundingBox(*getBounds)(const float* xValues, const float* yValues, const float* zValues, size_t vertexCount);
+	// bounds of all vertices transformed by referenceFrame
+	BoundingBox(*getTransformedBounds)(const float* xValues, const float* yValues, const float* zValues, size_t vertexCount, const Mat3f& referenceFrame);
+	// see CompiledBoundsTree::intersectingChildren
+	int(*intersectingChildren)(const CompiledBoundsTree::Node& node, const Bounds& bounds);
+	/*
+		The velocity step of MotorizedPhysical::update for the bodies in [begin, end), with the same rounding:
+		velocityStep = forceResponse * force * deltaT, velocity += velocityStep,
+		angularVelocity += rotation * (momentResponse * (~rotation * moment) * deltaT), and force and moment are reset to 0
+	*/
+	void(*integrateVelocities)(const DynamicsStateArrays& state, size_t begin, size_t end, double deltaT);
+};
+
+extern const SIMDKernels scalarKernels;
+extern const SIMDKernels sse41Kernels;
+extern const SIMDKernels avx2Kernels;
+extern const SIMDKernels avx512Kernels;
+
+// shared by the variants that have no faster version of their own
+int scalarIntersectingChildren(const CompiledBoundsTree::Node& node, const Bounds& bounds);
+int avx2IntersectingChildren(const CompiledBoundsTree::Node& node, const Bounds& bounds);
+void scalarIntegrateVelocities(const DynamicsStateArrays& state, size_t begin, size_t end, double deltaT);
+void avx2IntegrateVelocities(const DynamicsStateArrays& state, size_t begin, size_t end, double deltaT);
+
+/*
+	Returns true if this CPU, and the operating system, support the given instruction set
+*/
+bool isInstructionSetSupported(SIMDInstructionSet instructionSet);
+
+/*
+	The kernels for the given instruction set, nullptr if it is not supported here
+*/
+const SIMDKernels* getSIMDKernelsFor(SIMDInstructionSet instructionSet);
+
+/*
+	The kernels of the best instruction set supported here, chosen on first use
+*/
+const SIMDKernels& getSIMDKernels();
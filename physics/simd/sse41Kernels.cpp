@@ -0,0 +1,107 @@
+#include "simdKernels.h"
+
+#include <smmintrin.h>
+#include <limits>
+
+// vertex arrays are padded to a multiple of 8, so they always hold whole blocks of 4
+static size_t getPaddedCount(size_t vertexCount) {
+	return (vertexCount + 7) & ~static_cast<size_t>(7);
+}
+
+static __m128 dot4(__m128 x, __m128 y, __m128 z, __m128 dx, __m128 dy, __m128 dz) {
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, dx), _mm_mul_ps(y, dy)), _mm_mul_ps(z, dz));
+}
+
+static int furthestIndexInDirection(const float* xValues, const float* yValues, const float* zValues, size_t vertexCount, const Vec3f& direction) {
+	__m128 dx = _mm_set1_ps(direction.x);
+	__m128 dy = _mm_set1_ps(direction.y);
+	__m128 dz = _mm_set1_ps(direction.z);
+
+	__m128 bestDot = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+	__m128i bestIndices = _mm_setzero_si128();
+	__m128i indices = _mm_setr_epi32(0, 1, 2, 3);
+	__m128i step = _mm_set1_epi32(4);
+
+	size_t paddedCount = getPaddedCount(vertexCount);
+	for(size_t i = 0; i < paddedCount; i += 4) {
+		__m128 dot = dot4(_mm_load_ps(xValues + i), _mm_load_ps(yValues + i), _mm_load_ps(zValues + i), dx, dy, dz);
+		// strictly greater, so every lane keeps the lowest index of its best dot
+		__m128 isBetter = _mm_cmpgt_ps(dot, bestDot);
+		bestDot = _mm_blendv_ps(bestDot, dot, isBetter);
+		bestIndices = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(bestIndices), _mm_castsi128_ps(indices), isBetter));
+		indices = _mm_add_epi32(indices, step);
+	}
+
+	alignas(16) float dots[4];
+	alignas(16) int dotIndices[4];
+	_mm_store_ps(dots, bestDot);
+	_mm_store_si128(reinterpret_cast<__m128i*>(dotIndices), bestIndices);
+	int bestIndex = dotIndices[0];
+	float best = dots[0];
+	for(int lane = 1; lane < 4; lane++) {
+		if(dots[lane] > best || (dots[lane] == best && dotIndices[lane] < bestIndex)) {
+			best = dots[lane];
+			bestIndex = dotIndices[lane];
+		}
+	}
+	// the padding repeats the last vertex, whose index comes first
+	return bestIndex;
+}
+
+static float horizontalMin(__m128 v) {
+	v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+	v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(v);
+}
+
+static float horizontalMax(__m128 v) {
+	v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+	v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtss_f32(v);
+}
+
+static BoundingBox getBounds(const float* xValues, const float* yValues, const float* zValues, size_t vertexCount) {
+	__m128 xMin = _mm_load_ps(xValues), xMax = xMin;
+	__m128 yMin = _mm_load_ps(yValues), yMax = yMin;
+	__m128 zMin = _mm_load_ps(zValues), zMax = zMin;
+
+	size_t paddedCount = getPaddedCount(vertexCount);
+	for(size_t i = 4; i < paddedCount; i += 4) {
+		__m128 x = _mm_load_ps(xValues + i);
+		__m128 y = _mm_load_ps(yValues + i);
+		__m128 z = _mm_load_ps(zValues + i);
+		xMin = _mm_min_ps(xMin, x); xMax = _mm_max_ps(xMax, x);
+		yMin = _mm_min_ps(yMin, y); yMax = _mm_max_ps(yMax, y);
+		zMin = _mm_min_ps(zMin, z); zMax = _mm_max_ps(zMax, z);
+	}
+	return BoundingBox{horizontalMin(xMin), horizontalMin(yMin), horizontalMin(zMin), horizontalMax(xMax), horizontalMax(yMax), horizontalMax(zMax)};
+}
+
+static BoundingBox getTransformedBounds(const float* xValues, const float* yValues, const float* zValues, size_t vertexCount, const Mat3f& referenceFrame) {
+	Vec3f xDir = referenceFrame.getRow(0);
+	Vec3f yDir = referenceFrame.getRow(1);
+	Vec3f zDir = referenceFrame.getRow(2);
+	__m128 xDirX = _mm_set1_ps(xDir.x), xDirY = _mm_set1_ps(xDir.y), xDirZ = _mm_set1_ps(xDir.z);
+	__m128 yDirX = _mm_set1_ps(yDir.x), yDirY = _mm_set1_ps(yDir.y), yDirZ = _mm_set1_ps(yDir.z);
+	__m128 zDirX = _mm_set1_ps(zDir.x), zDirY = _mm_set1_ps(zDir.y), zDirZ = _mm_set1_ps(zDir.z);
+
+	__m128 xMin = _mm_set1_ps(std::numeric_limits<float>::infinity()), yMin = xMin, zMin = xMin;
+	__m128 xMax = _mm_set1_ps(-std::numeric_limits<float>::infinity()), yMax = xMax, zMax = xMax;
+
+	size_t paddedCount = getPaddedCount(vertexCount);
+	for(size_t i = 0; i < paddedCount; i += 4) {
+		__m128 x = _mm_load_ps(xValues + i);
+		__m128 y = _mm_load_ps(yValues + i);
+		__m128 z = _mm_load_ps(zValues + i);
+		__m128 dotX = dot4(x, y, z, xDirX, xDirY, xDirZ);
+		__m128 dotY = dot4(x, y, z, yDirX, yDirY, yDirZ);
+		__m128 dotZ = dot4(x, y, z, zDirX, zDirY, zDirZ);
+		xMin = _mm_min_ps(xMin, dotX); xMax = _mm_max_ps(xMax, dotX);
+		yMin = _mm_min_ps(yMin, dotY); yMax = _mm_max_ps(yMax, dotY);
+		zMin = _mm_min_ps(zMin, dotZ); zMax = _mm_max_ps(zMax, dotZ);
+	}
+	return BoundingBox{horizontalMin(xMin), horizontalMin(yMin), horizontalMin(zMin), horizontalMax(xMax), horizontalMax(yMax), horizontalMax(zMax)};
+}
+
+// comparing 64 bit integers needs SSE4.2, so the children are tested one by one
+const SIMDKernels sse41Kernels{"SSE4.1", furthestIndexInDirection, getBounds, getTransformedBounds, scalarIntersectingChildren, scalarIntegrateVelocities};
@@ -54,11 +54,14 @@ public:
 	void syncModification(const std::function<void()>& function) {
 		std::lock_guard<std::shared_mutex> lg(lock);
 		function();
+		// compiling under the exclusive lock keeps the shared sections from ever having to
+		this->compileTrees();
 	}
 	void asyncModification(const std::function<void()>& function) {
 		if (lock.try_lock()) {
 			UnlockOnDestroy lg(lock);
 			function();
+			this->compileTrees();
 		} else {
 			pushOperation(function);
 		}
@@ -79,23 +82,18 @@ public:
 	virtual void tick() override {
 		SharedLockGuard mutLock(lock);
 		
-		this->findColissions();
-		
-		physicsMeasure.mark(PhysicsProcess::EXTERNALS);
-		this->applyExternalForces();
-
-		this->handleColissions();
-
-		intersectionStatistics.nextTally();
-
-		this->handleConstraints();
-
-		physicsMeasure.mark(PhysicsProcess::WAIT_FOR_LOCK);
-		mutLock.upgrade();
+		// readers may look at the physicals until they start moving
+		this->simulateSubsteps([&mutLock]() {
+			physicsMeasure.mark(PhysicsProcess::WAIT_FOR_LOCK);
+			mutLock.upgrade();
+		});
 		this->update();
 
+		sleepStatistics.nextTally();
+
 		physicsMeasure.mark(PhysicsProcess::QUEUE);
 		processQueue();
+		this->compileTrees();
 		
 		physicsMeasure.mark(PhysicsProcess::WAIT_FOR_LOCK);
 		mutLock.downgrade();
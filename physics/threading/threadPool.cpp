@@ -0,0 +1,148 @@
+#include "threadPool.h"
+
+#include "../profiling.h"
+
+#include <algorithm>
+
+static inline uint64_t packRange(uint32_t begin, uint32_t end) {
+	return (static_cast<uint64_t>(begin) << 32) | end;
+}
+static inline uint32_t rangeBegin(uint64_t range) {
+	return static_cast<uint32_t>(range >> 32);
+}
+static inline uint32_t rangeEnd(uint64_t range) {
+	return static_cast<uint32_t>(range);
+}
+
+ThreadPool::ThreadPool(size_t threadCount) {
+	startThreads(threadCount);
+}
+
+ThreadPool::~ThreadPool() {
+	stopThreads();
+}
+
+void ThreadPool::startThreads(size_t newThreadCount) {
+	this->threadCount = std::clamp<size_t>(newThreadCount, 1, MAX_TALLY_WORKERS);
+	this->ranges = std::unique_ptr<TaskRange[]>(new TaskRange[this->threadCount]);
+	for(size_t i = 0; i < this->threadCount; i++) {
+		this->ranges[i].range.store(0);
+	}
+	this->stopping = false;
+	for(size_t i = 1; i < this->threadCount; i++) {
+		threads.emplace_back(&ThreadPool::workerMain, this, i, currentGeneration);
+	}
+}
+
+void ThreadPool::stopThreads() {
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		stopping = true;
+	}
+	jobAvailable.notify_all();
+	for(std::thread& t : threads) {
+		t.join();
+	}
+	threads.clear();
+}
+
+void ThreadPool::setThreadCount(size_t newThreadCount) {
+	if(std::clamp<size_t>(newThreadCount, 1, MAX_TALLY_WORKERS) == threadCount) return;
+	stopThreads();
+	startThreads(newThreadCount);
+}
+
+void ThreadPool::workerMain(size_t workerIndex, size_t seenGeneration) {
+	while(true) {
+		const std::function<void(size_t, size_t)>* job;
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			jobAvailable.wait(lock, [&]() {return stopping || currentGeneration != seenGeneration; });
+			if(stopping) return;
+			seenGeneration = currentGeneration;
+			job = currentJob;
+		}
+
+		runWorker(workerIndex, *job);
+
+		{
+			std::lock_guard<std::mutex> lock(jobMutex);
+			workersRunning--;
+			if(workersRunning == 0) {
+				jobFinished.notify_one();
+			}
+		}
+	}
+}
+
+void ThreadPool::runWorker(size_t workerIndex, const std::function<void(size_t, size_t)>& job) {
+	int previousWorker = currentProfilingWorker;
+	currentProfilingWorker = static_cast<int>(workerIndex);
+	size_t taskIndex;
+	while(claimTask(workerIndex, taskIndex)) {
+		job(taskIndex, workerIndex);
+	}
+	currentProfilingWorker = previousWorker;
+}
+
+bool ThreadPool::claimTask(size_t workerIndex, size_t& taskIndex) {
+	// take from the front of our own range
+	std::atomic<uint64_t>& ownRange = ranges[workerIndex].range;
+	uint64_t current = ownRange.load();
+	while(rangeBegin(current) < rangeEnd(current)) {
+		if(ownRange.compare_exchange_weak(current, packRange(rangeBegin(current) + 1, rangeEnd(current)))) {
+			taskIndex = rangeBegin(current);
+			return true;
+		}
+	}
+
+	// steal the back half of someone else's range
+	for(size_t offset = 1; offset < threadCount; offset++) {
+		std::atomic<uint64_t>& victimRange = ranges[(workerIndex + offset) % threadCount].range;
+		uint64_t victim = victimRange.load();
+		while(rangeBegin(victim) < rangeEnd(victim)) {
+			uint32_t begin = rangeBegin(victim);
+			uint32_t end = rangeEnd(victim);
+			uint32_t middle = begin + (end - begin) / 2;
+			if(victimRange.compare_exchange_weak(victim, packRange(begin, middle))) {
+				taskIndex = middle;
+				ownRange.store(packRange(middle + 1, end));
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void ThreadPool::parallelFor(size_t taskCount, const std::function<void(size_t taskIndex, size_t workerIndex)>& task) {
+	if(taskCount == 0) return;
+
+	if(threadCount == 1 || taskCount == 1) {
+		int previousWorker = currentProfilingWorker;
+		currentProfilingWorker = 0;
+		for(size_t i = 0; i < taskCount; i++) {
+			task(i, 0);
+		}
+		currentProfilingWorker = previousWorker;
+		return;
+	}
+
+	for(size_t i = 0; i < threadCount; i++) {
+		ranges[i].range.store(packRange(static_cast<uint32_t>(taskCount * i / threadCount), static_cast<uint32_t>(taskCount * (i + 1) / threadCount)));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		currentJob = &task;
+		currentGeneration++;
+		workersRunning = threadCount - 1;
+	}
+	jobAvailable.notify_all();
+
+	runWorker(0, task);
+
+	// every worker checks in for every job, so none of them can still be touching task once this returns
+	std::unique_lock<std::mutex> lock(jobMutex);
+	jobFinished.wait(lock, [&]() {return workersRunning == 0; });
+	currentJob = nullptr;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/*
+	A fixed set of worker threads that run batches of numbered tasks
+
+	The thread calling parallelFor takes part as worker 0, so a pool with a threadCount of 1 spawns no threads and simply runs everything inline.
+	Each worker starts out with a contiguous range of the tasks, once it runs out it steals the back half of another worker's range.
+	This keeps neighbouring tasks together on one thread while still balancing out uneven tasks.
+*/
+class ThreadPool {
+	struct alignas(64) TaskRange {
+		// begin in the upper 32 bits, end in the lower 32 bits
+		std::atomic<uint64_t> range;
+	};
+
+	std::vector<std::thread> threads;
+	std::unique_ptr<TaskRange[]> ranges;
+	size_t threadCount = 1;
+
+	std::mutex jobMutex;
+	std::condition_variable jobAvailable;
+	std::condition_variable jobFinished;
+	const std::function<void(size_t, size_t)>* currentJob = nullptr;
+	size_t currentGeneration = 0;
+	size_t workersRunning = 0;
+	bool stopping = false;
+
+	void startThreads(size_t threadCount);
+	void stopThreads();
+	void workerMain(size_t workerIndex, size_t seenGeneration);
+	void runWorker(size_t workerIndex, const std::function<void(size_t, size_t)>& job);
+	bool claimTask(size_t workerIndex, size_t& taskIndex);
+
+public:
+	explicit ThreadPool(size_t threadCount = 1);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	ThreadPool(ThreadPool&&) = delete;
+	ThreadPool& operator=(ThreadPool&&) = delete;
+
+	/*
+		Total number of threads working on a parallelFor, including the calling thread
+	*/
+	inline size_t getThreadCount() const { return threadCount; }
+
+	/*
+		Joins the current workers and starts up the new amount, must not be called during a parallelFor
+	*/
+	void setThreadCount(size_t newThreadCount);
+
+	/*
+		Runs task(taskIndex, workerIndex) for every taskIndex in [0, taskCount), returns once all tasks are done
+		workerIndex is in [0, getThreadCount()) and unique among the threads running at the same time,
+		it can be used to index into per thread buffers
+	*/
+	void parallelFor(size_t taskCount, const std::function<void(size_t taskIndex, size_t workerIndex)>& task);
+};
@@ -24,6 +24,12 @@ bool WorldPrototype::isValid() const {
 			return false;
 		}
 
+		if(phys->dynamicsIndex >= physicals.size() || physicals[phys->dynamicsIndex] != phys) {
+			Log::error("physical's dynamicsIndex is not correct!");
+			DEBUGBREAK;
+			return false;
+		}
+
 		if(!isMotorizedPhysicalValid(phys)) {
 			Log::error("Physical invalid!");
 			DEBUGBREAK;
@@ -50,10 +56,15 @@ WorldPrototype::WorldPrototype(double deltaT) :
 	colissionMatrix.get(0, 0) = true; // free-free
 	colissionMatrix.get(1, 0) = true; // free-terrain
 	colissionMatrix.get(1, 1) = false; // terrain-terrain
+	objectTree.trackLeafChanges = true; // for pairCache
 }
 
 WorldPrototype::~WorldPrototype() {
-
+	// physicals that outlive their world take their dynamics state with them
+	for(MotorizedPhysical* phys : physicals) {
+		phys->dynamicsState = dynamicsStore.get(phys->dynamicsIndex);
+		phys->dynamicsIndex = NOT_IN_DYNAMICS_STORE;
+	}
 }
 
 static TreeNode createNodeFor(MotorizedPhysical* phys) {
@@ -74,8 +85,7 @@ void WorldPrototype::addPart(Part* part, int layerIndex) {
 	}
 
 	part->ensureHasParent();
-	physicals.push_back(part->parent->mainPhysical);
-	part->parent->mainPhysical->world = this;
+	addPhysical(part->parent->mainPhysical);
 
 	WorldLayer* worldLayer = &layers[layerIndex];
 	BoundsTree<Part>& objTree = worldLayer->getObjectTree();
@@ -127,6 +137,7 @@ void WorldPrototype::clear() {
 		delete phys;
 	}
 	this->physicals.clear();
+	this->dynamicsStore.clear();
 	std::vector<Part*> partsToDelete;
 	for(Part& p : this->iterParts(ALL_PARTS)) {
 		p.parent = nullptr;
@@ -144,20 +155,55 @@ void WorldPrototype::clear() {
 }
 
 void WorldPrototype::notifyMainPhysicalObsolete(MotorizedPhysical* motorPhys) {
-	physicals.erase(std::remove(physicals.begin(), physicals.end(), motorPhys));
+	removePhysical(motorPhys);
 
 	ASSERT_VALID;
 }
 void WorldPrototype::optimizeTerrain() {
-	for(int i = 0; i < 5; i++) {
-		terrainTree.improveStructure();
+	for(WorldLayer& layer : layers) {
+		layer.getTerrainTree().rebuild(&threadPool);
 	}
 	ASSERT_VALID;
 }
+void WorldPrototype::optimizeObjectTrees() {
+	for(WorldLayer& layer : layers) {
+		layer.getObjectTree().rebuild(&threadPool);
+	}
+	ASSERT_VALID;
+}
+
+void WorldPrototype::compileTrees() {
+	objectTree.compile();
+	terrainTree.compile();
+}
+
+void WorldPrototype::setThreadCount(size_t threadCount) {
+	threadPool.setThreadCount(threadCount);
+}
 
 void WorldPrototype::notifyNewPhysicalCreatedWhenSplitting(MotorizedPhysical* newPhysical) {
-	physicals.push_back(newPhysical);
-	newPhysical->world = this;
+	addPhysical(newPhysical);
+}
+
+void WorldPrototype::addPhysical(MotorizedPhysical* physical) {
+	assert(!physical->isInDynamicsStore());
+	physical->world = this;
+	physical->dynamicsIndex = dynamicsStore.add(physical->dynamicsState);
+	physicals.push_back(physical);
+}
+
+void WorldPrototype::removePhysical(MotorizedPhysical* physical) {
+	size_t index = physical->dynamicsIndex;
+	if(index >= physicals.size() || physicals[index] != physical) {
+		throw std::logic_error("No physical found to remove!");
+	}
+	physical->dynamicsState = dynamicsStore.remove(index);
+	physical->dynamicsIndex = NOT_IN_DYNAMICS_STORE;
+	if(index != physicals.size() - 1) {
+		physicals[index] = physicals.back();
+		physicals[index]->dynamicsIndex = index;
+	}
+	physicals.pop_back();
 }
 
 void WorldPrototype::notifyPhysicalHasBeenSplit(const MotorizedPhysical* mainPhysical, MotorizedPhysical* newlySplitPhysical) {
@@ -196,18 +242,6 @@ void WorldPrototype::notifyPhysicalHasBeenSplit(const MotorizedPhysical* mainPhy
 	ASSERT_TREE_VALID(objectTree);
 }
 
-static void removePhysicalFromList(std::vector<MotorizedPhysical*>& physicals, MotorizedPhysical* physToRemove) {
-	for(MotorizedPhysical*& item : physicals) {
-		if(item == physToRemove) {
-			item = std::move(physicals.back());
-			physicals.pop_back();
-
-			return;
-		}
-	}
-	throw std::logic_error("No physical found to remove!");
-}
-
 void WorldPrototype::mergePhysicalGroups(const MotorizedPhysical* firstPhysical, MotorizedPhysical* secondPhysical) {
 	assert(firstPhysical->world == this);
 
@@ -215,7 +249,7 @@ void WorldPrototype::mergePhysicalGroups(const MotorizedPhysical* firstPhysical,
 
 	if(secondPhysical->world != nullptr) {
 		assert(secondPhysical->world == this);
-		removePhysicalFromList(this->physicals, secondPhysical);
+		removePhysical(secondPhysical);
 
 		newNode = objectTree.grabGroupFor(secondPhysical->getMainPart(), secondPhysical->getMainPart()->getBounds());
 	} else {
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <vector>
+#include <unordered_map>
+#include <functional>
 
 #include "part.h"
 #include "physical.h"
@@ -8,7 +10,10 @@
 #include "datastructures/iterators.h"
 #include "datastructures/iteratorEnd.h"
 #include "datastructures/boundsTree.h"
+#include "overlappingPairCache.h"
+#include "contactSolver.h"
 #include "math/linalg/largeMatrix.h"
+#include "threading/threadPool.h"
 
 #define FREE_PARTS 0x1
 #define TERRAIN_PARTS 0x2
@@ -19,6 +24,61 @@ struct Colission {
 	Part* p2;
 	Position intersection;
 	Vec3 exitVector;
+	// points into the OverlappingPairCache, valid until the next broad phase
+	ColissionPairData* pairData;
+};
+
+/*
+	Colissions split into levels such that colissions of the same level share no physicals, see handleColissions
+*/
+struct ColissionResponseLevels {
+	// level of every colission, the object colissions followed by the terrain colissions
+	std::vector<size_t> levels;
+	// indices of the colissions sorted by level, colissions of the same level keep their order
+	std::vector<size_t> order;
+	// where each level starts in order, followed by order.size()
+	std::vector<size_t> levelBegins;
+	// one more than the level of the latest colission of each physical
+	std::unordered_map<const MotorizedPhysical*, size_t> nextLevelOfPhysical;
+};
+
+
+/*
+	A physical falls asleep once it has moved less than maxMovement and rotated less than maxRotation (in radians) over ticksUntilSleep consecutive ticks,
+	while its kinetic energy per unit of mass stayed below maxKineticEnergyPerMass
+	ticksUntilSleep == 0 disables sleeping
+*/
+struct SleepSettings {
+	size_t ticksUntilSleep = 0;
+	double maxMovement = 0.02;
+	double maxRotation = 0.1;
+	double maxKineticEnergyPerMass = 0.02;
+};
+
+/*
+	With a margin the leaf bounds of moving parts are enlarged by margin in all directions, 
+	and by the distance they would travel in predictedTicks ticks at their current velocity. 
+	The object trees only have to be updated once a part leaves its enlarged bounds, at the cost of a few more colission candidates. 
+	margin == 0 keeps the leaf bounds exact
+*/
+struct BoundsMarginSettings {
+	double margin = 0.0;
+	double predictedTicks = 2.0;
+};
+
+/*
+	Colissions are detected once per tick, after which the colission response, the constraints and the movement of the physicals
+	run substepCount times with deltaT / substepCount.
+	The adaptive mode picks the number of substeps anew every tick, between substepCount and maxSubsteps,
+	such that no point of a physical moves further than maxMovementPerSubstep per substep
+	and the deepest colission is no deeper than maxPenetrationPerSubstep times the number of substeps
+*/
+struct SubstepSettings {
+	size_t substepCount = 1;
+	bool adaptive = false;
+	size_t maxSubsteps = 8;
+	double maxMovementPerSubstep = 0.1;
+	double maxPenetrationPerSubstep = 0.05;
 };
 
 class ExternalForce;
@@ -40,9 +100,17 @@ private:
 	friend class ConnectedPhysical;
 	friend class Part;
 
+	std::vector<ColissionCandidate> currentObjectCandidates;
+	std::vector<ColissionCandidate> currentTerrainCandidates;
 	std::vector<Colission> currentObjectColissions;
 	std::vector<Colission> currentTerrainColissions;
 
+	/*
+		The force, moment, responses and motion of all physicals, physicals[i] keeps its state at index i
+		MotorizedPhysical reads and writes its state here for as long as it is in this world
+	*/
+	DynamicsStateStore dynamicsStore;
+
 	/*
 		This method is called by World or Physical when new MotorizedPhysicals are created which need to be added to the list
 	*/
@@ -83,19 +151,74 @@ private:
 private: // actually private fields and methods, not to be used by any friends
 	void mergePhysicalGroups(const MotorizedPhysical* first, MotorizedPhysical* second);
 
+	// adds the physical to physicals, its dynamics state moves into dynamicsStore
+	void addPhysical(MotorizedPhysical* physical);
+	// removes the physical from physicals, the last physical takes its place and the physical gets its dynamics state back
+	void removePhysical(MotorizedPhysical* physical);
+
 	std::vector<WorldLayer> layers;
 	/*
 		Signifies which layers collide
 	*/
 	LargeSymmetricMatrix<bool> colissionMatrix;
 
+	ThreadPool threadPool;
+	/*
+		Output of each worker during the parallel broad and narrow phase, kept around between ticks to avoid reallocating
+	*/
+	std::vector<std::vector<ColissionCandidate>> workerCandidates;
+	std::vector<std::vector<Colission>> workerColissions;
+
+	// buffers of the parallel colission response in handleColissions, kept around between ticks to avoid reallocating
+	ColissionResponseLevels colissionResponseLevels;
+
+	/*
+		The overlapping pairs as of the last broad phase, the broad phase only looks at the leaves that changed since
+	*/
+	OverlappingPairCache pairCache;
+
+	// used by handleColissions if contactSolverSettings.type is SEQUENTIAL_IMPULSE
+	ContactSolver contactSolver;
+
+	/*
+		Broad phase, brings pairCache up to date and fills currentObjectCandidates and currentTerrainCandidates with its pairs that have at least one awake part
+	*/
+	void findColissionCandidates();
+
+	/*
+		Moves all awake physicals by one substep, physicals don't affect one another while doing so
+		The physicals are split into consecutive chunks of about the same number of parts, which are updated in parallel if there are several threads.
+		The velocity step of each run of consecutive awake physicals is one SIMD kernel over dynamicsStore, with exactly the same result as MotorizedPhysical::update
+	*/
+	void updatePhysicals();
+	// deltaT divided by the number of substeps of the current tick
+	double substepDeltaT = 0.0;
+	size_t lastSubstepCount = 1;
+	size_t findSubstepCount() const;
+	// where each chunk of updatePhysicals starts in physicals, followed by the end of the last chunk
+	std::vector<size_t> updateChunkBoundaries;
+
+	/*
+		Puts the physicals that have been at rest for long enough to sleep, physicals that touch each other only fall asleep together
+	*/
+	void updateSleepingPhysicals();
+
 protected:
 	// World tick steps
 	virtual void applyExternalForces();
 	virtual void findColissions();
+	// wakes the sleeping physicals that are in contact with an awake one, and adds the colissions of the woken ones that the narrow phase skipped while they slept
+	void wakeUpTouchedPhysicals();
 	virtual void handleColissions();
 	virtual void handleConstraints();
+	// brings the trees up to date with the moved physicals and puts resting ones to sleep, once per tick after all substeps
 	virtual void update();
+	/*
+		The part of a tick before update: finds the colissions, then runs the substeps, each responding to the colissions, applying the constraints and moving the physicals
+		beforeMoving is called once, right before the physicals first move. SynchronizedWorld takes its exclusive lock there,
+		it must hold it for the rest of the tick, as every substep works on the colissions found at the start of the tick
+	*/
+	void simulateSubsteps(const std::function<void()>& beforeMoving = std::function<void()>());
 
 
 	// event handlers
@@ -114,6 +237,20 @@ public:
 	size_t objectCount = 0;
 	double deltaT;
 
+	SleepSettings sleepSettings;
+	BoundsMarginSettings boundsMarginSettings;
+	/*
+		Picks between the penalty method and the sequential impulse solver for the response to colissions
+		The sequential impulse solver stays stable at larger deltaT, especially for stacked parts
+	*/
+	ContactSolverSettings contactSolverSettings;
+	SubstepSettings substepSettings;
+	/*
+		Maximum number of object tree nodes whose structure is improved per tick, each tick continues where the previous one stopped
+		0 improves the entire tree every tick
+	*/
+	size_t structureImprovementBudget = 0;
+
 
 	WorldPrototype(double deltaT);
 	~WorldPrototype();
@@ -130,7 +267,21 @@ public:
 	void removePart(Part* part);
 
 	void addTerrainPart(Part* part, int layerIndex = 0);
+	/*
+		Rebuilds the terrain trees from scratch, meant to be called once after adding all terrain
+	*/
 	void optimizeTerrain();
+	/*
+		Rebuilds the object trees from scratch, for after adding many parts at once such as when loading a world
+	*/
+	void optimizeObjectTrees();
+
+	/*
+		Sets the number of threads used for the world tick, including the thread calling tick()
+		The results of a tick do not depend on the thread count, 1 runs everything on the calling thread
+	*/
+	void setThreadCount(size_t threadCount);
+	inline size_t getThreadCount() const { return threadPool.getThreadCount(); }
 
 	// removes everything from this world, parts, physicals, forces, constraints
 	void clear();
@@ -190,6 +341,33 @@ public:
 		return IteratorFactoryWithEnd<ConstDoubleFilterIter<Filter>>(std::move(doubleFilter));
 	}
 
+	/*
+		Calls func(Part& part) for every part whose bounds intersect the given bounds
+	*/
+	template<typename Func>
+	void forEachPartInBounds(const Bounds& bounds, const Func& func, int partsMask = ALL_PARTS) {
+		if(partsMask & FREE_PARTS) objectTree.forEachInBounds(bounds, func);
+		if(partsMask & TERRAIN_PARTS) terrainTree.forEachInBounds(bounds, func);
+	}
+	/*
+		Calls func(Part& part) for every part whose bounds are hit by the given ray
+	*/
+	template<typename Func>
+	void forEachPartOnRay(const Ray& ray, const Func& func, int partsMask = ALL_PARTS) {
+		if(partsMask & FREE_PARTS) objectTree.forEachOnRay(ray, func);
+		if(partsMask & TERRAIN_PARTS) terrainTree.forEachOnRay(ray, func);
+	}
+
+	/*
+		Brings the compiled copies of the object and terrain tree up to date, which the broad phase and the forEachPart functions run on
+		The tick does this by itself, it only has to be called to make sure queries in between ticks don't fall back to the slower trees
+	*/
+	void compileTrees();
+
+	inline const OverlappingPairCache& getPairCache() const { return pairCache; }
+	// number of substeps the last tick was split into
+	inline size_t getLastSubstepCount() const { return lastSubstepCount; }
+
 	IteratorFactoryWithEnd<WorldPartIter> iterParts(int partsMask = ALL_PARTS);
 	IteratorFactoryWithEnd<ConstWorldPartIter> iterParts(int partsMask = ALL_PARTS) const;
 };
@@ -237,6 +415,15 @@ public:
 		);
 	}
 
+	template<typename Func>
+	void forEachPartInBounds(const Bounds& bounds, const Func& func, int partsMask = ALL_PARTS) {
+		WorldPrototype::forEachPartInBounds(bounds, [&func](Part& part) {func(static_cast<T&>(part)); }, partsMask);
+	}
+	template<typename Func>
+	void forEachPartOnRay(const Ray& ray, const Func& func, int partsMask = ALL_PARTS) {
+		WorldPrototype::forEachPartOnRay(ray, [&func](Part& part) {func(static_cast<T&>(part)); }, partsMask);
+	}
+
 	IteratorFactoryWithEnd<CastingIterator<WorldPartIter, T&>> iterParts(int partsMask = ALL_PARTS) {
 		return IteratorFactoryWithEnd<CastingIterator<WorldPartIter, T&>>(
 			CastingIterator<WorldPartIter, T&>(
@@ -9,9 +9,11 @@
 #include "debug.h"
 #include "constants.h"
 #include "physicsProfiler.h"
+#include "simd/simdKernels.h"
 #include "../util/log.h"
 
 #include <vector>
+#include <unordered_set>
 #include <cmath>
 #include <algorithm>
 
@@ -182,12 +184,80 @@ bool boundsSphereEarlyEnd(const DiagonalMat3& scale, const Vec3& sphereCenter, d
 	return std::abs(sphereCenter.x) > scale[0] + sphereRadius || std::abs(sphereCenter.y) > scale[1] + sphereRadius || std::abs(sphereCenter.z) > scale[2] + sphereRadius;
 }
 
-inline void runColissionTests(Part& p1, Part& p2, WorldPrototype& world, std::vector<Colission>& colissions) {
+/*
+	===== Broad phase =====
+
+	Collects all pairs of parts whose bounds overlap, no part geometry is looked at here
+	The full search below is only needed when the pair cache can't be updated from the changed leaves alone
+*/
+
+// terrain parts have no parent and never move
+static inline bool isAwake(const Part* part) {
+	return part->parent != nullptr && !part->parent->mainPhysical->isSleeping;
+}
+
+/*
+	Both work on the compiled trees, where the bounds of all children of a node are tested against some other bounds at once
+	recursiveFindCandidatesBetween expects the bounds of first and second to intersect
+*/
+using CompiledChild = CompiledBoundsTree::Child;
+
+static void recursiveFindCandidatesInternal(std::vector<ColissionCandidate>& candidates, const CompiledBoundsTree& tree, const CompiledChild& trunk);
+static void recursiveFindCandidatesBetween(std::vector<ColissionCandidate>& candidates, const CompiledBoundsTree& firstTree, const CompiledChild& first, const CompiledBoundsTree& secondTree, const CompiledChild& second);
+
+static void recursiveFindCandidatesInternal(std::vector<ColissionCandidate>& candidates, const CompiledBoundsTree& tree, const CompiledChild& trunk) {
+	// within the same node
+	if (trunk.isLeafNode() || trunk.isGroupHead)
+		return;
+
+	const CompiledBoundsTree::Node& trunkNode = tree.getNode(trunk);
+	for (int i = 0; i < trunkNode.childCount; i++) {
+		CompiledChild A = tree.getChild(trunkNode, i);
+		recursiveFindCandidatesInternal(candidates, tree, A);
+		int laterChildren = ~((2 << i) - 1);
+		for (int mask = CompiledBoundsTree::intersectingChildren(trunkNode, A.bounds) & laterChildren; mask != 0; mask &= mask - 1) {
+			recursiveFindCandidatesBetween(candidates, tree, A, tree, tree.getChild(trunkNode, lowestChildInMask(mask)));
+		}
+	}
+}
+
+static void recursiveFindCandidatesBetween(std::vector<ColissionCandidate>& candidates, const CompiledBoundsTree& firstTree, const CompiledChild& first, const CompiledBoundsTree& secondTree, const CompiledChild& second) {
+	if (first.isLeafNode() && second.isLeafNode()) {
+		Part* p1 = static_cast<Part*>(firstTree.getObject(first));
+		Part* p2 = static_cast<Part*>(secondTree.getObject(second));
+		candidates.push_back(ColissionCandidate{p1, p2, nullptr});
+	} else {
+		bool preferFirst = first.cost <= second.cost;
+		if (preferFirst && !first.isLeafNode() || second.isLeafNode()) {
+			// split first
+			const CompiledBoundsTree::Node& node = firstTree.getNode(first);
+			for (int mask = CompiledBoundsTree::intersectingChildren(node, second.bounds); mask != 0; mask &= mask - 1) {
+				recursiveFindCandidatesBetween(candidates, firstTree, firstTree.getChild(node, lowestChildInMask(mask)), secondTree, second);
+			}
+		} else {
+			// split second
+			const CompiledBoundsTree::Node& node = secondTree.getNode(second);
+			for (int mask = CompiledBoundsTree::intersectingChildren(node, first.bounds); mask != 0; mask &= mask - 1) {
+				recursiveFindCandidatesBetween(candidates, firstTree, first, secondTree, secondTree.getChild(node, lowestChildInMask(mask)));
+			}
+		}
+	}
+}
+
+/*
+	===== Narrow phase =====
+
+	Runs the actual intersection tests on the candidates found by the broad phase
+*/
+
+inline void runColissionTests(Part& p1, Part& p2, ColissionPairData& pairData, std::vector<Colission>& colissions) {
 	double maxRadiusBetween = p1.maxRadius + p2.maxRadius;
 
 	Vec3 deltaPosition = p1.getPosition() - p2.getPosition();
 	double distanceSqBetween = lengthSquared(deltaPosition);
 
+	size_t ticksInContact = pairData.ticksInContact;
+	pairData.ticksInContact = 0;
 	if (distanceSqBetween > maxRadiusBetween * maxRadiusBetween) {
 		intersectionStatistics.addToTally(IntersectionResult::PART_DISTANCE_REJECT, 1);
 		return;
@@ -201,96 +271,250 @@ inline void runColissionTests(Part& p1, Part& p2, WorldPrototype& world, std::ve
 		return;
 	}
 
-	PartIntersection result = p1.intersects(p2);
+	PartIntersection result = p1.intersects(p2, &pairData.gjkWarmStart);
 	if (result.intersects) {
 		intersectionStatistics.addToTally(IntersectionResult::COLISSION, 1);
 
-		colissions.push_back(Colission{ &p1, &p2, result.intersection, result.exitVector });
+		colissions.push_back(Colission{ &p1, &p2, result.intersection, result.exitVector, &pairData });
+		pairData.ticksInContact = ticksInContact + 1;
+		pairData.lastExitVector = result.exitVector;
 	} else {
 		intersectionStatistics.addToTally(IntersectionResult::GJK_REJECT, 1);
 	}
 	physicsMeasure.mark(PhysicsProcess::COLISSION_OTHER);
 }
 
-void recursiveFindColissionsInternal(WorldPrototype& world, std::vector<Colission>& colissions, TreeNode& trunkNode);
-void recursiveFindColissionsBetween(WorldPrototype& world, std::vector<Colission>& colissions, TreeNode& first, TreeNode& second);
+inline void runColissionTests(const ColissionCandidate& candidate, std::vector<Colission>& colissions) {
+#ifdef CATCH_INTERSECTION_ERRORS
+	try {
+		runColissionTests(*candidate.p1, *candidate.p2, *candidate.pairData, colissions);
+	} catch(const std::exception& err) {
+		Log::fatal("Error occurred during intersection: %s", err.what());
 
-void recursiveFindColissionsInternal(WorldPrototype& world, std::vector<Colission>& colissions, TreeNode& trunkNode) {
-	// within the same node
-	if (trunkNode.isLeafNode() || trunkNode.isGroupHead)
-		return;
+		Debug::saveIntersectionError(candidate.p1, candidate.p2, "colError");
 
-	for (int i = 0; i < trunkNode.nodeCount; i++) {
-		TreeNode& A = trunkNode[i];
-		recursiveFindColissionsInternal(world, colissions, A);
-		for (int j = i + 1; j < trunkNode.nodeCount; j++) {
-			TreeNode& B = trunkNode[j];
-			recursiveFindColissionsBetween(world, colissions, A, B);
-		}
+		throw err;
+	} catch(...) {
+		Log::fatal("Unknown error occured during intersection");
+
+		Debug::saveIntersectionError(candidate.p1, candidate.p2, "colError");
+
+		throw "exit";
 	}
+#else
+	runColissionTests(*candidate.p1, *candidate.p2, *candidate.pairData, colissions);
+#endif
 }
 
-void recursiveFindColissionsBetween(WorldPrototype& world, std::vector<Colission>& colissions, TreeNode& first, TreeNode& second) {
-	if (!intersects(first.bounds, second.bounds)) return;
-	
-	if (first.isLeafNode() && second.isLeafNode()) {
-		Part* firstObj = static_cast<Part*>(first.object);
-		Part* secondObj = static_cast<Part*>(second.object);
-#ifdef CATCH_INTERSECTION_ERRORS
-		try {
-			runColissionTests(*firstObj, *secondObj, world, colissions);
-		} catch(const std::exception& err) {
-			Log::fatal("Error occurred during intersection: %s", err.what());
+/*
+	===== Parallel colission detection =====
+
+	Tasks append their output to the buffer of the worker that runs them and remember which slice of it they wrote,
+	the slices are then concatenated in task order. As long as the tasks are listed in the order the serial code would run them, 
+	the result is identical to that of the serial code, no matter how the tasks were spread over the workers.
+*/
 
-			Debug::saveIntersectionError(firstObj, secondObj, "colError");
+struct TaskOutputSlice {
+	size_t workerIndex;
+	size_t begin;
+	size_t end;
+};
 
-			throw err;
-		} catch(...) {
-			Log::fatal("Unknown error occured during intersection");
+/*
+	Runs task(taskIndex, output) for all tasks in parallel, then calls collect(taskIndex, begin, end) for every task in order
+*/
+template<typename T, typename Task, typename Collect>
+static void parallelForInOrder(ThreadPool& threadPool, size_t taskCount, std::vector<std::vector<T>>& workerOutputs, const Task& task, const Collect& collect) {
+	workerOutputs.resize(threadPool.getThreadCount());
+	for(std::vector<T>& output : workerOutputs) {
+		output.clear();
+	}
+	std::vector<TaskOutputSlice> slices(taskCount);
+
+	threadPool.parallelFor(taskCount, [&](size_t taskIndex, size_t workerIndex) {
+		std::vector<T>& output = workerOutputs[workerIndex];
+		size_t begin = output.size();
+		task(taskIndex, output);
+		slices[taskIndex] = TaskOutputSlice{workerIndex, begin, output.size()};
+	});
+
+	for(size_t i = 0; i < taskCount; i++) {
+		const std::vector<T>& output = workerOutputs[slices[i].workerIndex];
+		collect(i, output.begin() + slices[i].begin, output.begin() + slices[i].end);
+	}
+}
 
-			Debug::saveIntersectionError(firstObj, secondObj, "colError");
+struct BroadPhaseTask {
+	CompiledChild first;
+	CompiledChild second;
+	// if false, the task is to find the candidates within first
+	bool hasSecond;
+	// second is in the terrain tree
+	bool isTerrain;
+};
+
+// several tasks per thread give the work stealing some room to even out unbalanced subtrees
+#define BROAD_PHASE_TASKS_PER_THREAD 16
+// number of candidates handed to a worker at once
+#define NARROW_PHASE_CHUNK_SIZE 32
+// number of parts whose physicals are updated by a worker at once
+#define UPDATE_CHUNK_PART_COUNT 64
+
+static bool isSplittable(const BroadPhaseTask& task) {
+	return !task.hasSecond || !(task.first.isLeafNode() && task.second.isLeafNode());
+}
 
-			throw "exit";
+/*
+	Appends the tasks that recursiveFindCandidatesInternal or recursiveFindCandidatesBetween would recurse into for the given task
+*/
+static void splitTask(const CompiledBoundsTree& objectTree, const CompiledBoundsTree& terrainTree, const BroadPhaseTask& task, std::vector<BroadPhaseTask>& output) {
+	if(!task.hasSecond) {
+		const CompiledChild& trunk = task.first;
+		if(trunk.isLeafNode() || trunk.isGroupHead)
+			return;
+
+		const CompiledBoundsTree::Node& trunkNode = objectTree.getNode(trunk);
+		for(int i = 0; i < trunkNode.childCount; i++) {
+			CompiledChild A = objectTree.getChild(trunkNode, i);
+			output.push_back(BroadPhaseTask{A, CompiledChild(), false, task.isTerrain});
+			int laterChildren = ~((2 << i) - 1);
+			for(int mask = CompiledBoundsTree::intersectingChildren(trunkNode, A.bounds) & laterChildren; mask != 0; mask &= mask - 1) {
+				output.push_back(BroadPhaseTask{A, objectTree.getChild(trunkNode, lowestChildInMask(mask)), true, task.isTerrain});
+			}
 		}
-#else
-		runColissionTests(*firstObj, *secondObj, world, colissions);
-#endif
 	} else {
-		bool preferFirst = computeCost(first.bounds) <= computeCost(second.bounds);
-		if (preferFirst && !first.isLeafNode() || second.isLeafNode()) {
-			// split first
-
-			for (TreeNode& node : first) {
-				recursiveFindColissionsBetween(world, colissions, node, second);
+		const CompiledBoundsTree& secondTree = task.isTerrain ? terrainTree : objectTree;
+		const CompiledChild& first = task.first;
+		const CompiledChild& second = task.second;
+
+		bool preferFirst = first.cost <= second.cost;
+		if(preferFirst && !first.isLeafNode() || second.isLeafNode()) {
+			const CompiledBoundsTree::Node& node = objectTree.getNode(first);
+			for(int mask = CompiledBoundsTree::intersectingChildren(node, second.bounds); mask != 0; mask &= mask - 1) {
+				output.push_back(BroadPhaseTask{objectTree.getChild(node, lowestChildInMask(mask)), second, true, task.isTerrain});
 			}
 		} else {
-			// split second
-
-			for (TreeNode& node : second) {
-				recursiveFindColissionsBetween(world, colissions, first, node);
+			const CompiledBoundsTree::Node& node = secondTree.getNode(second);
+			for(int mask = CompiledBoundsTree::intersectingChildren(node, first.bounds); mask != 0; mask &= mask - 1) {
+				output.push_back(BroadPhaseTask{first, secondTree.getChild(node, lowestChildInMask(mask)), true, task.isTerrain});
 			}
 		}
 	}
 }
 
+/*
+	===== Parallel colission response =====
+
+	Handling a colission only changes the two physicals involved, and how it changes them depends on the colissions handled on them before.
+	So every colission is put one level above the latest earlier colission that shares a physical with it. Colissions of the same level share no physicals
+	and are handled in parallel, while handling the levels one after the other keeps the colissions of each physical in the order of the serial code.
+	The result is exactly that of the serial code, for any number of threads.
+*/
+
+// number of colissions of a level handed to a worker at once, levels with fewer colissions than that are handled on the calling thread
+#define COLISSION_RESPONSE_CHUNK_SIZE 32
+
+static void findColissionResponseLevels(const std::vector<Colission>& objectColissions, const std::vector<Colission>& terrainColissions, ColissionResponseLevels& result) {
+	size_t objectColissionCount = objectColissions.size();
+	size_t colissionCount = objectColissionCount + terrainColissions.size();
+
+	result.nextLevelOfPhysical.clear();
+	result.levels.resize(colissionCount);
+	size_t levelCount = 0;
+	for(size_t i = 0; i < colissionCount; i++) {
+		bool isTerrain = i >= objectColissionCount;
+		const Colission& c = isTerrain ? terrainColissions[i - objectColissionCount] : objectColissions[i];
+
+		// terrain doesn't move, so it never orders colissions
+		size_t& nextLevel1 = result.nextLevelOfPhysical[c.p1->parent->mainPhysical];
+		size_t* nextLevel2 = isTerrain ? nullptr : &result.nextLevelOfPhysical[c.p2->parent->mainPhysical];
+		size_t level = nextLevel2 ? std::max(nextLevel1, *nextLevel2) : nextLevel1;
+		nextLevel1 = level + 1;
+		if(nextLevel2) *nextLevel2 = level + 1;
+
+		result.levels[i] = level;
+		levelCount = std::max(levelCount, level + 1);
+	}
+
+	// counting sort by level
+	result.levelBegins.assign(levelCount + 1, 0);
+	for(size_t level : result.levels) {
+		result.levelBegins[level + 1]++;
+	}
+	for(size_t level = 0; level < levelCount; level++) {
+		result.levelBegins[level + 1] += result.levelBegins[level];
+	}
+	result.order.resize(colissionCount);
+	std::vector<size_t> nextInLevel(result.levelBegins.begin(), result.levelBegins.end() - 1);
+	for(size_t i = 0; i < colissionCount; i++) {
+		result.order[nextInLevel[result.levels[i]]++] = i;
+	}
+}
+
 /*
 	===== World Tick =====
 */
 
 void WorldPrototype::tick() {
 	
+	simulateSubsteps();
+
+	update();
+
+	sleepStatistics.nextTally();
+}
+
+void WorldPrototype::simulateSubsteps(const std::function<void()>& beforeMoving) {
 	findColissions();
+	wakeUpTouchedPhysicals();
+	if(contactSolverSettings.type == ContactSolverType::SEQUENTIAL_IMPULSE) {
+		contactSolver.updateManifolds(currentObjectColissions, currentTerrainColissions, contactSolverSettings);
+	}
 
-	physicsMeasure.mark(PhysicsProcess::EXTERNALS);
-	applyExternalForces();
+	size_t substepCount = findSubstepCount();
+	lastSubstepCount = substepCount;
+	substepDeltaT = deltaT / substepCount;
+	for(size_t substep = 0; substep < substepCount; substep++) {
+		physicsMeasure.mark(PhysicsProcess::EXTERNALS);
+		applyExternalForces();
 
-	handleColissions();
+		handleColissions();
+
+		handleConstraints();
+
+		if(substep == 0 && beforeMoving) {
+			beforeMoving();
+		}
+		physicsMeasure.mark(PhysicsProcess::UPDATING);
+		updatePhysicals();
+	}
 
 	intersectionStatistics.nextTally();
-	
-	handleConstraints();
+}
 
-	update();
+size_t WorldPrototype::findSubstepCount() const {
+	size_t substepCount = std::max(substepSettings.substepCount, size_t(1));
+	if(!substepSettings.adaptive) return substepCount;
+
+	// the fastest point of a physical moves at most the speed of its center of mass plus its angular velocity times the radius of its main part
+	double maxSpeed = 0.0;
+	for(const MotorizedPhysical* physical : physicals) {
+		if(physical->isSleeping) continue;
+		double speed = length(physical->getVelocityOfCenterOfMass()) + length(physical->getAngularVelocityOfCenterOfMass()) * physical->getMainPart()->maxRadius;
+		maxSpeed = std::max(maxSpeed, speed);
+	}
+	double maxPenetration = 0.0;
+	for(const Colission& c : currentObjectColissions) {
+		maxPenetration = std::max(maxPenetration, length(c.exitVector));
+	}
+	for(const Colission& c : currentTerrainColissions) {
+		maxPenetration = std::max(maxPenetration, length(c.exitVector));
+	}
+
+	double neededForSpeed = std::ceil(maxSpeed * deltaT / substepSettings.maxMovementPerSubstep);
+	double neededForPenetration = std::ceil(maxPenetration / substepSettings.maxPenetrationPerSubstep);
+	double needed = std::min(std::max(neededForSpeed, neededForPenetration), double(substepSettings.maxSubsteps));
+	return std::max(substepCount, size_t(needed));
 }
 
 void WorldPrototype::applyExternalForces() {
@@ -299,46 +523,359 @@ void WorldPrototype::applyExternalForces() {
 	}
 }
 
+/*
+	Fills the candidate lists with all overlapping pairs, regardless of whether the parts are awake
+*/
+static void findAllOverlappingPairs(ThreadPool& threadPool, const CompiledBoundsTree& compiledObjects, const CompiledBoundsTree& compiledTerrain, std::vector<std::vector<ColissionCandidate>>& workerCandidates, std::vector<ColissionCandidate>& currentObjectCandidates, std::vector<ColissionCandidate>& currentTerrainCandidates) {
+	if(compiledObjects.isEmpty()) return;
+	bool checkTerrain = !compiledTerrain.isEmpty() && intersects(compiledObjects.root.bounds, compiledTerrain.root.bounds);
+
+	size_t threadCount = threadPool.getThreadCount();
+	if(threadCount == 1) {
+		recursiveFindCandidatesInternal(currentObjectCandidates, compiledObjects, compiledObjects.root);
+		if(checkTerrain) {
+			recursiveFindCandidatesBetween(currentTerrainCandidates, compiledObjects, compiledObjects.root, compiledTerrain, compiledTerrain.root);
+		}
+		return;
+	}
+
+	std::vector<BroadPhaseTask> tasks{BroadPhaseTask{compiledObjects.root, CompiledChild(), false, false}};
+	if(checkTerrain) {
+		tasks.push_back(BroadPhaseTask{compiledObjects.root, compiledTerrain.root, true, true});
+	}
+	std::vector<BroadPhaseTask> splitTasks;
+	while(tasks.size() < threadCount * BROAD_PHASE_TASKS_PER_THREAD) {
+		splitTasks.clear();
+		bool anySplit = false;
+		for(const BroadPhaseTask& task : tasks) {
+			if(isSplittable(task)) {
+				splitTask(compiledObjects, compiledTerrain, task, splitTasks);
+				anySplit = true;
+			} else {
+				splitTasks.push_back(task);
+			}
+		}
+		std::swap(tasks, splitTasks);
+		if(!anySplit) break;
+	}
+
+	parallelForInOrder(threadPool, tasks.size(), workerCandidates, [&](size_t taskIndex, std::vector<ColissionCandidate>& output) {
+		const BroadPhaseTask& task = tasks[taskIndex];
+		if(!task.hasSecond) {
+			recursiveFindCandidatesInternal(output, compiledObjects, task.first);
+		} else {
+			recursiveFindCandidatesBetween(output, compiledObjects, task.first, task.isTerrain ? compiledTerrain : compiledObjects, task.second);
+		}
+	}, [&](size_t taskIndex, std::vector<ColissionCandidate>::const_iterator begin, std::vector<ColissionCandidate>::const_iterator end) {
+		std::vector<ColissionCandidate>& destination = tasks[taskIndex].isTerrain ? currentTerrainCandidates : currentObjectCandidates;
+		destination.insert(destination.end(), begin, end);
+	});
+}
+
+static void collectAwakePairs(std::vector<OverlappingPair>& pairs, std::vector<ColissionCandidate>& candidates) {
+	for(OverlappingPair& pair : pairs) {
+		if(isAwake(pair.p1) || isAwake(pair.p2)) {
+			candidates.push_back(ColissionCandidate{pair.p1, pair.p2, &pair.data});
+		}
+	}
+}
+
+void WorldPrototype::findColissionCandidates() {
+	currentObjectCandidates.clear();
+	currentTerrainCandidates.clear();
+
+	compileTrees();
+	if(pairCache.canUpdate(objectTree, terrainTree)) {
+		pairCache.update(objectTree, terrainTree);
+	} else {
+		findAllOverlappingPairs(threadPool, objectTree.compiled, terrainTree.compiled, workerCandidates, currentObjectCandidates, currentTerrainCandidates);
+		pairCache.rebuild(currentObjectCandidates, currentTerrainCandidates, objectTree, terrainTree);
+		currentObjectCandidates.clear();
+		currentTerrainCandidates.clear();
+	}
+	objectTree.clearLeafChanges();
+
+	collectAwakePairs(pairCache.getObjectPairs(), currentObjectCandidates);
+	collectAwakePairs(pairCache.getTerrainPairs(), currentTerrainCandidates);
+}
+
 void WorldPrototype::findColissions() {
 	physicsMeasure.mark(PhysicsProcess::COLISSION_OTHER);
 
+	findColissionCandidates();
+
 	currentObjectColissions.clear();
 	currentTerrainColissions.clear();
 
-	recursiveFindColissionsInternal(*this, currentObjectColissions, objectTree.rootNode);
-	recursiveFindColissionsBetween(*this, currentTerrainColissions, objectTree.rootNode, terrainTree.rootNode);
+	size_t threadCount = threadPool.getThreadCount();
+	if(threadCount == 1) {
+		for(const ColissionCandidate& candidate : currentObjectCandidates) {
+			runColissionTests(candidate, currentObjectColissions);
+		}
+		for(const ColissionCandidate& candidate : currentTerrainCandidates) {
+			runColissionTests(candidate, currentTerrainColissions);
+		}
+		return;
+	}
+
+	size_t objectChunks = (currentObjectCandidates.size() + NARROW_PHASE_CHUNK_SIZE - 1) / NARROW_PHASE_CHUNK_SIZE;
+	size_t terrainChunks = (currentTerrainCandidates.size() + NARROW_PHASE_CHUNK_SIZE - 1) / NARROW_PHASE_CHUNK_SIZE;
+
+	parallelForInOrder(threadPool, objectChunks + terrainChunks, workerColissions, [&](size_t chunkIndex, std::vector<Colission>& output) {
+		bool isTerrain = chunkIndex >= objectChunks;
+		const std::vector<ColissionCandidate>& candidates = isTerrain ? currentTerrainCandidates : currentObjectCandidates;
+		size_t begin = (isTerrain ? chunkIndex - objectChunks : chunkIndex) * NARROW_PHASE_CHUNK_SIZE;
+		size_t end = std::min(begin + NARROW_PHASE_CHUNK_SIZE, candidates.size());
+		for(size_t i = begin; i < end; i++) {
+			runColissionTests(candidates[i], output);
+		}
+	}, [&](size_t chunkIndex, std::vector<Colission>::const_iterator begin, std::vector<Colission>::const_iterator end) {
+		std::vector<Colission>& destination = chunkIndex >= objectChunks ? currentTerrainColissions : currentObjectColissions;
+		destination.insert(destination.end(), begin, end);
+	});
+	mergeWorkerStatistics(threadCount);
 }
 void WorldPrototype::handleColissions() {
 	physicsMeasure.mark(PhysicsProcess::COLISSION_HANDLING);
-	for (Colission c : currentObjectColissions) {
-		handleCollision(*c.p1, *c.p2, c.intersection, c.exitVector);
+	if(contactSolverSettings.type == ContactSolverType::SEQUENTIAL_IMPULSE) {
+		contactSolver.solve(currentObjectColissions, currentTerrainColissions, substepDeltaT, deltaT, contactSolverSettings);
+		return;
 	}
-	for (Colission c : currentTerrainColissions) {
-		handleTerrainCollision(*c.p1, *c.p2, c.intersection, c.exitVector);
+	size_t threadCount = threadPool.getThreadCount();
+	if(threadCount == 1) {
+		for (Colission c : currentObjectColissions) {
+			handleCollision(*c.p1, *c.p2, c.intersection, c.exitVector);
+		}
+		for (Colission c : currentTerrainColissions) {
+			handleTerrainCollision(*c.p1, *c.p2, c.intersection, c.exitVector);
+		}
+		return;
 	}
+
+	findColissionResponseLevels(currentObjectColissions, currentTerrainColissions, colissionResponseLevels);
+	const std::vector<size_t>& order = colissionResponseLevels.order;
+	const std::vector<size_t>& levelBegins = colissionResponseLevels.levelBegins;
+
+	auto handleColissionRange = [this, &order](size_t begin, size_t end) {
+		for(size_t i = begin; i < end; i++) {
+			size_t colissionIndex = order[i];
+			if(colissionIndex < currentObjectColissions.size()) {
+				Colission c = currentObjectColissions[colissionIndex];
+				handleCollision(*c.p1, *c.p2, c.intersection, c.exitVector);
+			} else {
+				Colission c = currentTerrainColissions[colissionIndex - currentObjectColissions.size()];
+				handleTerrainCollision(*c.p1, *c.p2, c.intersection, c.exitVector);
+			}
+		}
+	};
+	for(size_t level = 0; level + 1 < levelBegins.size(); level++) {
+		size_t levelBegin = levelBegins[level];
+		size_t levelEnd = levelBegins[level + 1];
+		if(levelEnd - levelBegin < COLISSION_RESPONSE_CHUNK_SIZE) {
+			handleColissionRange(levelBegin, levelEnd);
+			continue;
+		}
+		size_t chunkCount = (levelEnd - levelBegin + COLISSION_RESPONSE_CHUNK_SIZE - 1) / COLISSION_RESPONSE_CHUNK_SIZE;
+		threadPool.parallelFor(chunkCount, [&](size_t chunkIndex, size_t workerIndex) {
+			size_t begin = levelBegin + chunkIndex * COLISSION_RESPONSE_CHUNK_SIZE;
+			handleColissionRange(begin, std::min(begin + COLISSION_RESPONSE_CHUNK_SIZE, levelEnd));
+		});
+	}
+	mergeWorkerStatistics(threadCount);
 }
 void WorldPrototype::handleConstraints() {
 	physicsMeasure.mark(PhysicsProcess::CONSTRAINTS);
-	for (const ConstraintGroup& group : constraints) {
-		group.apply();
+	if(threadPool.getThreadCount() == 1) {
+		for (const ConstraintGroup& group : constraints) {
+			group.apply();
+		}
+		return;
 	}
+
+	std::vector<std::vector<ConstraintGroup>> batches = findIndependentConstraintBatches(constraints);
+	threadPool.parallelFor(batches.size(), [&batches](size_t batchIndex, size_t workerIndex) {
+		for(const ConstraintGroup& island : batches[batchIndex]) {
+			island.applyAsSingleSystem();
+		}
+	});
+	sleepStatistics.mergeWorkerTallies(threadPool.getThreadCount());
+}
+void WorldPrototype::updatePhysicals() {
+	// the time an update takes grows with the number of parts of the physical, so chunks are cut by the number of awake parts in them
+	updateChunkBoundaries.clear();
+	updateChunkBoundaries.push_back(0);
+	size_t partsInChunk = 0;
+	for(size_t i = 0; i < physicals.size(); i++) {
+		if(physicals[i]->isSleeping) continue;
+		partsInChunk += physicals[i]->getNumberOfPartsInThisAndChildren();
+		if(partsInChunk >= UPDATE_CHUNK_PART_COUNT) {
+			updateChunkBoundaries.push_back(i + 1);
+			partsInChunk = 0;
+		}
+	}
+	if(updateChunkBoundaries.back() != physicals.size()) {
+		updateChunkBoundaries.push_back(physicals.size());
+	}
+
+	auto updateChunk = [this](size_t begin, size_t end) {
+		// sleeping physicals are not integrated, so the kernel runs over each stretch of awake ones
+		size_t runBegin = begin;
+		for(size_t i = begin; i <= end; i++) {
+			if(i != end && !physicals[i]->isSleeping) {
+				dynamicsStore.setRotation(i, physicals[i]->getCFrame().getRotation().asRotationMatrix());
+				continue;
+			}
+			if(runBegin != i) {
+				getSIMDKernels().integrateVelocities(dynamicsStore.getArrays(), runBegin, i, this->substepDeltaT);
+			}
+			runBegin = i + 1;
+		}
+
+		for(size_t i = begin; i < end; i++) {
+			MotorizedPhysical* physical = physicals[i];
+			if(physical->isSleeping) continue;
+			physical->updatePosition(this->substepDeltaT, dynamicsStore.getVelocityStep(i));
+		}
+	};
+
+	size_t chunkCount = updateChunkBoundaries.size() - 1;
+	size_t threadCount = threadPool.getThreadCount();
+	if(threadCount == 1) {
+		for(size_t chunkIndex = 0; chunkIndex < chunkCount; chunkIndex++) {
+			updateChunk(updateChunkBoundaries[chunkIndex], updateChunkBoundaries[chunkIndex + 1]);
+		}
+		return;
+	}
+	threadPool.parallelFor(chunkCount, [this, &updateChunk](size_t chunkIndex, size_t workerIndex) {
+		updateChunk(updateChunkBoundaries[chunkIndex], updateChunkBoundaries[chunkIndex + 1]);
+	});
+	mergeWorkerStatistics(threadCount);
 }
 void WorldPrototype::update() {
-	physicsMeasure.mark(PhysicsProcess::UPDATING);
+	physicsMeasure.mark(PhysicsProcess::UPDATE_TREE_BOUNDS);
 	for (MotorizedPhysical* physical : iterPhysicals()) {
-		physical->update(this->deltaT);
+		if(!physical->hasOutdatedBounds) continue;
+		Part* mainPart = physical->getMainPart();
+		if(boundsMarginSettings.margin == 0.0) {
+			mainPart->layer.notifyPartGroupBoundsOutdated(mainPart, physical->mainPartBoundsInTree);
+		} else {
+			Vec3 predictedMovement = physical->getVelocityOfCenterOfMass() * (this->deltaT * boundsMarginSettings.predictedTicks);
+			mainPart->layer.notifyPartGroupBoundsOutdated(mainPart, physical->mainPartBoundsInTree, boundsMarginSettings.margin, predictedMovement);
+		}
+		physical->hasOutdatedBounds = false;
 	}
 
 	for(WorldLayer& layer : layers) {
 		physicsMeasure.mark(PhysicsProcess::UPDATE_TREE_BOUNDS);
 		BoundsTree<Part>& tree = layer.getObjectTree();
-		tree.recalculateBounds();
-		physicsMeasure.mark(PhysicsProcess::UPDATE_TREE_STRUCTURE);
-		tree.improveStructure();
+		// if no leaf had to change, the structure can't have gotten any worse
+		if(tree.refitOutdatedBounds()) {
+			physicsMeasure.mark(PhysicsProcess::UPDATE_TREE_STRUCTURE);
+			if(structureImprovementBudget == 0) {
+				tree.improveStructure();
+			} else {
+				tree.improveStructure(structureImprovementBudget);
+			}
+		}
 	}
+
+	physicsMeasure.mark(PhysicsProcess::UPDATING);
+	updateSleepingPhysicals();
 	age++;
 }
 
+static void wakeUpPhysical(Part* part, std::unordered_set<const MotorizedPhysical*>& wokenPhysicals) {
+	MotorizedPhysical* physical = part->parent->mainPhysical;
+	if(physical->isSleeping) {
+		physical->wakeUp();
+		wokenPhysicals.insert(physical);
+	}
+}
+
+// true for the parts of physicals that were woken last round, and for the parts whose pairs with those were not tested yet
+static bool wasLeftOut(const Part* part, const std::unordered_set<const MotorizedPhysical*>& wokenPhysicals) {
+	return part->parent == nullptr || part->parent->mainPhysical->isSleeping || wokenPhysicals.count(part->parent->mainPhysical) != 0;
+}
+
+static void testPairsOfWokenPhysicals(std::vector<OverlappingPair>& pairs, const std::unordered_set<const MotorizedPhysical*>& wokenPhysicals, std::vector<Colission>& colissions) {
+	for(OverlappingPair& pair : pairs) {
+		bool isWoken1 = pair.p1->parent != nullptr && wokenPhysicals.count(pair.p1->parent->mainPhysical) != 0;
+		bool isWoken2 = pair.p2->parent != nullptr && wokenPhysicals.count(pair.p2->parent->mainPhysical) != 0;
+		if((isWoken1 || isWoken2) && wasLeftOut(pair.p1, wokenPhysicals) && wasLeftOut(pair.p2, wokenPhysicals)) {
+			runColissionTests(*pair.p1, *pair.p2, pair.data, colissions);
+		}
+	}
+}
+
+void WorldPrototype::wakeUpTouchedPhysicals() {
+	// the broad phase only lets through pairs with at least one awake part, so every sleeping physical in here touches an awake one
+	std::unordered_set<const MotorizedPhysical*> wokenPhysicals;
+	size_t checkedColissions = 0;
+	while(true) {
+		for(; checkedColissions < currentObjectColissions.size(); checkedColissions++) {
+			const Colission& c = currentObjectColissions[checkedColissions];
+			wakeUpPhysical(c.p1, wokenPhysicals);
+			wakeUpPhysical(c.p2, wokenPhysicals);
+		}
+		if(wokenPhysicals.empty()) break;
+
+		// pairs of the woken physicals with terrain and with sleeping physicals were left out of the narrow phase,
+		// without them the woken physicals would get no support this tick. Their touched sleeping neighbours are woken the next round
+		testPairsOfWokenPhysicals(pairCache.getObjectPairs(), wokenPhysicals, currentObjectColissions);
+		testPairsOfWokenPhysicals(pairCache.getTerrainPairs(), wokenPhysicals, currentTerrainColissions);
+		wokenPhysicals.clear();
+	}
+}
+
+static bool hasBarelyMoved(const GlobalCFrame& from, const GlobalCFrame& to, const SleepSettings& settings) {
+	Vec3 movement = to.getPosition() - from.getPosition();
+	Vec3 rotation = (~from.getRotation() * to.getRotation()).asRotationVector();
+	return lengthSquared(movement) <= settings.maxMovement * settings.maxMovement && lengthSquared(rotation) <= settings.maxRotation * settings.maxRotation;
+}
+
+void WorldPrototype::updateSleepingPhysicals() {
+	if(sleepSettings.ticksUntilSleep == 0) return;
+	for(MotorizedPhysical* physical : iterPhysicals()) {
+		if(physical->isSleeping) continue;
+		if(physical->getKineticEnergy() > sleepSettings.maxKineticEnergyPerMass * physical->totalMass) {
+			physical->ticksAtRest = 0;
+			continue;
+		}
+		if(physical->ticksAtRest == 0 || !hasBarelyMoved(physical->restingCFrame, physical->getCFrame(), sleepSettings)) {
+			// start measuring again from here
+			physical->restingCFrame = physical->getCFrame();
+			physical->ticksAtRest = 0;
+		}
+		physical->ticksAtRest++;
+	}
+
+	// touching physicals fall asleep together, otherwise one that is still settling would wake the other every time it falls asleep
+	bool changed = true;
+	while(changed) {
+		changed = false;
+		for(const Colission& c : currentObjectColissions) {
+			MotorizedPhysical* physical1 = c.p1->parent->mainPhysical;
+			MotorizedPhysical* physical2 = c.p2->parent->mainPhysical;
+			bool isReady1 = physical1->isSleeping || physical1->ticksAtRest >= sleepSettings.ticksUntilSleep;
+			bool isReady2 = physical2->isSleeping || physical2->ticksAtRest >= sleepSettings.ticksUntilSleep;
+			if(isReady1 != isReady2) {
+				// keeps the ready one at rest, it can fall asleep the first tick the other one is ready too
+				MotorizedPhysical* ready = isReady1 ? physical1 : physical2;
+				if(!ready->isSleeping) {
+					ready->ticksAtRest = sleepSettings.ticksUntilSleep - 1;
+					changed = true;
+				}
+			}
+		}
+	}
+
+	for(MotorizedPhysical* physical : iterPhysicals()) {
+		if(!physical->isSleeping && physical->ticksAtRest >= sleepSettings.ticksUntilSleep) {
+			physical->fallAsleep();
+		}
+	}
+}
+
 
 
 double WorldPrototype::getTotalKineticEnergy() const {
@@ -43,7 +43,7 @@ TEST_CASE(testMotionOfPhysicalSinglePart) {
 
 	Motion COMMotion(Vec3(1.0, 0.7, 1.3), Vec3(-0.3, 1.7, -1.1));
 
-	p1.parent->mainPhysical->motionOfCenterOfMass = COMMotion;
+	p1.parent->mainPhysical->setMotionOfCenterOfMass(COMMotion);
 
 	Vec3 p1calculatedVelBefore = p1.getMotion().getVelocity();
 
@@ -72,7 +72,7 @@ TEST_CASE(testMotionOfPhysicalPartsBasic) {
 
 	Motion COMMotion(Vec3(1.0, 0.7, 1.3), Vec3(0,0,0));
 
-	p1.parent->mainPhysical->motionOfCenterOfMass = COMMotion;
+	p1.parent->mainPhysical->setMotionOfCenterOfMass(COMMotion);
 
 	Vec3 p1calculatedVelBefore = p1.getMotion().getVelocity();
 	Vec3 p2calculatedVelBefore = p2.getMotion().getVelocity();
@@ -109,7 +109,7 @@ TEST_CASE(testMotionOfPhysicalPartsRotation) {
 
 	Motion COMMotion(Vec3(0, 0, 0), Vec3(-0.3, 1.7, -1.1));
 
-	p1.parent->mainPhysical->motionOfCenterOfMass = COMMotion;
+	p1.parent->mainPhysical->setMotionOfCenterOfMass(COMMotion);
 
 	Vec3 p1calculatedVelBefore = p1.getMotion().getVelocity();
 	Vec3 p2calculatedVelBefore = p2.getMotion().getVelocity();
@@ -151,7 +151,7 @@ TEST_CASE(testMotionOfPhysicalPartsBasicFixedConstraint) {
 
 	Motion COMMotion(Vec3(1.0, 0.7, 1.3), Vec3(0, 0, 0));
 
-	p1.parent->mainPhysical->motionOfCenterOfMass = COMMotion;
+	p1.parent->mainPhysical->setMotionOfCenterOfMass(COMMotion);
 
 	Vec3 p1calculatedVelBefore = p1.getMotion().getVelocity();
 	Vec3 p2calculatedVelBefore = p2.getMotion().getVelocity();
@@ -189,7 +189,7 @@ TEST_CASE(testMotionOfPhysicalPartsRotationFixedConstraint) {
 
 	Motion COMMotion(Vec3(0, 0, 0), Vec3(-0.3, 1.7, -1.1));
 
-	p1.parent->mainPhysical->motionOfCenterOfMass = COMMotion;
+	p1.parent->mainPhysical->setMotionOfCenterOfMass(COMMotion);
 
 	Vec3 p1calculatedVelBefore = p1.getMotion().getVelocity();
 	Vec3 p2calculatedVelBefore = p2.getMotion().getVelocity();
@@ -230,7 +230,7 @@ TEST_CASE(testMotionOfPhysicalParts) {
 
 	Motion COMMotion(Vec3(1.0, 0.7, 1.3), Vec3(-0.3, 1.7, -1.1));
 
-	p1.parent->mainPhysical->motionOfCenterOfMass = COMMotion;
+	p1.parent->mainPhysical->setMotionOfCenterOfMass(COMMotion);
 
 	Vec3 p1calculatedVelBefore = p1.getMotion().getVelocity();
 	Vec3 p2calculatedVelBefore = p2.getMotion().getVelocity();
@@ -272,8 +272,8 @@ TEST_CASE(testMotionOfPhysicalJointsBasic) {
 
 	Motion COMMotion(Vec3(1.0, 0.7, 1.3), Vec3(0,0,0));
 
-	p1.parent->mainPhysical->motionOfCenterOfMass = COMMotion;
-	p1e.parent->mainPhysical->motionOfCenterOfMass = COMMotion;
+	p1.parent->mainPhysical->setMotionOfCenterOfMass(COMMotion);
+	p1e.parent->mainPhysical->setMotionOfCenterOfMass(COMMotion);
 
 	ASSERT(p1.getMotion() == p1e.getMotion());
 	ASSERT(p2.getMotion() == p2e.getMotion());
@@ -291,8 +291,8 @@ TEST_CASE(testMotionOfPhysicalJointsRotation) {
 
 	Motion COMMotion(Vec3(0,0,0), Vec3(-0.3, 1.7, -1.1));
 
-	p1.parent->mainPhysical->motionOfCenterOfMass = COMMotion;
-	p1e.parent->mainPhysical->motionOfCenterOfMass = COMMotion;
+	p1.parent->mainPhysical->setMotionOfCenterOfMass(COMMotion);
+	p1e.parent->mainPhysical->setMotionOfCenterOfMass(COMMotion);
 
 	logStream << p1.parent->getMotion() << "\n";
 	logStream << p1.getMotion() << "\n";
@@ -317,8 +317,8 @@ TEST_CASE(testMotionOfPhysicalJoints) {
 
 	Motion COMMotion(Vec3(1.0, 0.7, 1.3), Vec3(-0.3, 1.7, -1.1));
 
-	p1.parent->mainPhysical->motionOfCenterOfMass = COMMotion;
-	p1e.parent->mainPhysical->motionOfCenterOfMass = COMMotion;
+	p1.parent->mainPhysical->setMotionOfCenterOfMass(COMMotion);
+	p1e.parent->mainPhysical->setMotionOfCenterOfMass(COMMotion);
 
 	logStream << p1.parent->getMotion() << "\n";
 	logStream << p1.getMotion() << "\n";
@@ -350,8 +350,8 @@ TEST_CASE(testFixedConstraintProperties) {
 	ASSERT(p2e.getCFrame() == GlobalCFrame(1.0, 0.0, 0.0));
 	ASSERT(phys1->totalMass == phys1e->totalMass);
 	ASSERT(phys1->getCenterOfMass() == phys1e->getCenterOfMass());
-	ASSERT(phys1->forceResponse == phys1e->forceResponse);
-	ASSERT(phys1->momentResponse == phys1e->momentResponse);
+	ASSERT(phys1->getForceResponse() == phys1e->getForceResponse());
+	ASSERT(phys1->getMomentResponse() == phys1e->getMomentResponse());
 
 }
 
@@ -383,8 +383,8 @@ TEST_CASE(testApplyForceToFixedConstraint) {
 	ASSERT(p1.getCFrame() == p1e.getCFrame());
 	ASSERT(p2.getCFrame() == p2e.getCFrame());
 
-	ASSERT(phys1->forceResponse == phys1e->forceResponse);
-	ASSERT(phys1->momentResponse == phys1e->momentResponse);
+	ASSERT(phys1->getForceResponse() == phys1e->getForceResponse());
+	ASSERT(phys1->getMomentResponse() == phys1e->getMomentResponse());
 
 	phys1->applyImpulseAtCenterOfMass(Vec3(2.7, 3.9, -2.3));
 	phys1e->applyImpulseAtCenterOfMass(Vec3(2.7, 3.9, -2.3));
@@ -397,8 +397,8 @@ TEST_CASE(testApplyForceToFixedConstraint) {
 	ASSERT(p1.getCFrame() == p1e.getCFrame());
 	ASSERT(p2.getCFrame() == p2e.getCFrame());
 
-	ASSERT(phys1->forceResponse == phys1e->forceResponse);
-	ASSERT(phys1->momentResponse == phys1e->momentResponse);
+	ASSERT(phys1->getForceResponse() == phys1e->getForceResponse());
+	ASSERT(phys1->getMomentResponse() == phys1e->getMomentResponse());
 }
 
 TEST_CASE(testPlainAttachAndFixedConstraintIndistinguishable) {
@@ -456,3 +456,41 @@ TEST_CASE(testInternalMotionOfCenterOfMass) {
 
 	ASSERT(motionOfCom == estimatedMotion);
 }
+
+TEST_CASE(constraintGroupSplitsIntoIslands) {
+	Part parts[5]{
+		Part(boxShape(1.0, 1.0, 1.0), GlobalCFrame(0.0, 0.0, 0.0), {1.0, 1.0, 1.0}),
+		Part(boxShape(1.0, 1.0, 1.0), GlobalCFrame(2.0, 0.0, 0.0), {1.0, 1.0, 1.0}),
+		Part(boxShape(1.0, 1.0, 1.0), GlobalCFrame(4.0, 0.0, 0.0), {1.0, 1.0, 1.0}),
+		Part(boxShape(1.0, 1.0, 1.0), GlobalCFrame(6.0, 0.0, 0.0), {1.0, 1.0, 1.0}),
+		Part(boxShape(1.0, 1.0, 1.0), GlobalCFrame(8.0, 0.0, 0.0), {1.0, 1.0, 1.0})
+	};
+	Physical* phys[5];
+	for(int i = 0; i < 5; i++) {
+		parts[i].ensureHasParent();
+		phys[i] = parts[i].parent;
+	}
+	BallConstraint ball(Vec3(1.0, 0.0, 0.0), Vec3(-1.0, 0.0, 0.0));
+
+	ConstraintGroup first;
+	first.add(phys[0], phys[1], &ball);
+	first.add(phys[3], phys[4], &ball);
+	first.add(phys[1], phys[0], &ball);
+
+	std::vector<ConstraintGroup> islands = first.splitIntoIslands();
+	ASSERT_STRICT(islands.size() == 2);
+	ASSERT_STRICT(islands[0].constraints.size() == 2);
+	ASSERT_STRICT(islands[0].constraints[1].physA == phys[1]);
+	ASSERT_STRICT(islands[1].constraints.size() == 1);
+	ASSERT_STRICT(islands[1].constraints[0].physA == phys[3]);
+
+	ConstraintGroup second;
+	second.add(phys[2], phys[1], &ball);
+
+	std::vector<std::vector<ConstraintGroup>> batches = findIndependentConstraintBatches(std::vector<ConstraintGroup>{first, second});
+	ASSERT_STRICT(batches.size() == 2);
+	ASSERT_STRICT(batches[0].size() == 2);
+	ASSERT_STRICT(batches[0][1].constraints[0].physA == phys[2]);
+	ASSERT_STRICT(batches[1].size() == 1);
+	ASSERT_STRICT(batches[1][0].constraints[0].physA == phys[3]);
+}
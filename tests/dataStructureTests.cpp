@@ -4,6 +4,9 @@
 #include "../physics/misc/toString.h"
 
 #include "../physics/datastructures/boundsTree.h"
+#include "../physics/threading/threadPool.h"
+
+#include <vector>
 
 struct BasicBounded {
 	
@@ -13,3 +16,232 @@ TEST_CASE(testBoundsTree) {
 
 }
 
+
+static bool sameTreeStructure(const TreeNode& first, const TreeNode& second) {
+	if(first.bounds != second.bounds || first.nodeCount != second.nodeCount) return false;
+	if(first.isLeafNode()) return first.object == second.object;
+	for(int i = 0; i < first.nodeCount; i++) {
+		if(!sameTreeStructure(first.subTrees[i], second.subTrees[i])) return false;
+	}
+	return true;
+}
+
+TEST_CASE(budgetedImproveStructureMatchesFullPass) {
+	BasicBounded objects[200];
+	BoundsTree<BasicBounded> fullTree;
+	BoundsTree<BasicBounded> budgetedTree;
+	for(int i = 0; i < 200; i++) {
+		// spread out in a way that leaves plenty for improveStructure to fix
+		Position min((i * 37) % 50, (i * 11) % 7, (i * 5) % 13);
+		Bounds bounds(min, min + Vec3Fix(1.5, 1.5, 1.5));
+		fullTree.add(TreeNode(&objects[i], bounds, false));
+		budgetedTree.add(TreeNode(&objects[i], bounds, false));
+	}
+	ASSERT_TRUE(sameTreeStructure(fullTree.rootNode, budgetedTree.rootNode));
+
+	fullTree.improveStructure();
+
+	size_t totalImproved = 0;
+	do {
+		size_t improved = budgetedTree.improveStructure(7);
+		ASSERT_TRUE(improved <= 7);
+		totalImproved += improved;
+	} while(budgetedTree.improveStructureCursor.depth != 0);
+
+	ASSERT_TRUE(totalImproved > 7);
+	ASSERT_TRUE(sameTreeStructure(fullTree.rootNode, budgetedTree.rootNode));
+}
+
+static bool boundsContainSubTrees(const TreeNode& node) {
+	if(node.isLeafNode()) return true;
+	for(const TreeNode& subNode : node) {
+		if(!node.bounds.contains(subNode.bounds) || !boundsContainSubTrees(subNode)) return false;
+	}
+	return true;
+}
+
+static void collectObjects(const TreeNode& node, std::vector<const void*>& output) {
+	if(node.isLeafNode()) {
+		output.push_back(node.object);
+	} else {
+		for(const TreeNode& subNode : node) {
+			collectObjects(subNode, output);
+		}
+	}
+}
+
+static void collectGroups(const TreeNode& node, std::vector<std::vector<const void*>>& groups) {
+	if(node.isGroupHead) {
+		groups.emplace_back();
+		collectObjects(node, groups.back());
+	} else if(!node.isLeafNode()) {
+		for(const TreeNode& subNode : node) {
+			collectGroups(subNode, groups);
+		}
+	}
+}
+
+// 600 single objects followed by 200 groups of 3
+static void buildGroupedTree(BoundsTree<BasicBounded>& tree, BasicBounded* objects) {
+	for(int i = 0; i < 1200; i++) {
+		Position min((i * 37) % 101, (i * 11) % 7, (i * 53) % 89);
+		Bounds bounds(min, min + Vec3Fix(1.5, 1.5, 1.5));
+		if(i < 600) {
+			tree.add(&objects[i], bounds);
+		} else if(i % 3 == 0) {
+			TreeNode* subTrees = allocateSubTrees();
+			for(int j = 0; j < 3; j++) {
+				subTrees[j] = TreeNode(&objects[i + j], Bounds(min + Vec3Fix(j * 1.0, 0.0, 0.0), min + Vec3Fix(j + 1.5, 1.5, 1.5)), false);
+			}
+			TreeNode group(subTrees, 3);
+			group.isGroupHead = true;
+			tree.add(std::move(group));
+		}
+	}
+}
+
+TEST_CASE(topDownRebuildKeepsObjectsAndGroups) {
+	BasicBounded objects[1200];
+	BoundsTree<BasicBounded> tree;
+	buildGroupedTree(tree, objects);
+
+	tree.rebuild();
+
+	ASSERT_STRICT(tree.getNumberOfObjects() == 1200);
+	ASSERT_TRUE(boundsContainSubTrees(tree.rootNode));
+	ASSERT_TRUE(tree.rootNode.getLengthOfLongestBranch() < MAX_HEIGHT);
+
+	std::vector<std::vector<const void*>> groups;
+	collectGroups(tree.rootNode, groups);
+	ASSERT_STRICT(groups.size() == 800);
+	for(const std::vector<const void*>& group : groups) {
+		size_t firstIndex = static_cast<const BasicBounded*>(group[0]) - objects;
+		if(firstIndex < 600) {
+			ASSERT_STRICT(group.size() == 1);
+		} else {
+			ASSERT_STRICT(group.size() == 3);
+			for(const void* obj : group) {
+				ASSERT_STRICT((static_cast<const BasicBounded*>(obj) - objects) / 3 == firstIndex / 3);
+			}
+		}
+	}
+
+	BoundsTree<BasicBounded> parallelTree;
+	buildGroupedTree(parallelTree, objects);
+	ThreadPool pool(3);
+	parallelTree.rebuild(&pool);
+	ASSERT_TRUE(sameTreeStructure(tree.rootNode, parallelTree.rootNode));
+}
+
+TEST_CASE(compiledTreeQueriesMatchTree) {
+	BasicBounded objects[1200];
+	BoundsTree<BasicBounded> tree;
+	buildGroupedTree(tree, objects);
+	tree.rebuild();
+	tree.compile();
+	ASSERT_TRUE(tree.isCompiledUpToDate());
+
+	size_t totalFound = 0;
+	for(int i = 0; i < 50; i++) {
+		Position min((i * 13) % 97, (i * 3) % 5, (i * 29) % 83);
+		Bounds query(min, min + Vec3Fix(4.0, 2.0, 6.0));
+		Ray ray{min, Vec3(1.0, 0.1 * (i % 7), 0.3)};
+
+		std::vector<const void*> fromCompiled;
+		std::vector<const void*> fromCompiledRay;
+		tree.forEachInBounds(query, [&](BasicBounded& obj) {fromCompiled.push_back(&obj); });
+		tree.forEachOnRay(ray, [&](BasicBounded& obj) {fromCompiledRay.push_back(&obj); });
+
+		// force the queries to run on the tree itself
+		tree.markModified();
+		std::vector<const void*> fromTree;
+		std::vector<const void*> fromTreeRay;
+		tree.forEachInBounds(query, [&](BasicBounded& obj) {fromTree.push_back(&obj); });
+		tree.forEachOnRay(ray, [&](BasicBounded& obj) {fromTreeRay.push_back(&obj); });
+		tree.compile();
+
+		ASSERT_TRUE(fromCompiled == fromTree);
+		ASSERT_TRUE(fromCompiledRay == fromTreeRay);
+		totalFound += fromCompiled.size() + fromCompiledRay.size();
+	}
+	ASSERT_TRUE(totalFound > 0);
+}
+
+TEST_CASE(leafPathsFindObjectsWithoutSearching) {
+	BasicBounded objects[1200];
+	BoundsTree<BasicBounded> tree;
+	buildGroupedTree(tree, objects);
+
+	Position min((5 * 37) % 101, (5 * 11) % 7, (5 * 53) % 89);
+	Bounds bounds(min, min + Vec3Fix(1.5, 1.5, 1.5));
+	ASSERT_TRUE((*tree.find(&objects[5], bounds))->object == &objects[5]);
+
+	// bounds that don't contain the object would make the search fail, the recorded path doesn't need them
+	Bounds wrongBounds(Position(1000.0, 1000.0, 1000.0), Position(1001.0, 1001.0, 1001.0));
+	ASSERT_TRUE((*tree.find(&objects[5], wrongBounds))->object == &objects[5]);
+
+	// paths broken by restructuring fall back to searching by bounds
+	tree.rebuild();
+	ASSERT_TRUE((*tree.find(&objects[5], bounds))->object == &objects[5]);
+	tree.remove(&objects[5], bounds);
+	ASSERT_TRUE(tree.leafPaths.find(&objects[5]) == tree.leafPaths.end());
+	ASSERT_TRUE(tree.getNumberOfObjects() == 1199);
+}
+
+// bounds of the single objects and of the first object of each group of buildGroupedTree
+static Bounds groupedTreeBounds(int i) {
+	Position min((i * 37) % 101, (i * 11) % 7, (i * 53) % 89);
+	return Bounds(min, min + Vec3Fix(1.5, 1.5, 1.5));
+}
+
+static size_t countInternalNodes(const TreeNode& node) {
+	if(node.isLeafNode()) return 0;
+	size_t total = 1;
+	for(const TreeNode& subNode : node) {
+		total += countInternalNodes(subNode);
+	}
+	return total;
+}
+
+TEST_CASE(treeNodePoolReusesFreedBlocks) {
+	BasicBounded objects[600];
+	BoundsTree<BasicBounded> tree;
+	for(int i = 0; i < 600; i++) {
+		tree.add(&objects[i], groupedTreeBounds(i));
+	}
+
+	TreeNodePoolStatistics built = tree.getNodePoolStatistics();
+	ASSERT_TRUE(built.getBlocksInUse() == countInternalNodes(tree.rootNode));
+	ASSERT_TRUE(built.slabsAllocated < built.blocksAllocated);
+
+	// restructuring and re-adding objects is served from the free list
+	for(int round = 0; round < 3; round++) {
+		for(int i = 0; i < 600; i++) {
+			TreeNode node = tree.grab(&objects[i], groupedTreeBounds(i));
+			tree.add(std::move(node));
+		}
+		tree.improveStructure();
+		tree.rebuild();
+	}
+	TreeNodePoolStatistics after = tree.getNodePoolStatistics();
+	ASSERT_TRUE(after.getBlocksInUse() == countInternalNodes(tree.rootNode));
+	ASSERT_TRUE(after.slabsAllocated <= built.slabsAllocated + 1);
+	ASSERT_TRUE(after.blocksAllocated > built.blocksAllocated);
+}
+
+TEST_CASE(treeNodesOutliveTheTreeTheyCameFrom) {
+	BasicBounded objects[1200];
+	BoundsTree<BasicBounded> target;
+	{
+		BoundsTree<BasicBounded> source;
+		buildGroupedTree(source, objects);
+		for(int i = 600; i < 1200; i += 3) {
+			target.add(source.grabGroupFor(&objects[i], groupedTreeBounds(i)));
+		}
+	}
+	// the groups still live in blocks of the pool of source, which is only deleted once they are freed
+	ASSERT_TRUE(target.getNumberOfObjects() == 600);
+	target.rebuild();
+	target.clear();
+	ASSERT_TRUE(target.getNodePoolStatistics().getBlocksInUse() == 0);
+}
@@ -11,11 +11,27 @@
 
 #include "../physics/geometry/shape.h"
 #include "../physics/geometry/boundingBox.h"
+#include "../physics/geometry/computationBuffer.h"
+#include "../physics/geometry/intersection.h"
+#include "../physics/geometry/genericIntersection.h"
+#include "../physics/geometry/primitiveIntersection.h"
+#include "../physics/geometry/shapeCreation.h"
+#include "../physics/geometry/shapeClass.h"
+#include "../physics/geometry/builtinShapeClasses.h"
+#include "../physics/geometry/shapeClassRegistry.h"
 
 #include "../physics/misc/shapeLibrary.h"
+#include "../physics/simd/simdKernels.h"
+#include "../physics/datastructures/alignedPtr.h"
+#include "../physics/part.h"
 
 #include "testValues.h"
 
+#include <optional>
+#include <cmath>
+#include <random>
+#include <climits>
+
 #define ASSERT(condition) ASSERT_TOLERANT(condition, 0.00001)
 
 template<typename T, typename Tol, size_t Size>
@@ -155,3 +171,317 @@ TEST_CASE(testGetFurthestPointInDirection) {
 		ASSERT(Library::icosahedron.furthestInDirection(vertex) == vertex);
 	}
 }
+
+TEST_CASE(computationBuffersKeepContentsWhenGrowing) {
+	ComputationBuffers buffers(4, 4);
+	for(int i = 0; i < 4; i++) {
+		buffers.vertBuf[i] = Vec3f(float(i), 0.0f, 0.0f);
+		buffers.removalBuf[i] = i;
+	}
+
+	buffers.ensureCapacity(100, 200);
+
+	ASSERT_STRICT(buffers.vertexCapacity == 100);
+	ASSERT_STRICT(buffers.triangleCapacity == 200);
+	for(int i = 0; i < 4; i++) {
+		ASSERT_STRICT(buffers.vertBuf[i] == Vec3f(float(i), 0.0f, 0.0f));
+		ASSERT_STRICT(buffers.removalBuf[i] == i);
+	}
+}
+
+TEST_CASE(computationBufferPoolReusesBuffers) {
+	ComputationBufferPool pool(8, 16);
+	{
+		ComputationBufferPool::Lease first = pool.lease();
+		ComputationBufferPool::Lease second = pool.lease(50, 10);
+		ASSERT_STRICT(second->vertexCapacity == 50);
+		ASSERT_STRICT(second->triangleCapacity == 16);
+		ASSERT_STRICT(pool.getStatistics().currentlyLeased == 2);
+	}
+	{
+		ComputationBufferPool::Lease third = pool.lease();
+	}
+
+	ComputationBufferPoolStatistics statistics = pool.getStatistics();
+	ASSERT_STRICT(statistics.buffersCreated == 2);
+	ASSERT_STRICT(statistics.currentlyLeased == 0);
+	ASSERT_STRICT(statistics.maxLeased == 2);
+	ASSERT_STRICT(statistics.maxVertexCapacity == 50);
+	ASSERT_STRICT(statistics.maxTriangleCapacity == 16);
+}
+
+TEST_CASE(gjkWarmStartGivesSameResults) {
+	Shape box = boxShape(1.0, 2.0, 1.5);
+	Shape sphere = sphereShape(0.8);
+
+	IntersectionWarmStart warmStart;
+	for(int i = 0; i < 200; i++) {
+		double t = i * 0.05;
+		CFrame relativeTransform(Vec3(1.3 + 0.6 * sin(t), 0.3 * cos(t), 0.2), Rotation::fromEulerAngles(0.1 * t, 0.2, 0.05 * t));
+		// through GJK even for these builtin shapes, intersectsTransformed on Shapes would use the closed form routines
+		std::optional<Intersection> cold = intersectsTransformed(*box.baseShape, *sphere.baseShape, relativeTransform, box.scale, sphere.scale);
+		std::optional<Intersection> warm = intersectsTransformed(*box.baseShape, *sphere.baseShape, relativeTransform, box.scale, sphere.scale, &warmStart);
+		ASSERT_STRICT(cold.has_value() == warm.has_value());
+		ASSERT_TRUE(warmStart.hasSearchDirection);
+		if(cold) {
+			// EPA starts from a different simplex, so the results only agree up to its approximation of the sphere,
+			// a wrong result from a stale search direction would be off by about the size of the shapes
+			ASSERT_TOLERANT(warm->exitVector == cold->exitVector, 0.005);
+			ASSERT_TOLERANT(warm->intersection == cold->intersection, 0.05);
+		}
+	}
+}
+
+TEST_CASE(gjkWarmStartEndsAtFirstSupportWhileApart) {
+	Shape box = boxShape(1.0, 1.0, 1.0);
+	CFrame apart(Vec3(1.5, 0.2, 0.1), Rotation::fromEulerAngles(0.3, 0.2, 0.1));
+
+	IntersectionWarmStart warmStart;
+	ASSERT_FALSE(intersectsTransformed(*box.baseShape, *box.baseShape, apart, box.scale, box.scale, &warmStart).has_value());
+	ASSERT_TRUE(warmStart.hasSearchDirection);
+
+	// a search that ends at the first support point leaves the direction as it was
+	ColissionPair pair{*box.baseShape, *box.baseShape, apart, box.scale, box.scale};
+	Vec3f searchDirection = warmStart.searchDirection;
+	ASSERT_FALSE(runGJKTransformed(pair, searchDirection).has_value());
+	ASSERT_STRICT(searchDirection == warmStart.searchDirection);
+}
+
+TEST_CASE(primitiveIntersectionsMatchGJK) {
+	Shape shapes[]{boxShape(1.0, 2.0, 1.5), sphereShape(0.8), cylinderShape(0.6, 1.8), boxShape(0.4, 0.7, 2.2), sphereShape(1.3)};
+
+	std::mt19937 random(42);
+	std::uniform_real_distribution<double> position(-2.0, 2.0);
+	std::uniform_real_distribution<double> angle(-3.14, 3.14);
+	int colissionsChecked = 0;
+	int outcomesChecked = 0;
+	int outcomesDiffering = 0;
+	for(const Shape& first : shapes) {
+		for(const Shape& second : shapes) {
+			for(int i = 0; i < 200; i++) {
+				CFrame relativeTransform(Vec3(position(random), position(random), position(random)), Rotation::fromEulerAngles(angle(random), angle(random), angle(random)));
+				std::optional<Intersection> primitive;
+				if(!intersectsPrimitives(*first.baseShape, *second.baseShape, relativeTransform, first.scale, second.scale, primitive)) continue;
+				std::optional<Intersection> gjk = intersectsTransformed(*first.baseShape, *second.baseShape, relativeTransform, first.scale, second.scale);
+
+				double primitiveDepth = primitive ? length(primitive->exitVector) : 0.0;
+				double gjkDepth = gjk ? length(gjk->exitVector) : 0.0;
+				// grazing contacts may go either way with GJK working in floats
+				if(primitiveDepth < 0.01 && gjkDepth < 0.01) continue;
+				outcomesChecked++;
+				// GJK now and then runs into its iteration limit on round shapes and gives up
+				if(primitive.has_value() != gjk.has_value()) {
+					outcomesDiffering++;
+					continue;
+				}
+				if(!primitive) continue;
+
+				colissionsChecked++;
+				// spheres and cylinders are approximated by polyhedra in EPA, and nearly equal faces may be picked differently, so only the depths are compared
+				ASSERT_TOLERANT(primitiveDepth == gjkDepth, 0.05);
+				// moving second by the exitVector must separate the shapes
+				CFrame separated(relativeTransform.position + primitive->exitVector * 1.001, relativeTransform.rotation);
+				std::optional<Intersection> afterSeparation;
+				intersectsPrimitives(*first.baseShape, *second.baseShape, separated, first.scale, second.scale, afterSeparation);
+				ASSERT_FALSE(afterSeparation.has_value());
+			}
+		}
+	}
+	ASSERT_TRUE(colissionsChecked > 100);
+	ASSERT_TRUE(outcomesDiffering * 100 < outcomesChecked);
+}
+
+TEST_CASE(hillClimbingFindsFurthestVertex) {
+	// the prism has large flat caps and sides, where many vertices are equally far
+	Polyhedron polyhedra[]{Library::createSphere(1.0f, 3), Library::createPrism(100, 0.7f, 2.0f), Library::createBox(1.0f, 2.0f, 3.0f)};
+
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> component(-1.0f, 1.0f);
+	for(const Polyhedron& poly : polyhedra) {
+		PolyhedronShapeClass scanning{Polyhedron(poly), INT_MAX};
+		PolyhedronShapeClass climbing{Polyhedron(poly), 0};
+		ASSERT_FALSE(scanning.usesHillClimbing());
+		ASSERT_TRUE(climbing.usesHillClimbing());
+
+		int vertexHint = -1;
+		for(int i = 0; i < 500; i++) {
+			Vec3f direction = (i % 50 == 0) ? Vec3f(0.0f, 0.0f, 1.0f) : Vec3f(component(random), component(random), component(random));
+			float bestDot = scanning.furthestInDirection(direction) * direction;
+			ASSERT_TOLERANT(climbing.furthestInDirectionFrom(direction, vertexHint) * direction == bestDot, 0.00001);
+			ASSERT_TOLERANT(climbing.furthestInDirection(direction) * direction == bestDot, 0.00001);
+		}
+	}
+}
+
+TEST_CASE(identicalPolyhedraShareShapeClass) {
+	const ShapeClass* shared;
+	{
+		Shape a = polyhedronShape(Library::createPrism(13, 0.7f, 2.0f));
+		Shape b = polyhedronShape(Library::createPrism(13, 0.7f, 2.0f));
+		Shape c = polyhedronShape(Library::createPrism(14, 0.7f, 2.0f));
+		ASSERT_TRUE(a.baseShape == b.baseShape);
+		ASSERT_FALSE(a.baseShape == c.baseShape);
+		ASSERT_STRICT(getShapeClassRegistry().getReferenceCount(a.baseShape) == 2);
+		shared = a.baseShape;
+
+		Shape copy = a;
+		ASSERT_STRICT(getShapeClassRegistry().getReferenceCount(shared) == 3);
+		copy = c;
+		ASSERT_STRICT(getShapeClassRegistry().getReferenceCount(shared) == 2);
+		ASSERT_STRICT(getShapeClassRegistry().getReferenceCount(c.baseShape) == 2);
+		copy = copy;
+		ASSERT_STRICT(getShapeClassRegistry().getReferenceCount(c.baseShape) == 2);
+	}
+	ASSERT_STRICT(getShapeClassRegistry().getReferenceCount(shared) == 0);
+}
+
+TEST_CASE(destroyedPartsFreeTheirShapeClass) {
+	size_t liveBefore = getShapeClassRegistry().getStatistics().getLiveClassCount();
+	{
+		std::vector<Part> parts;
+		for(int i = 0; i < 10; i++) {
+			parts.emplace_back(polyhedronShape(Library::createPrism(20 + i % 3, 0.4f, 1.0f)), GlobalCFrame(i * 3.0, 0.0, 0.0), PartProperties{1.0, 0.5, 0.5});
+		}
+		ASSERT_STRICT(getShapeClassRegistry().getStatistics().getLiveClassCount() == liveBefore + 3);
+		// the parts have been moved around while the vector grew
+		ASSERT_STRICT(getShapeClassRegistry().getReferenceCount(parts[0].hitbox.baseShape) == 4);
+
+		parts[0].scale(2.0, 1.0, 1.0);
+		ASSERT_STRICT(getShapeClassRegistry().getReferenceCount(parts[0].hitbox.baseShape) == 4);
+
+		parts.resize(2);
+		ASSERT_STRICT(getShapeClassRegistry().getStatistics().getLiveClassCount() == liveBefore + 2);
+		ASSERT_STRICT(getShapeClassRegistry().getReferenceCount(parts[0].hitbox.baseShape) == 1);
+	}
+	ASSERT_STRICT(getShapeClassRegistry().getStatistics().getLiveClassCount() == liveBefore);
+}
+
+TEST_CASE(shapeClassRegistryDeletesReleasedClasses) {
+	ShapeClassRegistry registry;
+	const PolyhedronShapeClass* first = registry.acquire(Library::createBox(2.0f, 1.0f, 2.0f));
+	const PolyhedronShapeClass* second = registry.acquire(Library::createBox(2.0f, 1.0f, 2.0f));
+	ASSERT_TRUE(first == second);
+	registry.retain(first);
+	ASSERT_STRICT(registry.getReferenceCount(first) == 3);
+
+	ASSERT_FALSE(registry.release(first));
+	ASSERT_FALSE(registry.release(first));
+	ASSERT_TRUE(registry.release(first));
+
+	ShapeClassRegistryStatistics statistics = registry.getStatistics();
+	ASSERT_STRICT(statistics.classesCreated == 1);
+	ASSERT_STRICT(statistics.classesShared == 1);
+	ASSERT_STRICT(statistics.getLiveClassCount() == 0);
+
+	// builtin classes are not counted
+	ASSERT_FALSE(registry.release(&CubeClass::instance));
+	ASSERT_STRICT(registry.getReferenceCount(&CubeClass::instance) == 0);
+}
+
+static bool boundingBoxesEqual(const BoundingBox& a, const BoundingBox& b) {
+	return a.xmin == b.xmin && a.ymin == b.ymin && a.zmin == b.zmin && a.xmax == b.xmax && a.ymax == b.ymax && a.zmax == b.zmax;
+}
+
+TEST_CASE(simdKernelVariantsAgree) {
+	// vertex counts that don't fill whole blocks of 4, 8 or 16
+	Polyhedron polyhedra[]{Library::createBox(1.0f, 2.0f, 3.0f), Library::createPrism(5, 0.7f, 2.0f), Library::icosahedron, Library::createPrism(13, 1.5f, 0.3f), Library::createSphere(1.0f, 1), Library::createSphere(2.0f, 3)};
+
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> component(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> angle(-3.14f, 3.14f);
+	std::uniform_int_distribution<int64_t> coordinate(-20, 20);
+
+	const SIMDKernels& scalar = *getSIMDKernelsFor(SIMDInstructionSet::SCALAR);
+	for(int set = 1; set < static_cast<int>(SIMDInstructionSet::COUNT); set++) {
+		const SIMDKernels* kernels = getSIMDKernelsFor(static_cast<SIMDInstructionSet>(set));
+		if(kernels == nullptr) continue; // not available on this CPU
+
+		for(const Polyhedron& poly : polyhedra) {
+			// the same layout as the vertices of a TriangleMesh
+			size_t offset = (poly.vertexCount + 7) & ~7;
+			UniqueAlignedPointer<float> vertices(offset * 3, 32);
+			for(size_t i = 0; i < offset; i++) {
+				Vec3f vertex = poly.getVertex(std::min(int(i), poly.vertexCount - 1));
+				vertices[i] = vertex.x;
+				vertices[i + offset] = vertex.y;
+				vertices[i + 2 * offset] = vertex.z;
+			}
+			const float* x = vertices;
+			const float* y = vertices + offset;
+			const float* z = vertices + 2 * offset;
+
+			ASSERT_TRUE(boundingBoxesEqual(kernels->getBounds(x, y, z, poly.vertexCount), scalar.getBounds(x, y, z, poly.vertexCount)));
+			for(int i = 0; i < 100; i++) {
+				// axis aligned directions make many vertices equally far, the first one must win everywhere
+				Vec3f direction = (i < 6) ? Vec3f(float(i == 0) - float(i == 1), float(i == 2) - float(i == 3), float(i == 4) - float(i == 5)) : Vec3f(component(random), component(random), component(random));
+				ASSERT_STRICT(kernels->furthestIndexInDirection(x, y, z, poly.vertexCount, direction) == scalar.furthestIndexInDirection(x, y, z, poly.vertexCount, direction));
+
+				Mat3f referenceFrame = rotationMatrixfromEulerAngles(angle(random), angle(random), angle(random));
+				ASSERT_TRUE(boundingBoxesEqual(kernels->getTransformedBounds(x, y, z, poly.vertexCount, referenceFrame), scalar.getTransformedBounds(x, y, z, poly.vertexCount, referenceFrame)));
+			}
+		}
+
+		// small coordinates, so that children often just touch the query bounds
+		for(int i = 0; i < 1000; i++) {
+			CompiledBoundsTree::Node node;
+			for(int child = 0; child < 4; child++) {
+				int64_t* mins[3]{node.minX, node.minY, node.minZ};
+				int64_t* maxs[3]{node.maxX, node.maxY, node.maxZ};
+				for(int axis = 0; axis < 3; axis++) {
+					int64_t a = coordinate(random);
+					int64_t b = coordinate(random);
+					mins[axis][child] = std::min(a, b);
+					maxs[axis][child] = std::max(a, b);
+				}
+			}
+			Bounds query;
+			query.min = Position(Fix<32>(coordinate(random)), Fix<32>(coordinate(random)), Fix<32>(coordinate(random)));
+			query.max = query.min + Vec3Fix(Fix<32>(coordinate(random) + 20), Fix<32>(coordinate(random) + 20), Fix<32>(coordinate(random) + 20));
+			ASSERT_STRICT(kernels->intersectingChildren(node, query) == scalar.intersectingChildren(node, query));
+		}
+	}
+}
+
+// DynamicsStateArrays over one vector per component
+struct DynamicsTestState {
+	std::vector<std::vector<double>> components;
+	DynamicsStateArrays arrays;
+
+	DynamicsTestState(size_t bodyCount, std::mt19937 random) : components(36, std::vector<double>(bodyCount)) {
+		std::uniform_real_distribution<double> value(-10.0, 10.0);
+		for(std::vector<double>& component : components) {
+			for(double& v : component) v = value(random);
+		}
+		double** pointers[]{arrays.force, arrays.moment, arrays.forceResponse, arrays.momentResponse, arrays.rotation, arrays.velocity, arrays.angularVelocity, arrays.velocityStep};
+		int counts[]{3, 3, 6, 6, 9, 3, 3, 3};
+		size_t next = 0;
+		for(int i = 0; i < 8; i++) {
+			for(int c = 0; c < counts[i]; c++) {
+				pointers[i][c] = components[next++].data();
+			}
+		}
+	}
+};
+
+TEST_CASE(integrateVelocitiesVariantsAgree) {
+	// 37 bodies don't fill whole blocks, and [3, 30) starts and ends within one
+	const size_t bodyCount = 37;
+	std::mt19937 random(5);
+
+	DynamicsTestState expected(bodyCount, random);
+	getSIMDKernelsFor(SIMDInstructionSet::SCALAR)->integrateVelocities(expected.arrays, 3, 30, 0.01);
+	for(int set = 1; set < static_cast<int>(SIMDInstructionSet::COUNT); set++) {
+		const SIMDKernels* kernels = getSIMDKernelsFor(static_cast<SIMDInstructionSet>(set));
+		if(kernels == nullptr) continue; // not available on this CPU
+
+		DynamicsTestState state(bodyCount, random);
+		kernels->integrateVelocities(state.arrays, 3, 30, 0.01);
+		for(size_t c = 0; c < state.components.size(); c++) {
+			for(size_t i = 0; i < bodyCount; i++) {
+				ASSERT_STRICT(state.components[c][i] == expected.components[c][i]);
+			}
+		}
+	}
+	ASSERT_STRICT(expected.arrays.force[1][10] == 0.0);
+	ASSERT_STRICT(expected.arrays.force[1][2] != 0.0);
+}
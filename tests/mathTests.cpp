@@ -234,6 +234,88 @@ TEST_CASE(largeMatrixVectorSolve) {
 	ASSERT(solutionVector == vec);
 }
 
+TEST_CASE(largeMatrixLUDecompositionSolve) {
+	LargeMatrix<double> mat(5, 5);
+	LargeMatrix<double> solutions(3, 5);
+
+	for(int i = 0; i < 5; i++) {
+		for(int j = 0; j < 5; j++) {
+			mat.get(i, j) = fRand(-1.0, 1.0);
+		}
+		for(int c = 0; c < 3; c++) {
+			solutions.get(i, c) = fRand(-1.0, 1.0);
+		}
+	}
+
+	mat.get(0, 0) = 0;
+
+	LargeMatrix<double> rightHandSides(3, 5);
+	for(int i = 0; i < 5; i++) {
+		for(int c = 0; c < 3; c++) {
+			double total = 0.0;
+			for(int k = 0; k < 5; k++) {
+				total += mat.get(i, k) * solutions.get(k, c);
+			}
+			rightHandSides.get(i, c) = total;
+		}
+	}
+
+	LargeLUDecomposition<double> decomposition(mat);
+
+	for(int c = 0; c < 3; c++) {
+		LargeVector<double> vec(5);
+		LargeVector<double> solution(5);
+		for(int i = 0; i < 5; i++) {
+			vec[i] = rightHandSides.get(i, c);
+			solution[i] = solutions.get(i, c);
+		}
+		decomposition.solve(vec);
+		ASSERT(vec == solution);
+	}
+
+	decomposition.solve(rightHandSides);
+	for(int i = 0; i < 5; i++) {
+		for(int c = 0; c < 3; c++) {
+			ASSERT(rightHandSides.get(i, c) == solutions.get(i, c));
+		}
+	}
+}
+
+TEST_CASE(sparseBlockMatrixVectorSolve) {
+	SparseBlockMatrix<double, 3> mat(6);
+	LargeVector<double> vec(18);
+
+	for(int i = 0; i < 18; i++) {
+		vec[i] = fRand(-1.0, 1.0);
+	}
+
+	// a chain with one extra connection from the first to the last block, this creates fill-in
+	std::pair<int, int> connections[]{{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 5}, {0, 5}};
+	for(std::pair<int, int> c : connections) {
+		Mat3 block;
+		for(int i = 0; i < 9; i++) {
+			block.data[i] = fRand(-1.0, 1.0);
+		}
+		mat.setBlock(c.first, c.second, block);
+		mat.setBlock(c.second, c.first, block.transpose());
+	}
+	for(int i = 0; i < 6; i++) {
+		Mat3 block;
+		for(int j = 0; j < 9; j++) {
+			block.data[j] = fRand(-1.0, 1.0);
+		}
+		mat.setBlock(i, i, block * block.transpose() + Mat3::IDENTITY() * 10.0);
+	}
+
+	LargeVector<double> newVector = mat * vec;
+
+	SparseBlockLUDecomposition<double, 3> decomposition(mat);
+	decomposition.solve(newVector);
+
+	ASSERT(newVector == vec);
+	ASSERT_STRICT(decomposition.storedBlockCount() > mat.storedBlockCount());
+}
+
 TEST_CASE(testTaylorExpansion) {
 	FullTaylorExpansion<double, 5> testTaylor{2.0, 5.0, 2.0, 3.0, -0.7};
 
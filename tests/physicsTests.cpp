@@ -8,6 +8,7 @@
 #include <math.h>
 
 #include "../physics/world.h"
+#include "../physics/synchonizedWorld.h"
 #include "../physics/inertia.h"
 #include "../physics/misc/shapeLibrary.h"
 #include "../physics/math/linalg/trigonometry.h"
@@ -15,11 +16,15 @@
 #include "../physics/geometry/shape.h"
 #include "../physics/geometry/shapeCreation.h"
 #include "../physics/misc/gravityForce.h"
+#include "../physics/physicsProfiler.h"
 #include "../physics/constraints/motorConstraint.h"
 #include "../physics/constraints/sinusoidalPistonConstraint.h"
 #include "../physics/constraints/fixedConstraint.h"
 #include "../util/log.h"
 
+#include <set>
+#include <vector>
+
 
 #define REMAINS_CONSTANT(v) REMAINS_CONSTANT_TOLERANT(v, 0.0005)
 #define ASSERT(v) ASSERT_TOLERANT(v, 0.0005)
@@ -95,8 +100,8 @@ TEST_CASE(applyForceToRotate) {
 	Vec3 force = Vec3(0.0, 1.0, 0.0);
 
 	part.parent->mainPhysical->applyForce(relAttach, force);
-	ASSERT(part.parent->mainPhysical->totalForce == force);
-	ASSERT(part.parent->mainPhysical->totalMoment == Vec3(0.0, 0.0, 1.0));
+	ASSERT(part.parent->mainPhysical->getTotalForce() == force);
+	ASSERT(part.parent->mainPhysical->getTotalMoment() == Vec3(0.0, 0.0, 1.0));
 }
 
 TEST_CASE(momentToAngularVelocity) {
@@ -111,7 +116,7 @@ TEST_CASE(momentToAngularVelocity) {
 		p.update(0.05);
 	}
 
-	ASSERT(p.getMotion().getAngularVelocity() == moment * (50.0 * 0.05) * p.momentResponse(0, 0));
+	ASSERT(p.getMotion().getAngularVelocity() == moment * (50.0 * 0.05) * p.getMomentResponse()(0, 0));
 }
 
 TEST_CASE(rotationImpulse) {
@@ -124,8 +129,8 @@ TEST_CASE(rotationImpulse) {
 	Vec3 zMoment = Vec3(0.0, 0.0, 1.0);
 
 	{
-		veryLongBoxPhysical.totalForce = Vec3();
-		veryLongBoxPhysical.totalMoment = Vec3();
+		ASSERT(veryLongBoxPhysical.getTotalForce() == Vec3());
+		ASSERT(veryLongBoxPhysical.getTotalMoment() == Vec3());
 	}
 }
 
@@ -333,8 +338,8 @@ TEST_CASE(testMultiPartPhysicalSimple) {
 
 	ASSERT(phys.totalMass == p1.getMass() + p2.getMass());
 	ASSERT(phys.totalCenterOfMass == Vec3(0.5, 0, 0));
-	ASSERT(phys.forceResponse == phys2.forceResponse);
-	ASSERT(phys.momentResponse == phys2.momentResponse);
+	ASSERT(phys.getForceResponse() == phys2.getForceResponse());
+	ASSERT(phys.getMomentResponse() == phys2.getMomentResponse());
 }
 
 TEST_CASE(testMultiPartPhysicalRotated) {
@@ -352,8 +357,8 @@ TEST_CASE(testMultiPartPhysicalRotated) {
 
 	ASSERT(phys.totalMass == p1->getMass() + p2->getMass());
 	ASSERT(phys.totalCenterOfMass == Vec3(0.5, 0, 0));
-	ASSERT(phys.forceResponse == phys2.forceResponse);
-	ASSERT(phys.momentResponse == phys2.momentResponse);
+	ASSERT(phys.getForceResponse() == phys2.getForceResponse());
+	ASSERT(phys.getMomentResponse() == phys2.getMomentResponse());
 }
 
 TEST_CASE(testShapeNativeScaling) {
@@ -690,7 +695,7 @@ static const Motion motionOfCOM = Motion(Vec3(1.3, 0.7, -2.1), Vec3(2.1, 0.7, 3.
 
 static FullGlobalDiagnostic runDiagnosticForCFrame(MotorizedPhysical* p, const GlobalCFrame& cframeOfStart) {
 	p->setCFrame(cframeOfStart);
-	p->motionOfCenterOfMass = motionOfCOM;
+	p->setMotionOfCenterOfMass(motionOfCOM);
 
 	for(ConnectedPhysical& c : p->childPhysicals) {
 		SinusoidalPistonConstraint* constraint = dynamic_cast<SinusoidalPistonConstraint*>(c.connectionToParent.constraintWithParent.get());
@@ -751,13 +756,13 @@ TEST_CASE(angularMomentumOverLocalToGlobal) {
 	Rotation rotation = Rotation::fromEulerAngles(1.0, 0.2, -0.9);
 
 	motorPhys->setCFrame(GlobalCFrame(origin));
-	motorPhys->motionOfCenterOfMass = motionOfCOM;
+	motorPhys->setMotionOfCenterOfMass(motionOfCOM);
 
 	Vec3 firstAngularMomentumFromParts = getTotalAngularMomentumOfPhysical(motorPhys);
 	Vec3 firstAngularMomentum = motorPhys->getTotalAngularMomentum();
 
 	motorPhys->setCFrame(GlobalCFrame(origin, rotation));
-	motorPhys->motionOfCenterOfMass = localToGlobal(rotation, motionOfCOM);
+	motorPhys->setMotionOfCenterOfMass(localToGlobal(rotation, motionOfCOM));
 
 	Vec3 secondAngularMomentumFromParts = getTotalAngularMomentumOfPhysical(motorPhys);
 	Vec3 secondAngularMomentum = motorPhys->getTotalAngularMomentum();
@@ -809,7 +814,7 @@ TEST_CASE(basicAngularMomentumOfSinglePart) {
 
 	MotorizedPhysical* motorPhys = mainPart.parent->mainPhysical;
 
-	motorPhys->motionOfCenterOfMass = Motion(Vec3(2.0, 3.0, 1.0), Vec3(-1.7, 3.3, 12.0));
+	motorPhys->setMotionOfCenterOfMass(Motion(Vec3(2.0, 3.0, 1.0), Vec3(-1.7, 3.3, 12.0)));
 
 	ALLOCA_COMMotionTree(t, mainPart.parent->mainPhysical, size);
 
@@ -830,7 +835,7 @@ TEST_CASE(physicalTotalAngularMomentum) {
 	std::vector<Part> phys = producePhysical();
 	MotorizedPhysical* motorPhys = phys[0].parent->mainPhysical;
 
-	motorPhys->motionOfCenterOfMass = Motion(Vec3(2.0, 3.0, 1.0), Vec3(-1.7, 3.3, 12.0));
+	motorPhys->setMotionOfCenterOfMass(Motion(Vec3(2.0, 3.0, 1.0), Vec3(-1.7, 3.3, 12.0)));
 
 	ALLOCA_COMMotionTree(t, motorPhys, size);
 
@@ -859,7 +864,7 @@ TEST_CASE(basicMotorizedPhysicalTotalAngularMomentum) {
 
 	MotorizedPhysical* motorPhys = result[0].parent->mainPhysical;
 
-	motorPhys->motionOfCenterOfMass = Motion(Vec3(0.0, 0.0, 0.0), Vec3(-1.7, 3.3, 12.0));
+	motorPhys->setMotionOfCenterOfMass(Motion(Vec3(0.0, 0.0, 0.0), Vec3(-1.7, 3.3, 12.0)));
 
 	ALLOCA_COMMotionTree(t, motorPhys, size);
 
@@ -920,7 +925,7 @@ TEST_CASE(totalVelocityOfCenterOfMassOfPhysical) {
 	std::vector<Part> phys = producePhysical();
 	MotorizedPhysical* motorPhys = phys[0].parent->mainPhysical;
 
-	motorPhys->motionOfCenterOfMass = motionOfCOM;
+	motorPhys->setMotionOfCenterOfMass(motionOfCOM);
 
 	ASSERT(motorPhys->getMotionOfCenterOfMass().getVelocity() == getTotalMotionOfCenterOfMassOfPhysical(motorPhys));
 }
@@ -929,7 +934,7 @@ TEST_CASE(totalVelocityOfCenterOfMassOfMotorizedPhysical) {
 	std::vector<Part> phys = produceMotorizedPhysical();
 	MotorizedPhysical* motorPhys = phys[0].parent->mainPhysical;
 
-	motorPhys->motionOfCenterOfMass = motionOfCOM;
+	motorPhys->setMotionOfCenterOfMass(motionOfCOM);
 
 	ASSERT(motorPhys->getMotionOfCenterOfMass().getVelocity() == getTotalMotionOfCenterOfMassOfPhysical(motorPhys));
 }
@@ -947,7 +952,7 @@ TEST_CASE(motorizedPhysicalTotalAngularMomentum) {
 	std::vector<Part> phys = produceMotorizedPhysical();
 	MotorizedPhysical* motorPhys = phys[0].parent->mainPhysical;
 
-	motorPhys->motionOfCenterOfMass = Motion(Vec3(2.0, 3.0, 1.0), Vec3(-1.7, 3.3, 12.0));
+	motorPhys->setMotionOfCenterOfMass(Motion(Vec3(2.0, 3.0, 1.0), Vec3(-1.7, 3.3, 12.0)));
 
 	ALLOCA_COMMotionTree(t, motorPhys, size);
 
@@ -959,7 +964,7 @@ TEST_CASE(conservationOfAngularMomentum) {
 
 	MotorizedPhysical* motorPhys = phys[0].parent->mainPhysical;
 
-	motorPhys->motionOfCenterOfMass = Motion(Vec3(2.0, 3.0, 1.0), Vec3(-1.7, 3.3, 12.0));
+	motorPhys->setMotionOfCenterOfMass(Motion(Vec3(2.0, 3.0, 1.0), Vec3(-1.7, 3.3, 12.0)));
 
 	Vec3 initialAngularMomentum = motorPhys->getTotalAngularMomentum();
 
@@ -975,7 +980,7 @@ TEST_CASE(conservationOfCenterOfMass) {
 
 	MotorizedPhysical* motorPhys = phys[0].parent->mainPhysical;
 
-	motorPhys->motionOfCenterOfMass = Motion(Vec3(0.0, 0.0, 0.0), Vec3(-1.7, 3.3, 12.0));
+	motorPhys->setMotionOfCenterOfMass(Motion(Vec3(0.0, 0.0, 0.0), Vec3(-1.7, 3.3, 12.0)));
 
 	Position initialCenterOfMass = motorPhys->getCenterOfMass();
 
@@ -991,12 +996,12 @@ TEST_CASE(angularMomentumVelocityInvariance) {
 
 	MotorizedPhysical* motorPhys = phys[0].parent->mainPhysical;
 
-	motorPhys->motionOfCenterOfMass = Motion(Vec3(0.0, 0.0, 0.0), Vec3(-1.7, 3.3, 12.0));
+	motorPhys->setMotionOfCenterOfMass(Motion(Vec3(0.0, 0.0, 0.0), Vec3(-1.7, 3.3, 12.0)));
 
 	Vec3 stillAngularMomentum = motorPhys->getTotalAngularMomentum();
 	Vec3 stillAngularMomentumPartsBased = getTotalAngularMomentumOfPhysical(motorPhys);
 
-	motorPhys->motionOfCenterOfMass = Motion(Vec3(50.3, 12.3, -74.2), Vec3(-1.7, 3.3, 12.0));
+	motorPhys->setMotionOfCenterOfMass(Motion(Vec3(50.3, 12.3, -74.2), Vec3(-1.7, 3.3, 12.0)));
 
 	Vec3 movingAngularMomentum = motorPhys->getTotalAngularMomentum();
 	Vec3 movingAngularMomentumPartsBased = getTotalAngularMomentumOfPhysical(motorPhys);
@@ -1004,3 +1009,567 @@ TEST_CASE(angularMomentumVelocityInvariance) {
 	ASSERT(stillAngularMomentum == movingAngularMomentum);
 	ASSERT(stillAngularMomentumPartsBased == movingAngularMomentumPartsBased);
 }
+
+static std::vector<GlobalCFrame> simulateBoxPile(size_t threadCount) {
+	WorldPrototype world(DELTA_T);
+	world.setThreadCount(threadCount);
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+
+	Part floor(boxShape(40.0, 1.0, 40.0), GlobalCFrame(0.0, 0.0, 0.0), basicProperties);
+	world.addTerrainPart(&floor);
+
+	std::vector<Part> boxes;
+	boxes.reserve(6 * 4 * 6);
+	for(int x = 0; x < 6; x++) {
+		for(int y = 0; y < 4; y++) {
+			for(int z = 0; z < 6; z++) {
+				boxes.emplace_back(boxShape(0.9, 0.9, 0.9), GlobalCFrame(x * 1.0 + y * 0.1, 1.0 + y * 0.95, z * 1.0, Rotation::fromEulerAngles(0.1 * x, 0.05 * y, 0.1 * z)), basicProperties);
+			}
+		}
+	}
+	for(Part& box : boxes) {
+		world.addPart(&box);
+	}
+
+	for(int i = 0; i < 100; i++) {
+		world.tick();
+	}
+
+	std::vector<GlobalCFrame> result;
+	for(const Part& box : boxes) {
+		result.push_back(box.getCFrame());
+	}
+	return result;
+}
+
+TEST_CASE(parallelTickMatchesSerial) {
+	std::vector<GlobalCFrame> serial = simulateBoxPile(1);
+	std::vector<GlobalCFrame> parallel = simulateBoxPile(4);
+
+	ASSERT_STRICT(serial.size() == parallel.size());
+	for(size_t i = 0; i < serial.size(); i++) {
+		ASSERT_STRICT(serial[i].getPosition() == parallel[i].getPosition());
+		ASSERT_STRICT(serial[i].localToRelative(Vec3(1.0, 2.0, 3.0)) == parallel[i].localToRelative(Vec3(1.0, 2.0, 3.0)));
+	}
+}
+
+/*
+	A grid of boxes just sinking into the floor gives one level with far more independent colissions than handleColissions hands to a worker at once,
+	the short stacks on some of them add colissions that share a physical and have to go in later levels
+*/
+static std::vector<Motion> respondToContactGrid(size_t threadCount, long long& colissionCount) {
+	WorldPrototype world(DELTA_T);
+	world.setThreadCount(threadCount);
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+
+	Part floor(boxShape(40.0, 1.0, 40.0), GlobalCFrame(0.0, 0.0, 0.0), basicProperties);
+	world.addTerrainPart(&floor);
+
+	std::vector<Part> boxes;
+	boxes.reserve(8 * 8 + 8 * 2);
+	for(int x = 0; x < 8; x++) {
+		for(int z = 0; z < 8; z++) {
+			boxes.emplace_back(boxShape(1.0, 1.0, 1.0), GlobalCFrame(x * 1.5 - 6.0, 0.99, z * 1.5 - 6.0, Rotation::fromEulerAngles(0.0, 0.1 * x + 0.05 * z, 0.0)), basicProperties);
+		}
+	}
+	for(int x = 0; x < 8; x++) {
+		for(int y = 1; y <= 2; y++) {
+			boxes.emplace_back(boxShape(1.0, 1.0, 1.0), GlobalCFrame(x * 1.5 - 6.0 + 0.05 * y, 0.99 + y * 0.99, -6.0, Rotation::fromEulerAngles(0.0, 0.1 * x + 0.02 * y, 0.0)), basicProperties);
+		}
+	}
+	for(Part& box : boxes) {
+		world.addPart(&box);
+	}
+
+	intersectionStatistics.clearCurrentTally();
+	world.tick();
+	colissionCount = intersectionStatistics.history.sum()[static_cast<size_t>(IntersectionResult::COLISSION)];
+
+	std::vector<Motion> result;
+	for(Part& box : boxes) {
+		result.push_back(box.parent->mainPhysical->getMotionOfCenterOfMass());
+	}
+	return result;
+}
+
+TEST_CASE(parallelColissionLevelsMatchSerial) {
+	long long serialColissions;
+	long long parallelColissions;
+	std::vector<Motion> serial = respondToContactGrid(1, serialColissions);
+	std::vector<Motion> parallel = respondToContactGrid(4, parallelColissions);
+
+	// all 64 boxes on the floor touch it, 32 is COLISSION_RESPONSE_CHUNK_SIZE
+	ASSERT_TRUE(serialColissions >= 64 + 16);
+	ASSERT_TRUE(serialColissions > 32 * 2);
+	ASSERT_STRICT(serialColissions == parallelColissions);
+	ASSERT_STRICT(serial.size() == parallel.size());
+	for(size_t i = 0; i < serial.size(); i++) {
+		ASSERT_STRICT(serial[i].getVelocity() == parallel[i].getVelocity());
+		ASSERT_STRICT(serial[i].getAngularVelocity() == parallel[i].getAngularVelocity());
+	}
+}
+
+static std::vector<GlobalCFrame> simulateSpreadOutMotorizedPhysicals(size_t threadCount) {
+	WorldPrototype world(DELTA_T);
+	world.setThreadCount(threadCount);
+
+	// far enough apart to never touch, so only updatePhysicals is at work
+	std::vector<std::vector<Part>> physicals;
+	physicals.reserve(40);
+	for(int i = 0; i < 40; i++) {
+		std::vector<Part>& parts = physicals.emplace_back(produceMotorizedPhysical());
+		MotorizedPhysical* motorPhys = parts[0].parent->mainPhysical;
+		motorPhys->setCFrame(GlobalCFrame(i * 30.0, 0.0, 0.0, Rotation::fromEulerAngles(0.1 * i, 0.2, -0.3)));
+		motorPhys->setMotionOfCenterOfMass(Motion(Vec3(0.3 * i, 1.0, -0.5), Vec3(0.7, -0.2 * i, 1.1)));
+		world.addPart(&parts[0]);
+	}
+
+	for(int i = 0; i < 50; i++) {
+		world.tick();
+	}
+
+	std::vector<GlobalCFrame> result;
+	for(const std::vector<Part>& parts : physicals) {
+		for(const Part& part : parts) {
+			result.push_back(part.getCFrame());
+		}
+	}
+	return result;
+}
+
+TEST_CASE(parallelUpdateMatchesSerial) {
+	std::vector<GlobalCFrame> serial = simulateSpreadOutMotorizedPhysicals(1);
+	std::vector<GlobalCFrame> parallel = simulateSpreadOutMotorizedPhysicals(3);
+
+	ASSERT_STRICT(serial.size() == parallel.size());
+	for(size_t i = 0; i < serial.size(); i++) {
+		ASSERT_STRICT(serial[i].getPosition() == parallel[i].getPosition());
+		ASSERT_STRICT(serial[i].localToRelative(Vec3(1.0, 2.0, 3.0)) == parallel[i].localToRelative(Vec3(1.0, 2.0, 3.0)));
+	}
+}
+
+TEST_CASE(worldUpdateMatchesPhysicalUpdate) {
+	WorldPrototype world(DELTA_T);
+	std::vector<Part> inWorld = produceMotorizedPhysical();
+	std::vector<Part> alone = produceMotorizedPhysical();
+	MotorizedPhysical* worldPhys = inWorld[0].parent->mainPhysical;
+	MotorizedPhysical* alonePhys = alone[0].parent->mainPhysical;
+	for(MotorizedPhysical* phys : {worldPhys, alonePhys}) {
+		phys->setCFrame(GlobalCFrame(1.0, 2.0, 3.0, Rotation::fromEulerAngles(0.3, -0.7, 1.1)));
+		phys->setMotionOfCenterOfMass(Motion(Vec3(0.5, -1.0, 2.0), Vec3(-0.7, 0.2, 1.3)));
+	}
+	world.addPart(&inWorld[0]);
+	for(int i = 0; i < 20; i++) {
+		for(MotorizedPhysical* phys : {worldPhys, alonePhys}) {
+			phys->applyForce(Vec3(0.3, 0.1, -0.2), Vec3(1.0 * i, -3.0, 0.5));
+			phys->applyMoment(Vec3(0.2, -0.1 * i, 0.7));
+		}
+		world.tick();
+		alonePhys->update(DELTA_T);
+	}
+
+	for(size_t i = 0; i < inWorld.size(); i++) {
+		ASSERT_STRICT(inWorld[i].getPosition() == alone[i].getPosition());
+		ASSERT_STRICT(inWorld[i].getCFrame().localToRelative(Vec3(1.0, 2.0, 3.0)) == alone[i].getCFrame().localToRelative(Vec3(1.0, 2.0, 3.0)));
+	}
+	ASSERT_STRICT(worldPhys->getVelocityOfCenterOfMass() == alonePhys->getVelocityOfCenterOfMass());
+	ASSERT_STRICT(worldPhys->getAngularVelocityOfCenterOfMass() == alonePhys->getAngularVelocityOfCenterOfMass());
+}
+
+TEST_CASE(storedSinglePartBodiesMatchPhysicalUpdate) {
+	// enough bodies for whole SIMD blocks and a remainder, the removed one has the last body moved into its place in the store
+	const int bodyCount = 11;
+	const int removedBody = 3;
+	WorldPrototype world(DELTA_T);
+	std::vector<Part> inWorld;
+	std::vector<Part> alone;
+	inWorld.reserve(bodyCount);
+	alone.reserve(bodyCount);
+	for(int i = 0; i < bodyCount; i++) {
+		GlobalCFrame cframe(i * 10.0, 0.0, 0.0, Rotation::fromEulerAngles(0.2 * i, -0.4, 0.1 * i));
+		Motion motion(Vec3(0.1 * i, -0.5, 1.0), Vec3(0.3, 0.05 * i, -0.8));
+		for(std::vector<Part>* parts : {&inWorld, &alone}) {
+			Part& part = parts->emplace_back(boxShape(1.0 + 0.1 * i, 0.5, 2.0), cframe, basicProperties);
+			part.ensureHasParent();
+			part.parent->mainPhysical->setMotionOfCenterOfMass(motion);
+		}
+		world.addPart(&inWorld[i]);
+	}
+	// what the destructor of a part in a world does
+	inWorld[removedBody].parent->removePart(&inWorld[removedBody]);
+	ASSERT_STRICT(world.physicals[removedBody] == inWorld[bodyCount - 1].parent->mainPhysical);
+	ASSERT_STRICT(world.physicals[removedBody]->dynamicsIndex == removedBody);
+	ASSERT_STRICT(inWorld[bodyCount - 1].parent->mainPhysical->getVelocityOfCenterOfMass() == alone[bodyCount - 1].parent->mainPhysical->getVelocityOfCenterOfMass());
+
+	for(int t = 0; t < 20; t++) {
+		for(int i = 0; i < bodyCount; i++) {
+			if(i == removedBody) continue;
+			for(std::vector<Part>* parts : {&inWorld, &alone}) {
+				MotorizedPhysical* phys = (*parts)[i].parent->mainPhysical;
+				phys->applyForce(Vec3(0.2, -0.1 * i, 0.3), Vec3(1.0 * t, -2.0 + i, 0.5));
+				phys->applyMoment(Vec3(0.1 * i, -0.1 * t, 0.4));
+			}
+		}
+		world.tick();
+		for(int i = 0; i < bodyCount; i++) {
+			if(i == removedBody) continue;
+			alone[i].parent->mainPhysical->update(DELTA_T);
+		}
+	}
+
+	for(int i = 0; i < bodyCount; i++) {
+		if(i == removedBody) continue;
+		MotorizedPhysical* worldPhys = inWorld[i].parent->mainPhysical;
+		MotorizedPhysical* alonePhys = alone[i].parent->mainPhysical;
+		ASSERT_STRICT(inWorld[i].getPosition() == alone[i].getPosition());
+		ASSERT_STRICT(inWorld[i].getCFrame().localToRelative(Vec3(1.0, 2.0, 3.0)) == alone[i].getCFrame().localToRelative(Vec3(1.0, 2.0, 3.0)));
+		ASSERT_STRICT(worldPhys->getVelocityOfCenterOfMass() == alonePhys->getVelocityOfCenterOfMass());
+		ASSERT_STRICT(worldPhys->getAngularVelocityOfCenterOfMass() == alonePhys->getAngularVelocityOfCenterOfMass());
+		ASSERT_STRICT(worldPhys->getTotalForce() == Vec3(0.0, 0.0, 0.0));
+	}
+}
+
+// returns true if a stack of boxes is still standing after 300 ticks
+static bool sequentialImpulseStackStaysUp(PositionCorrection positionCorrection, double deltaT, size_t substepCount, const PartProperties& properties) {
+	WorldPrototype world(deltaT);
+	world.contactSolverSettings.type = ContactSolverType::SEQUENTIAL_IMPULSE;
+	world.contactSolverSettings.positionCorrection = positionCorrection;
+	world.substepSettings.substepCount = substepCount;
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+
+	Part floor(boxShape(40.0, 1.0, 40.0), GlobalCFrame(0.0, 0.0, 0.0), properties);
+	world.addTerrainPart(&floor);
+
+	std::vector<Part> boxes;
+	boxes.reserve(5);
+	for(int i = 0; i < 5; i++) {
+		boxes.emplace_back(boxShape(1.0, 1.0, 1.0), GlobalCFrame(0.02 * i, 1.0 + i * 1.0, 0.0), properties);
+	}
+	for(Part& box : boxes) {
+		world.addPart(&box);
+	}
+
+	for(int i = 0; i < 300; i++) {
+		world.tick();
+	}
+
+	for(int i = 0; i < 5; i++) {
+		Vec3 offset = boxes[i].getPosition() - Position(0.02 * i, 1.0 + i * 1.0, 0.0);
+		if(std::abs(offset.x) > 0.1 || std::abs(offset.z) > 0.1 || offset.y < -0.05 || offset.y > 0.01) return false;
+		if(length(boxes[i].parent->mainPhysical->getVelocityOfCenterOfMass()) > 0.05) return false;
+	}
+	return true;
+}
+
+TEST_CASE(sequentialImpulseSolverStacksBoxes) {
+	ASSERT_TRUE(sequentialImpulseStackStaysUp(PositionCorrection::BAUMGARTE, DELTA_T * 2, 1, basicProperties));
+	ASSERT_TRUE(sequentialImpulseStackStaysUp(PositionCorrection::SPLIT_IMPULSE, DELTA_T * 2, 1, basicProperties));
+}
+
+TEST_CASE(substepsStackBoxesAtLargerDeltaT) {
+	// new contact points are only found once per tick, with too little friction the boxes slide off the ones they have
+	PartProperties roughProperties{1.0, 0.7, 0.3};
+	ASSERT_TRUE(sequentialImpulseStackStaysUp(PositionCorrection::BAUMGARTE, DELTA_T * 4, 4, roughProperties));
+	ASSERT_TRUE(sequentialImpulseStackStaysUp(PositionCorrection::SPLIT_IMPULSE, DELTA_T * 4, 4, roughProperties));
+}
+
+static std::vector<GlobalCFrame> simulateTumblingBoxes(double deltaT, size_t substepCount, size_t tickCount) {
+	WorldPrototype world(deltaT);
+	world.substepSettings.substepCount = substepCount;
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+
+	std::vector<Part> boxes;
+	boxes.reserve(3);
+	for(int i = 0; i < 3; i++) {
+		boxes.emplace_back(boxShape(1.0, 0.5 + i * 0.3, 2.0), GlobalCFrame(i * 10.0, 0.0, 0.0), basicProperties);
+	}
+	for(Part& box : boxes) {
+		world.addPart(&box);
+		box.parent->mainPhysical->setMotionOfCenterOfMass(Motion(Vec3(1.0, 5.0, -2.0), Vec3(0.3, 2.0, -1.1)));
+	}
+
+	for(size_t i = 0; i < tickCount; i++) {
+		world.tick();
+	}
+
+	std::vector<GlobalCFrame> result;
+	for(const Part& box : boxes) {
+		result.push_back(box.getCFrame());
+	}
+	return result;
+}
+
+TEST_CASE(substepsMatchShorterTicks) {
+	std::vector<GlobalCFrame> substepped = simulateTumblingBoxes(DELTA_T, 4, 50);
+	std::vector<GlobalCFrame> shortTicks = simulateTumblingBoxes(DELTA_T / 4, 1, 200);
+
+	for(size_t i = 0; i < substepped.size(); i++) {
+		ASSERT_STRICT(substepped[i].getPosition() == shortTicks[i].getPosition());
+		ASSERT_STRICT(substepped[i].localToRelative(Vec3(1.0, 2.0, 3.0)) == shortTicks[i].localToRelative(Vec3(1.0, 2.0, 3.0)));
+	}
+}
+
+TEST_CASE(adaptiveSubstepsFollowSpeed) {
+	WorldPrototype world(DELTA_T);
+	world.substepSettings.adaptive = true;
+	world.substepSettings.maxSubsteps = 8;
+	world.substepSettings.maxMovementPerSubstep = 0.1;
+
+	Part box(boxShape(1.0, 1.0, 1.0), GlobalCFrame(0.0, 0.0, 0.0), basicProperties);
+	world.addPart(&box);
+	MotorizedPhysical* boxPhysical = box.parent->mainPhysical;
+
+	world.tick();
+	ASSERT_STRICT(world.getLastSubstepCount() == 1);
+
+	// moves 0.25 per tick
+	boxPhysical->setMotionOfCenterOfMass(Motion(Vec3(25.0, 0.0, 0.0), Vec3(0.0, 0.0, 0.0)));
+	world.tick();
+	ASSERT_STRICT(world.getLastSubstepCount() == 3);
+
+	boxPhysical->setMotionOfCenterOfMass(Motion(Vec3(1000.0, 0.0, 0.0), Vec3(0.0, 0.0, 0.0)));
+	world.tick();
+	ASSERT_STRICT(world.getLastSubstepCount() == 8);
+}
+
+// World<Part> would declare onPartAdded twice
+struct SynchronizedTestPart : public Part {
+	using Part::Part;
+};
+
+TEST_CASE(synchronizedWorldMovesAndHoldsUpParts) {
+	for(ContactSolverType type : {ContactSolverType::PENALTY, ContactSolverType::SEQUENTIAL_IMPULSE}) {
+		SynchronizedWorld<SynchronizedTestPart> world(DELTA_T);
+		world.contactSolverSettings.type = type;
+		world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+
+		SynchronizedTestPart floor(boxShape(40.0, 1.0, 40.0), GlobalCFrame(0.0, 0.0, 0.0), basicProperties);
+		world.addTerrainPart(&floor);
+
+		SynchronizedTestPart resting(boxShape(1.0, 1.0, 1.0), GlobalCFrame(0.0, 1.0, 0.0), basicProperties);
+		SynchronizedTestPart falling(boxShape(1.0, 1.0, 1.0), GlobalCFrame(5.0, 3.0, 0.0), basicProperties);
+		world.addPart(&resting);
+		world.addPart(&falling);
+
+		world.tick();
+		ASSERT_TRUE(falling.getPosition().y < 3.0);
+		for(int i = 0; i < 300; i++) {
+			world.tick();
+		}
+		// landed on the floor rather than falling through it
+		ASSERT_TOLERANT(double(falling.getPosition().y) == 1.0, 0.05);
+		ASSERT_TOLERANT(double(resting.getPosition().y) == 1.0, 0.05);
+	}
+}
+
+TEST_CASE(restingPartFallsAsleepAndWakesUp) {
+	WorldPrototype world(DELTA_T);
+	world.sleepSettings.ticksUntilSleep = 20;
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+
+	Part floor(boxShape(40.0, 1.0, 40.0), GlobalCFrame(0.0, 0.0, 0.0), basicProperties);
+	world.addTerrainPart(&floor);
+
+	Part box(boxShape(1.0, 1.0, 1.0), GlobalCFrame(0.0, 1.0, 0.0), basicProperties);
+	world.addPart(&box);
+	MotorizedPhysical* boxPhysical = box.parent->mainPhysical;
+
+	for(int i = 0; i < 500 && !boxPhysical->isSleeping; i++) {
+		world.tick();
+	}
+	ASSERT_TRUE(boxPhysical->isSleeping);
+
+	Position restingPosition = box.getPosition();
+	for(int i = 0; i < 10; i++) {
+		world.tick();
+	}
+	ASSERT_STRICT(box.getPosition() == restingPosition);
+
+	box.setCFrame(GlobalCFrame(0.0, 3.0, 0.0));
+	ASSERT_FALSE(boxPhysical->isSleeping);
+	world.tick();
+	ASSERT_TRUE(box.getPosition().y < 3.0);
+
+	for(int i = 0; i < 500 && !boxPhysical->isSleeping; i++) {
+		world.tick();
+	}
+	ASSERT_TRUE(boxPhysical->isSleeping);
+
+	boxPhysical->applyForceAtCenterOfMass(Vec3(0.0, 1000.0, 0.0));
+	ASSERT_FALSE(boxPhysical->isSleeping);
+	world.tick();
+	ASSERT_FALSE(boxPhysical->isSleeping);
+}
+
+TEST_CASE(touchingASleepingStackWakesAllOfIt) {
+	WorldPrototype world(DELTA_T);
+	world.sleepSettings.ticksUntilSleep = 20;
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+
+	Part floor(boxShape(40.0, 1.0, 40.0), GlobalCFrame(0.0, 0.0, 0.0), basicProperties);
+	world.addTerrainPart(&floor);
+
+	Part bottom(boxShape(1.0, 1.0, 1.0), GlobalCFrame(0.0, 1.0, 0.0), basicProperties);
+	Part top(boxShape(1.0, 1.0, 1.0), GlobalCFrame(0.0, 2.0, 0.0), basicProperties);
+	world.addPart(&bottom);
+	world.addPart(&top);
+	MotorizedPhysical* bottomPhysical = bottom.parent->mainPhysical;
+	MotorizedPhysical* topPhysical = top.parent->mainPhysical;
+
+	for(int i = 0; i < 1000 && !(bottomPhysical->isSleeping && topPhysical->isSleeping); i++) {
+		world.tick();
+	}
+	ASSERT_TRUE(bottomPhysical->isSleeping && topPhysical->isSleeping);
+	Position restingBottom = bottom.getPosition();
+	Position restingTop = top.getPosition();
+
+	// a box that only touches the top one, the bottom one must be woken through it within the same tick
+	Part dropped(boxShape(1.0, 1.0, 1.0), GlobalCFrame(restingTop + Vec3(0.0, 0.99, 0.0)), basicProperties);
+	world.addPart(&dropped);
+	world.tick();
+	ASSERT_FALSE(topPhysical->isSleeping);
+	ASSERT_FALSE(bottomPhysical->isSleeping);
+
+	for(int i = 0; i < 10; i++) {
+		world.tick();
+	}
+	ASSERT_FALSE(topPhysical->isSleeping);
+	ASSERT_FALSE(bottomPhysical->isSleeping);
+	// held up by the floor and by each other, the extra weight only presses them in a little further
+	ASSERT_TRUE(bottom.getPosition().y > restingBottom.y - 0.03);
+	ASSERT_TRUE(top.getPosition().y > restingTop.y - 0.03);
+}
+
+/*
+	Checks that every node of the tree contains everything below it, and with exact == true that it is no bigger than that
+*/
+static bool treeBoundsAreValid(const TreeNode& node, bool exact) {
+	if(node.isLeafNode()) {
+		Bounds partBounds = static_cast<const Part*>(node.object)->getBounds();
+		return exact ? node.bounds == partBounds : node.bounds.contains(partBounds);
+	}
+	Bounds unionOfChildren = node.subTrees[0].bounds;
+	for(int i = 0; i < node.nodeCount; i++) {
+		if(!treeBoundsAreValid(node.subTrees[i], exact)) return false;
+		unionOfChildren = unionOfBounds(unionOfChildren, node.subTrees[i].bounds);
+	}
+	return exact ? node.bounds == unionOfChildren : node.bounds.contains(unionOfChildren);
+}
+
+// returns false as soon as the tree bounds are invalid after a tick
+static bool simulateTreeBoundsScene(double boundsMargin) {
+	WorldPrototype world(DELTA_T);
+	world.boundsMarginSettings.margin = boundsMargin;
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+
+	Part floor(boxShape(40.0, 1.0, 40.0), GlobalCFrame(0.0, 0.0, 0.0), basicProperties);
+	world.addTerrainPart(&floor);
+
+	std::vector<Part> boxes;
+	boxes.reserve(20);
+	for(int i = 0; i < 10; i++) {
+		boxes.emplace_back(boxShape(0.9, 0.9, 0.9), GlobalCFrame(i * 1.5, 0.95, 0.0), basicProperties);
+		boxes.emplace_back(boxShape(0.5, 0.5, 0.5), GlobalCFrame(i * 1.5, 3.0 + i * 0.3, 0.2, Rotation::fromEulerAngles(0.3, 0.1 * i, 0.0)), basicProperties);
+	}
+	for(Part& box : boxes) {
+		world.addPart(&box);
+	}
+	Part attachedPart(sphereShape(0.3), boxes[1], CFrame(0.0, 0.5, 0.0), basicProperties);
+
+	for(int i = 0; i < 100; i++) {
+		world.tick();
+		if(!treeBoundsAreValid(world.objectTree.rootNode, boundsMargin == 0.0)) return false;
+	}
+	return true;
+}
+
+TEST_CASE(treeBoundsFollowMovedPhysicals) {
+	ASSERT_TRUE(simulateTreeBoundsScene(0.0));
+}
+
+TEST_CASE(enlargedTreeBoundsContainMovedPhysicals) {
+	ASSERT_TRUE(simulateTreeBoundsScene(0.1));
+}
+
+using PartPairSet = std::set<std::pair<const Part*, const Part*>>;
+
+static std::pair<const Part*, const Part*> orderedPair(const Part* a, const Part* b) {
+	return (a < b) ? std::make_pair(a, b) : std::make_pair(b, a);
+}
+
+static void collectLeaves(const TreeNode& node, std::vector<const TreeNode*>& leaves) {
+	if(node.isLeafNode()) {
+		if(node.object != nullptr) leaves.push_back(&node);
+	} else {
+		for(const TreeNode& subNode : node) {
+			collectLeaves(subNode, leaves);
+		}
+	}
+}
+
+// every pair of overlapping leaves, found by testing all of them against each other
+static void findOverlappingLeavesBruteForce(const WorldPrototype& world, PartPairSet& objectPairs, PartPairSet& terrainPairs) {
+	std::vector<const TreeNode*> objects;
+	std::vector<const TreeNode*> terrain;
+	collectLeaves(world.objectTree.rootNode, objects);
+	collectLeaves(world.terrainTree.rootNode, terrain);
+	for(size_t i = 0; i < objects.size(); i++) {
+		const Part* a = static_cast<const Part*>(objects[i]->object);
+		for(size_t j = i + 1; j < objects.size(); j++) {
+			const Part* b = static_cast<const Part*>(objects[j]->object);
+			if(a->parent->mainPhysical != b->parent->mainPhysical && intersects(objects[i]->bounds, objects[j]->bounds)) {
+				objectPairs.insert(orderedPair(a, b));
+			}
+		}
+		for(const TreeNode* t : terrain) {
+			if(intersects(objects[i]->bounds, t->bounds)) {
+				terrainPairs.insert(orderedPair(a, static_cast<const Part*>(t->object)));
+			}
+		}
+	}
+}
+
+static PartPairSet toPairSet(const std::vector<OverlappingPair>& pairs) {
+	PartPairSet result;
+	for(const OverlappingPair& pair : pairs) {
+		result.insert(orderedPair(pair.p1, pair.p2));
+	}
+	return result;
+}
+
+TEST_CASE(pairCacheMatchesOverlappingLeaves) {
+	WorldPrototype world(DELTA_T);
+	world.boundsMarginSettings.margin = 0.1;
+	world.addExternalForce(new DirectionalGravity(Vec3(0, -10, 0)));
+
+	Part floor(boxShape(40.0, 1.0, 40.0), GlobalCFrame(0.0, 0.0, 0.0), basicProperties);
+	world.addTerrainPart(&floor);
+
+	std::vector<Part> boxes;
+	boxes.reserve(20);
+	for(int i = 0; i < 10; i++) {
+		boxes.emplace_back(boxShape(0.9, 0.9, 0.9), GlobalCFrame(i * 0.8, 0.95, 0.0), basicProperties);
+		boxes.emplace_back(boxShape(0.5, 0.5, 0.5), GlobalCFrame(i * 0.8, 3.0 + i * 0.3, 0.2, Rotation::fromEulerAngles(0.3, 0.1 * i, 0.0)), basicProperties);
+	}
+	for(Part& box : boxes) {
+		world.addPart(&box);
+	}
+	Part attachedPart(sphereShape(0.3), boxes[1], CFrame(0.0, 0.5, 0.0), basicProperties);
+	Part droppedPart(boxShape(0.7, 0.7, 0.7), GlobalCFrame(2.0, 2.0, 0.1), basicProperties);
+
+	for(int i = 0; i < 100; i++) {
+		if(i == 50) {
+			world.addPart(&droppedPart);
+		}
+		// the broad phase sees the trees as they are at the start of the tick
+		PartPairSet expectedObjectPairs;
+		PartPairSet expectedTerrainPairs;
+		findOverlappingLeavesBruteForce(world, expectedObjectPairs, expectedTerrainPairs);
+		world.tick();
+		ASSERT_TRUE(toPairSet(world.getPairCache().getObjectPairs()) == expectedObjectPairs);
+		ASSERT_TRUE(toPairSet(world.getPairCache().getTerrainPairs()) == expectedTerrainPairs);
+	}
+	// the first tick and adding a part need a full broad phase, everything else only looks at the changed leaves
+	ASSERT_TRUE(world.getPairCache().rebuildCount == 2);
+	ASSERT_TRUE(world.getPairCache().updateCount == 98);
+}